@@ -0,0 +1,112 @@
+#include "test_support.hpp"
+#include "virtual_scheduler.hpp"
+
+#include <memory>
+#include <random>
+
+using namespace nrf_test;
+
+namespace {
+    constexpr size_t max_nodes = 6;
+    constexpr int64_t duration_us = 2 * 1000 * 1000;
+    constexpr uint32_t mean_gap_us = 3000;     // idle time between a node's packets, uniform 0 - 2x
+
+    constexpr int ce_pins[max_nodes] = { 25, 26, 27, 32, 33, 34 };
+    constexpr int csn_pins[max_nodes] = { 5, 15, 21, 22, 23, 2 };
+    constexpr int irq_pins[max_nodes] = { 16, 17, 18, 19, 35, 36 };
+
+    struct node_T{
+        std::unique_ptr<nrf_emu::radio> emulated;
+        std::unique_ptr<spi_object> spi;
+        std::unique_ptr<NRF24> radio;
+    };
+
+    struct result_T{
+        uint32_t offered;       // transmit_data calls
+        uint32_t delivered;     // frames the sink took in
+        uint32_t collisions;
+        uint32_t deferrals;
+    };
+
+    /**
+     * @brief nodes sending 32 byte packets to one sink on a shared channel for duration_us, blind or listening first
+     */
+    result_T simulate(size_t nodes, bool listen_before_talk){
+        nrf_emu::air medium;
+        nrf_emu::radio sink(medium, -1, -1);
+        configure_peer(sink, true);
+        esp_host::seed_random(0x2401 + static_cast<uint32_t>(nodes));
+
+        virtual_scheduler scheduler;
+        spi_config_T config;
+        config.clock_speed_hz = 8 * 1000 * 1000;
+        spi_bus bus(config);
+
+        node_T node[max_nodes];
+        for (size_t i = 0; i < nodes; ++i) {
+            node[i].emulated = std::make_unique<nrf_emu::radio>(medium, csn_pins[i], ce_pins[i], irq_pins[i]);
+            spi_config_T device = config;
+            device.csn_pin = csn_pins[i];
+            node[i].spi = std::make_unique<spi_object>(bus, device);
+            const Pins_T pins = { static_cast<gpio_num_t>(ce_pins[i]), static_cast<gpio_num_t>(csn_pins[i]),
+                GPIO_NUM_14, GPIO_NUM_12, GPIO_NUM_13, static_cast<gpio_num_t>(irq_pins[i]) };
+            node[i].radio = std::make_unique<NRF24>(*node[i].spi, pins, 32, scheduler.clock());
+            csma_config_T csma;
+            csma.enabled = listen_before_talk;
+            csma.transmit_when_exhausted = true;
+            node[i].radio->set_csma(csma);
+        }
+
+        result_T result = {};
+        const int64_t end_us = esp_host::now_us() + duration_us;
+        std::vector<std::function<void()>> tasks;
+        for (size_t i = 0; i < nodes; ++i) {
+            tasks.push_back([&, i]{
+                std::mt19937 gaps(static_cast<uint32_t>(i + 1));
+                std::uniform_int_distribution<uint32_t> gap_us(0, 2 * mean_gap_us);
+                const radio_clock_T clock = node[i].radio->timing().clock();
+                u8 payload[32] = { static_cast<u8>(i) };
+                while (esp_host::now_us() < end_us) {
+                    clock.delay_us(gap_us(gaps), clock.context);
+                    node[i].radio->transmit_data(payload, sizeof(payload));
+                    result.offered++;
+                    while (sink.rx_fifo_count() != 0) {
+                        peer_receive(sink);
+                    }
+                }
+            });
+        }
+        scheduler.run(tasks);
+
+        result.delivered = sink.counters().frames_received;
+        result.collisions = medium.counters().collisions;
+        for (size_t i = 0; i < nodes; ++i) {
+            result.deferrals += node[i].radio->csma_stats().deferrals;
+        }
+        return result;
+    }
+}
+
+/**
+ * Nodes sharing one channel at 250 kbps, each sending to the same sink after a random idle time. Blind transmits
+ * collide once the offered load nears the channel capacity; listen-before-talk defers instead. Drivers run on
+ * their own threads, interleaved in virtual time by virtual_scheduler.
+ */
+int main(){
+    std::printf("250 kbps, 32 byte payloads, no auto-ack, %lld ms, mean idle %u us per node\n",
+        static_cast<long long>(duration_us / 1000), mean_gap_us);
+    std::printf("%-6s %-6s %10s %10s %11s %10s %12s\n", "nodes", "mode", "offered", "delivered", "collisions", "deferrals", "delivered/s");
+    for (size_t nodes = 2; nodes <= max_nodes; nodes += 2) {
+        const result_T blind = simulate(nodes, false);
+        const result_T csma = simulate(nodes, true);
+        for (const result_T* r : { &blind, &csma }) {
+            std::printf("%-6zu %-6s %10u %10u %11u %10u %12.0f\n", nodes, r == &blind ? "blind" : "LBT", r->offered,
+                r->delivered, r->collisions, r->deferrals, r->delivered * 1000000.0 / duration_us);
+        }
+        NRF_CHECK(csma.collisions < blind.collisions);
+        if (nodes >= 4) {
+            NRF_CHECK(csma.delivered > blind.delivered);
+        }
+    }
+    return 0;
+}
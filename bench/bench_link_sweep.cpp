@@ -0,0 +1,118 @@
+#include "test_support.hpp"
+#include "virtual_scheduler.hpp"
+
+#include <atomic>
+
+using namespace nrf_test;
+
+namespace {
+    constexpr uint16_t packets_per_setting = 100;
+    constexpr u8 payload_length = 32;
+    constexpr double loss = 0.2;
+
+    u8 rf_setup_for(Data_Rate rate){
+        switch (rate) {
+            case Data_Rate::Rate_250kbps: return 0x26;
+            case Data_Rate::Rate_1Mbps: return 0x06;
+            default: return 0x0E;
+        }
+    }
+
+    // the receiving end only has to follow the data rate, PA, ARD and ARC are transmitter settings
+    bool switch_peer(const rf_settings_T& settings, void* context){
+        command(*static_cast<nrf_emu::radio*>(context), {0x26, rf_setup_for(settings.data_rate)});
+        return true;
+    }
+
+    const char* rate_name(Data_Rate rate){
+        switch (rate) {
+            case Data_Rate::Rate_250kbps: return "250k";
+            case Data_Rate::Rate_1Mbps: return "1M";
+            default: return "2M";
+        }
+    }
+}
+
+/**
+ * NRF24::sweep_link over an emulated link with 20% loss each way: every data rate with a short and a long
+ * retransmit budget, plus an ARD the driver rejects. A raw peer acknowledges in hardware, its RX FIFO is drained
+ * by a second task, and the sweep's peer hook moves it between rates.
+ */
+int main(){
+    nrf_emu::air medium({ loss, 0, 11 });
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer(medium, -1, -1);
+    configure_peer(peer, true);
+    command(peer, {0x21, 0x01});
+
+    virtual_scheduler scheduler;
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32, scheduler.clock());
+    pipe_config_T pipe;
+    pipe.address = { 0x03, 0x03, 0x03 };
+    pipe.auto_ack = true;
+    NRF_CHECK(radio.configure_pipe(0, pipe));
+    const rf_settings_T original = radio.rf_settings();
+    const u8 original_peer_rf_setup = peer.reg(0x06);
+
+    const rf_settings_T settings[] = {
+        { Data_Rate::Rate_250kbps, PA_Level::Max_0dBm, 1500, 3 },
+        { Data_Rate::Rate_250kbps, PA_Level::Max_0dBm, 1500, 15 },
+        { Data_Rate::Rate_1Mbps, PA_Level::Max_0dBm, 500, 3 },
+        { Data_Rate::Rate_1Mbps, PA_Level::Max_0dBm, 500, 15 },
+        { Data_Rate::Rate_2Mbps, PA_Level::Max_0dBm, 500, 3 },
+        { Data_Rate::Rate_2Mbps, PA_Level::Max_0dBm, 500, 15 },
+        { Data_Rate::Rate_2Mbps, PA_Level::Max_0dBm, 300, 3 },    // not a multiple of 250 us, rejected
+    };
+    constexpr size_t count = sizeof(settings) / sizeof(settings[0]);
+    link_sweep_result_T results[count] = {};
+
+    size_t measured = 0;
+    std::atomic<bool> finished{false};
+    auto sweep_task = [&]{
+        measured = radio.sweep_link(settings, count, results, packets_per_setting, payload_length, switch_peer, &peer);
+        finished = true;
+    };
+    auto drain_task = [&]{
+        const radio_clock_T clock = scheduler.clock();
+        while (!finished) {
+            command(peer, {0xE2});
+            command(peer, {0x27, 0x40});
+            clock.delay_us(200, clock.context);
+        }
+    };
+    scheduler.run({ sweep_task, drain_task });
+
+    std::printf("%u packets of %u bytes per setting, %.0f%% loss each way\n", packets_per_setting, payload_length, loss * 100);
+    std::printf("%-5s %5s %4s %9s %8s %8s %8s %8s %8s %10s\n", "rate", "ARD", "ARC", "delivered", "retrans",
+        "p50 us", "p90 us", "p99 us", "max us", "goodput");
+    for (const link_sweep_result_T& r : results) {
+        if (!r.applied) {
+            std::printf("%-5s %5u %4u   rejected\n", rate_name(r.settings.data_rate), r.settings.retransmit_delay_us, r.settings.retransmit_count);
+            continue;
+        }
+        std::printf("%-5s %5u %4u %5u/%-3u %8u %8u %8u %8u %8u %10u\n", rate_name(r.settings.data_rate), r.settings.retransmit_delay_us,
+            r.settings.retransmit_count, r.delivered, r.sent, r.retransmits, r.latency_p50_us, r.latency_p90_us, r.latency_p99_us,
+            r.latency_max_us, r.goodput_bps);
+        NRF_CHECK(r.sent == packets_per_setting && r.delivered > 0 && r.delivered <= r.sent);
+        NRF_CHECK(r.latency_p50_us <= r.latency_p90_us && r.latency_p90_us <= r.latency_p99_us && r.latency_p99_us <= r.latency_max_us);
+        NRF_CHECK(r.goodput_bps > 0 && r.goodput_bps < 2000000);
+    }
+
+    NRF_CHECK(measured == count - 1 && !results[count - 1].applied);
+    for (size_t i = 0; i + 1 < count - 1; i += 2) {
+        // the longer retransmit budget loses fewer packets, both pay for the loss in retransmits
+        NRF_CHECK(results[i + 1].delivered >= results[i].delivered);
+        NRF_CHECK(results[i].retransmits > 0 && results[i + 1].retransmits > 0);
+    }
+    NRF_CHECK(results[4].goodput_bps > results[0].goodput_bps);
+
+    // both ends are back where they started and the radio listens again
+    NRF_CHECK(radio.rf_settings().data_rate == original.data_rate && radio.rf_settings().pa_level == original.pa_level);
+    NRF_CHECK(radio.rf_settings().retransmit_delay_us == original.retransmit_delay_us);
+    NRF_CHECK(radio.rf_settings().retransmit_count == original.retransmit_count);
+    NRF_CHECK((peer.reg(0x06) & 0x28) == (original_peer_rf_setup & 0x28));
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+    NRF_CHECK(radio.verify());
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "test_support.hpp"
+
+#include <memory>
+
+using namespace nrf_test;
+
+namespace {
+    constexpr int clock_hz = 8 * 1000 * 1000;
+    constexpr int64_t duration_us = 200 * 1000;
+    constexpr size_t max_radios = 4;
+
+    // CE, CSN and IRQ of each radio on the shared bus, the first one is the usual single radio wiring
+    constexpr int ce_pins[max_radios] = { 4, 25, 26, 27 };
+    constexpr int csn_pins[max_radios] = { 5, 15, 21, 22 };
+    constexpr int irq_pins[max_radios] = { 16, 17, 32, 33 };
+    constexpr u8 channels[max_radios] = { 10, 30, 50, 70 };
+
+    constexpr u8 FIFO_STATUS_TX_FULL = 0x20;
+
+    /**
+     * @brief a driver on the shared bus plus the raw peer listening on its channel
+     */
+    struct node_T{
+        std::unique_ptr<nrf_emu::radio> dut;
+        std::unique_ptr<nrf_emu::radio> peer;
+        std::unique_ptr<spi_object> spi;
+        std::unique_ptr<NRF24> radio;
+    };
+
+    /**
+     * @return frames per second delivered across all radios when one task keeps every TX FIFO topped up
+     */
+    double aggregate_throughput(size_t radios, Data_Rate rate, u8 peer_rf_setup){
+        nrf_emu::air medium;
+        spi_config_T config;
+        config.clock_speed_hz = clock_hz;
+        spi_bus bus(config);
+
+        node_T nodes[max_radios];
+        for (size_t i = 0; i < radios; ++i) {
+            node_T& node = nodes[i];
+            node.dut = std::make_unique<nrf_emu::radio>(medium, csn_pins[i], ce_pins[i], irq_pins[i]);
+            node.peer = std::make_unique<nrf_emu::radio>(medium, -1, -1);
+
+            spi_config_T device = config;
+            device.csn_pin = csn_pins[i];
+            node.spi = std::make_unique<spi_object>(bus, device);
+            const Pins_T pins = { static_cast<gpio_num_t>(ce_pins[i]), static_cast<gpio_num_t>(csn_pins[i]),
+                GPIO_NUM_14, GPIO_NUM_12, GPIO_NUM_13, static_cast<gpio_num_t>(irq_pins[i]) };
+            node.radio = std::make_unique<NRF24>(*node.spi, pins, 32);
+            NRF_CHECK(node.radio->set_data_rate(rate));
+            NRF_CHECK(node.radio->set_channel(channels[i]));
+
+            configure_peer(*node.peer, true);
+            command(*node.peer, {0x26, peer_rf_setup});
+            command(*node.peer, {0x25, channels[i]});
+
+            // PWR_UP with PRIM_RX clear, CE stays high so every payload loaded goes straight on air
+            const u8 config_tx[2] = { 0x20, 0x02 };
+            NRF_CHECK(node.spi->send_data(sizeof(config_tx), config_tx) == ESP_OK);
+        }
+        esp_host::advance_us(2000);
+        for (size_t i = 0; i < radios; ++i) {
+            gpio_set_level(static_cast<gpio_num_t>(ce_pins[i]), 1);
+        }
+
+        u8 payload[33] = { 0xA0 };
+        u8 fifo_query[2] = { 0x17, 0xFF };
+        u8 fifo_status[2] = {};
+        uint32_t delivered = 0;
+        const int64_t started_us = esp_timer_get_time();
+        while (esp_timer_get_time() - started_us < duration_us) {
+            bool loaded = false;
+            for (size_t i = 0; i < radios; ++i) {
+                node_T& node = nodes[i];
+                node.spi->send_data(sizeof(fifo_query), fifo_query, fifo_status);
+                if (!(fifo_status[1] & FIFO_STATUS_TX_FULL)) {
+                    node.spi->send_data(sizeof(payload), payload);
+                    loaded = true;
+                }
+                while (node.peer->rx_fifo_count() != 0) {
+                    peer_receive(*node.peer);
+                    ++delivered;
+                }
+            }
+            if (!loaded) {
+                esp_host::advance_us(20);
+            }
+        }
+        const int64_t elapsed_us = esp_timer_get_time() - started_us;
+        return static_cast<double>(delivered) * 1000000 / elapsed_us;
+    }
+}
+
+/**
+ * Aggregate throughput of 1 to 4 radios sharing one SPI bus, each on its own channel with no auto-ack. A single
+ * task round-robins FIFO_STATUS checks and payload loads, so the numbers show whether bus time spent on one
+ * radio holds the others back. Virtual time is global on the host, radios on SPI2 and SPI3 would overlap their
+ * transfers as well and are not modelled.
+ */
+int main(){
+    struct rate_T{ const char* name; Data_Rate rate; u8 rf_setup; };
+    const rate_T rates[] = {
+        { "250 kbps", Data_Rate::Rate_250kbps, 0x26 },
+        { "2 Mbps", Data_Rate::Rate_2Mbps, 0x0E },
+    };
+
+    std::printf("SPI at %d MHz, %lld ms per point, 32 byte payloads, frames/s delivered\n",
+        clock_hz / 1000000, static_cast<long long>(duration_us / 1000));
+    std::printf("%-10s %8s %12s %10s\n", "rate", "radios", "frames/s", "scaling");
+    for (const rate_T& r : rates) {
+        double single = 0;
+        for (size_t radios = 1; radios <= max_radios; ++radios) {
+            const double throughput = aggregate_throughput(radios, r.rate, r.rf_setup);
+            if (radios == 1) single = throughput;
+            std::printf("%-10s %8zu %12.0f %9.2fx\n", r.name, radios, throughput, throughput / single);
+            NRF_CHECK(throughput > single * radios * 0.9);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    constexpr int rounds = 500;
+    constexpr int clock_hz = 8 * 1000 * 1000;
+
+    struct result_T{
+        double frames_per_s;
+        double spi_bytes;       // per frame, payload write plus the TX_DS wait and flag clear
+    };
+
+    /**
+     * @return acknowledged frames per second of length bytes with transmit_data, static 32 byte or dynamic payloads
+     */
+    result_T measure(u8 length, bool dynamic){
+        nrf_emu::air medium;
+        nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+        nrf_emu::radio peer(medium, -1, -1);
+        spi_config_T config;
+        config.clock_speed_hz = clock_hz;
+        spi_object spi(config);
+        NRF24 radio(spi, dut_pins(), 32);
+
+        // auto-ack on pipe 0 in both modes so only the payload length differs, DPL needs it anyway
+        pipe_config_T pipe;
+        pipe.address = { 0x03, 0x03, 0x03 };
+        pipe.auto_ack = true;
+        NRF_CHECK(radio.configure_pipe(0, pipe));
+        NRF_CHECK(radio.set_data_rate(Data_Rate::Rate_2Mbps));
+        NRF_CHECK(!dynamic || radio.set_dynamic_payloads(true));
+        NRF_CHECK(radio.dynamic_payloads() == dynamic);
+
+        configure_peer(peer, true);
+        command(peer, {0x26, 0x0E});
+        command(peer, {0x21, 0x01});
+        if (dynamic) {
+            command(peer, {0x3D, 0x04});
+            command(peer, {0x3C, 0x01});
+        }
+
+        u8 payload[32] = {};
+        spi.reset_stats();
+        const int64_t started_us = esp_timer_get_time();
+        for (int i = 0; i < rounds; ++i) {
+            payload[0] = static_cast<u8>(i);
+            radio.transmit_data(payload, length);
+            command(peer, {0xE2});
+            command(peer, {0x27, 0x40});
+        }
+        const int64_t elapsed_us = esp_timer_get_time() - started_us;
+        NRF_CHECK(peer.counters().frames_received == static_cast<uint32_t>(rounds));
+        NRF_CHECK(dut.counters().max_rt_events == 0);
+        return { static_cast<double>(rounds) * 1000000 / elapsed_us, static_cast<double>(spi.stats().bytes) / rounds };
+    }
+}
+
+/**
+ * Acknowledged transmit_data rate for short frames at 2 Mbps, static 32 byte payloads against dynamic payload
+ * length. Static payloads put all 32 bytes on the SPI bus and on air whatever the real length.
+ */
+int main(){
+    std::printf("2 Mbps, auto-ack, SPI at %d MHz, %d frames each\n", clock_hz / 1000000, rounds);
+    std::printf("%-8s %14s %14s %12s %12s\n", "bytes", "static fr/s", "DPL fr/s", "static SPI B", "DPL SPI B");
+    const u8 lengths[] = { 1, 4, 8, 16, 32 };
+    for (u8 length : lengths) {
+        const result_T fixed = measure(length, false);
+        const result_T dynamic = measure(length, true);
+        std::printf("%-8u %14.0f %14.0f %12.1f %12.1f\n", length, fixed.frames_per_s, dynamic.frames_per_s,
+            fixed.spi_bytes, dynamic.spi_bytes);
+        if (length < 32) {
+            NRF_CHECK(dynamic.frames_per_s > fixed.frames_per_s);
+            NRF_CHECK(dynamic.spi_bytes < fixed.spi_bytes);
+        }
+    }
+    return 0;
+}
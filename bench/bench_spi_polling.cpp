@@ -0,0 +1,80 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    constexpr int rounds = 1000;
+    constexpr int clock_hz = 8 * 1000 * 1000;
+
+    /**
+     * @return average latency of one send_data in virtual us, from spi_object's own busy time
+     */
+    double command_latency(spi_object& spi, size_t length){
+        u8 command[33] = {0xFF};
+        u8 response[33] = {};
+        spi.reset_stats();
+        for (int i = 0; i < rounds; ++i) {
+            spi.send_data(length, command, response);
+        }
+        return static_cast<double>(spi.stats().busy_us) / spi.stats().transactions;
+    }
+
+    double driver_latency(NRF24& radio){
+        const int64_t started_us = esp_timer_get_time();
+        for (int i = 0; i < rounds; ++i) {
+            radio.get_status();
+        }
+        return static_cast<double>(esp_timer_get_time() - started_us) / rounds;
+    }
+}
+
+/**
+ * Per-command latency of the short commands that make up most driver traffic, with spi_device_transmit (interrupt
+ * and DMA) against set_low_latency's spi_device_polling_transmit. The 33 byte payload transfer stays on DMA in
+ * both modes, the polling limit defaults to 32 bytes.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    spi_config_T config;
+    config.clock_speed_hz = clock_hz;
+    spi_object spi(config);
+    NRF24 radio(spi, dut_pins(), 32);
+
+    std::printf("SPI at %d MHz, %d commands each, latency in virtual us\n", clock_hz / 1000000, rounds);
+    std::printf("%-30s %12s %12s\n", "", "interrupt", "polling");
+
+    struct case_T{ const char* name; size_t length; };
+    const case_T cases[] = {
+        { "NOP / STATUS (1 byte)", 1 },
+        { "W_REGISTER (2 bytes)", 2 },
+        { "TX_ADDR write (6 bytes)", 6 },
+        { "W_TX_PAYLOAD (33 bytes)", 33 },
+    };
+    double short_interrupt = 0;
+    double short_polling = 0;
+    for (const case_T& c : cases) {
+        spi.set_low_latency(false);
+        const double interrupt_us = command_latency(spi, c.length);
+        spi.set_low_latency(true);
+        const double polling_us = command_latency(spi, c.length);
+        std::printf("%-30s %12.1f %12.1f\n", c.name, interrupt_us, polling_us);
+        if (c.length == 1) {
+            short_interrupt = interrupt_us;
+            short_polling = polling_us;
+        }
+        if (c.length > 32) {
+            NRF_CHECK(interrupt_us == polling_us);
+        }
+    }
+
+    spi.set_low_latency(false);
+    const double status_interrupt = driver_latency(radio);
+    spi.set_low_latency(true);
+    const double status_polling = driver_latency(radio);
+    std::printf("%-30s %12.1f %12.1f\n", "NRF24::get_status", status_interrupt, status_polling);
+
+    std::printf("1 byte command: %.1fx faster polled\n", short_interrupt / short_polling);
+    NRF_CHECK(short_polling < short_interrupt);
+    return 0;
+}
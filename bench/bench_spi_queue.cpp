@@ -0,0 +1,88 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    constexpr int rounds = 1000;
+    constexpr int clock_hz = 8 * 1000 * 1000;
+
+    int64_t wire_us(size_t bytes){
+        return static_cast<int64_t>((bytes * 8 * 1000000 + clock_hz - 1) / clock_hz);
+    }
+
+    struct result_T{
+        double total_us;        // per round
+        double gap_us;          // per command, time the bus sat idle between or around transfers
+    };
+
+    template <typename Round>
+    result_T measure(size_t commands, size_t bytes, Round round){
+        const int64_t started_us = esp_timer_get_time();
+        for (int i = 0; i < rounds; ++i) {
+            round();
+        }
+        const double total_us = static_cast<double>(esp_timer_get_time() - started_us) / rounds;
+        return { total_us, (total_us - static_cast<double>(wire_us(bytes))) / commands };
+    }
+
+    void report(const char* name, const result_T& blocking, const result_T& queued){
+        std::printf("%-34s %10.1f %10.1f %10.1f %10.1f\n", name, blocking.total_us, blocking.gap_us, queued.total_us, queued.gap_us);
+    }
+}
+
+/**
+ * Blocking spi_device_transmit per command against one spi_device_queue_trans batch, for the command groups the
+ * driver sends together. A queued command is chained behind the previous one, so the bus gap between commands
+ * drops from the ISR round trip to the DMA hand-over and the task blocks once per group instead of per command.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    spi_config_T config;
+    config.clock_speed_hz = clock_hz;
+    spi_object spi(config);
+
+    std::printf("SPI at %d MHz, %d rounds, times in virtual us\n", clock_hz / 1000000, rounds);
+    std::printf("%-34s %10s %10s %10s %10s\n", "", "blocking", "gap/cmd", "queued", "gap/cmd");
+
+    // a packet: W_TX_PAYLOAD then a STATUS read
+    u8 payload[33] = {0xA0};
+    u8 status_command = 0xFF;
+    u8 status = 0;
+    u8 flush = 0xE1;
+    const spi_transfer_T packet[] = {
+        { sizeof(payload), payload, nullptr },
+        { 1, &status_command, &status },
+        { 1, &flush, nullptr },
+    };
+    const result_T packet_blocking = measure(3, 35, [&]{
+        spi.send_data(sizeof(payload), payload, nullptr);
+        spi.send_data(1, &status_command, &status);
+        spi.send_data(1, &flush, nullptr);
+    });
+    const result_T packet_queued = measure(3, 35, [&]{ spi.send_batch(packet, 3); });
+    report("packet: payload + STATUS + flush", packet_blocking, packet_queued);
+
+    // a register block, the size of a register_batch_T
+    constexpr size_t block = spi_object::max_queued_transfers;
+    u8 writes[block][2] = {};
+    spi_transfer_T block_transfers[block] = {};
+    for (size_t i = 0; i < block; ++i) {
+        writes[i][0] = static_cast<u8>(0x20 | (i + 1));
+        writes[i][1] = 0;
+        block_transfers[i] = { 2, writes[i], nullptr };
+    }
+    const result_T block_blocking = measure(block, block * 2, [&]{
+        for (size_t i = 0; i < block; ++i) {
+            spi.send_data(2, writes[i], nullptr);
+        }
+    });
+    const result_T block_queued = measure(block, block * 2, [&]{ spi.send_batch(block_transfers, block); });
+    report("register block: 10 x W_REGISTER", block_blocking, block_queued);
+
+    std::printf("per packet: %.1f us -> %.1f us (%.0f%% less bus time)\n", packet_blocking.total_us, packet_queued.total_us,
+                100.0 * (1.0 - packet_queued.total_us / packet_blocking.total_us));
+    NRF_CHECK(packet_queued.total_us < packet_blocking.total_us);
+    NRF_CHECK(block_queued.gap_us < block_blocking.gap_us);
+    return 0;
+}
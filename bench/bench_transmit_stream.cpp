@@ -0,0 +1,90 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    constexpr size_t packet_count = 500;
+    constexpr int clock_hz = 8 * 1000 * 1000;
+
+    void drain(nrf_emu::radio& peer){
+        while (peer.rx_fifo_count() != 0) {
+            command(peer, {0xE2});
+            command(peer, {0x27, 0x40});
+        }
+    }
+
+    void drain_on_complete(size_t, bool, void* context){
+        drain(*static_cast<nrf_emu::radio*>(context));
+    }
+
+    struct result_T{
+        double frames_per_s;
+        uint32_t delivered;
+    };
+
+    /**
+     * @return delivered frames per second, one transmit_data per packet or the whole set through transmit_stream
+     */
+    result_T measure(Data_Rate rate, u8 peer_rf_setup, bool no_ack, bool streamed){
+        nrf_emu::air medium;
+        nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+        nrf_emu::radio peer(medium, -1, -1);
+        spi_config_T config;
+        config.clock_speed_hz = clock_hz;
+        spi_object spi(config);
+        NRF24 radio(spi, dut_pins(), 32);
+
+        pipe_config_T pipe;
+        pipe.address = { 0x03, 0x03, 0x03 };
+        pipe.auto_ack = true;
+        NRF_CHECK(radio.configure_pipe(0, pipe));
+        NRF_CHECK(radio.set_data_rate(rate));
+
+        configure_peer(peer, true);
+        command(peer, {0x26, peer_rf_setup});
+        command(peer, {0x21, 0x01});
+
+        static u8 payload[32] = {};
+        std::vector<tx_packet_T> packets(packet_count, tx_packet_T{ payload, 32, no_ack });
+        uint32_t delivered = 0;
+        const int64_t started_us = esp_timer_get_time();
+        if (streamed) {
+            delivered = radio.transmit_stream(packets.data(), packets.size(), drain_on_complete, &peer);
+        } else {
+            for (const tx_packet_T& packet : packets) {
+                delivered += radio.transmit_data(payload, packet.length, no_ack) ? 1 : 0;
+                drain(peer);
+            }
+        }
+        const int64_t elapsed_us = esp_timer_get_time() - started_us;
+        NRF_CHECK(peer.counters().frames_received == packet_count);
+        return { static_cast<double>(delivered) * 1000000 / elapsed_us, delivered };
+    }
+}
+
+/**
+ * Throughput of 32 byte packets sent one transmit_data at a time against transmit_stream, which keeps CE high and
+ * the TX FIFO loaded. Every packet is checked to have arrived, and the stream must be faster.
+ */
+int main(){
+    struct rate_T{ const char* name; Data_Rate rate; u8 rf_setup; };
+    const rate_T rates[] = {
+        { "250 kbps", Data_Rate::Rate_250kbps, 0x26 },
+        { "1 Mbps", Data_Rate::Rate_1Mbps, 0x06 },
+        { "2 Mbps", Data_Rate::Rate_2Mbps, 0x0E },
+    };
+
+    std::printf("SPI at %d MHz, %zu packets of 32 bytes, frames/s delivered\n", clock_hz / 1000000, packet_count);
+    std::printf("%-10s %-8s %14s %14s %8s\n", "rate", "ack", "transmit_data", "stream", "gain");
+    for (const rate_T& r : rates) {
+        for (bool no_ack : { false, true }) {
+            const result_T single = measure(r.rate, r.rf_setup, no_ack, false);
+            const result_T stream = measure(r.rate, r.rf_setup, no_ack, true);
+            std::printf("%-10s %-8s %14.0f %14.0f %7.2fx\n", r.name, no_ack ? "no-ack" : "auto-ack",
+                single.frames_per_s, stream.frames_per_s, stream.frames_per_s / single.frames_per_s);
+            NRF_CHECK(single.delivered == packet_count && stream.delivered == packet_count);
+            NRF_CHECK(stream.frames_per_s > single.frames_per_s);
+        }
+    }
+    return 0;
+}
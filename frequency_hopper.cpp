@@ -0,0 +1,150 @@
+#include "frequency_hopper.hpp"
+#include "nrf_log.hpp"
+
+
+frequency_hopper::frequency_hopper(NRF24& radio, const hop_config_T& config, const hop_timing_T& timing) :
+    radio_(radio), config_(config), timing_(timing)
+{
+    length_ = build_sequence(config_, sequence_);
+}
+
+
+size_t frequency_hopper::build_sequence(const hop_config_T& config, std::array<u8, max_sequence_length>& sequence) {
+    size_t length = 0;
+    if (config.channels != nullptr) {
+        for (size_t i = 0; i < config.channel_count && length < max_sequence_length; ++i) {
+            if (config.channels[i] < NRF_regs::channel_count) {
+                sequence[length++] = config.channels[i];
+            }
+        }
+    } else {
+        for (unsigned channel = config.first_channel; channel <= config.last_channel && channel < NRF_regs::channel_count; ++channel) {
+            sequence[length++] = static_cast<u8>(channel);
+        }
+    }
+
+    // Fisher-Yates with xorshift32, fixed arithmetic so every node shuffles identically
+    uint32_t state = config.seed != 0 ? config.seed : 1;
+    for (size_t i = length; i > 1; --i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        const size_t j = state % i;
+        const u8 swap = sequence[i - 1];
+        sequence[i - 1] = sequence[j];
+        sequence[j] = swap;
+    }
+    return length;
+}
+
+
+bool frequency_hopper::start() {
+    if (length_ == 0) {
+        NRF_LOGE("[FREQUENCY_HOPPER::start] Empty channel set\n");
+        return false;
+    }
+    index_ = 0;
+    packets_on_channel_ = 0;
+    hop_started_us_ = radio_.timing().now_us();
+    last_packet_us_ = hop_started_us_;
+    return radio_.set_channel(channel());
+}
+
+
+bool frequency_hopper::advance() {
+    index_ = (index_ + 1) % length_;
+    packets_on_channel_ = 0;
+    hop_started_us_ = radio_.timing().now_us();
+    return radio_.set_channel(channel());
+}
+
+
+bool frequency_hopper::dwell_expired(int64_t now_us) const {
+    return config_.dwell_us != 0 && now_us - hop_started_us_ >= static_cast<int64_t>(config_.dwell_us);
+}
+
+
+void frequency_hopper::count_packet() {
+    packets_on_channel_++;
+    if ((config_.packets_per_hop != 0 && packets_on_channel_ >= config_.packets_per_hop) || dwell_expired(radio_.timing().now_us())) {
+        stats_.hops++;
+        advance();
+    }
+}
+
+
+bool frequency_hopper::transmit(const u8* data, u8 length) {
+    u8 reply[NRF24::fifo_max_size];
+    u8 reply_length = 0;
+    return transmit(data, length, reply, reply_length);
+}
+
+
+bool frequency_hopper::transmit(const u8* data, u8 length, u8* reply, u8& reply_length) {
+    if (length_ == 0) {
+        return false;
+    }
+    if (dwell_expired(radio_.timing().now_us())) {
+        stats_.hops++;
+        advance();
+    }
+
+    for (u8 attempt = 0; attempt <= timing_.retries_before_search; ++attempt) {
+        if (radio_.transmit_request(data, length, reply, reply_length)) {
+            count_packet();
+            return true;
+        }
+    }
+
+    // the receiver is elsewhere in the sequence, usually one hop ahead after a lost ACK or past a jammed channel
+    stats_.sync_losses++;
+    const size_t lost_index = index_;
+    for (size_t step = 1; step < length_; ++step) {
+        advance();
+        stats_.search_attempts++;
+        if (radio_.transmit_request(data, length, reply, reply_length)) {
+            stats_.resyncs++;
+            NRF_LOGI("[FREQUENCY_HOPPER::transmit] Receiver found %u hops on, channel %d\n", static_cast<unsigned>(step), channel());
+            count_packet();
+            return true;
+        }
+    }
+
+    index_ = lost_index;
+    packets_on_channel_ = 0;
+    hop_started_us_ = radio_.timing().now_us();
+    radio_.set_channel(channel());
+    stats_.failed++;
+    return false;
+}
+
+
+void frequency_hopper::on_packet() {
+    if (length_ == 0) {
+        return;
+    }
+    const int64_t now_us = radio_.timing().now_us();
+    if (packets_on_channel_ == 0) {
+        hop_started_us_ = now_us; // line the dwell up with the transmitter's first packet on this channel
+    }
+    last_packet_us_ = now_us;
+    count_packet();
+}
+
+
+void frequency_hopper::poll() {
+    if (length_ == 0) {
+        return;
+    }
+    const int64_t now_us = radio_.timing().now_us();
+    if (timing_.silence_us != 0 && now_us - last_packet_us_ >= static_cast<int64_t>(timing_.silence_us)) {
+        stats_.silence_hops++;
+        last_packet_us_ = now_us;
+        advance();
+        return;
+    }
+    if (packets_on_channel_ > 0 && dwell_expired(now_us)) {
+        stats_.hops++;
+        advance();
+    }
+}
@@ -0,0 +1,136 @@
+
+#pragma once
+
+#include "nRF24L01P.hpp"
+
+#include <array>
+
+
+/**
+ * @brief hop plan shared by both ends of a link, every field must match on the two nodes
+ */
+struct hop_config_T{
+    uint32_t seed = 0x2401;             // both ends derive the same channel order from it
+    const u8* channels = nullptr;       // channels to hop over, e.g. from NRF24::quietest_channels. nullptr uses first_channel - last_channel
+    u8 channel_count = 0;
+    u8 first_channel = 2;
+    u8 last_channel = 80;               // inside the 2.4 GHz ISM band
+    uint16_t packets_per_hop = 16;      // hop after this many delivered packets, 0 to hop on dwell_us only
+    uint32_t dwell_us = 0;              // hop after this long on a channel, 0 to hop on packets_per_hop only
+};
+
+/**
+ * @brief link timing of one end, does not have to match the other end
+ */
+struct hop_timing_T{
+    u8 retries_before_search = 2;       // failed transmit_request calls on the current channel before searching the sequence
+    uint32_t silence_us = 100 * 1000;   // receiver: move one channel on after hearing nothing for this long, 0 never
+};
+
+/**
+ * @brief running totals of a frequency_hopper
+ */
+struct hop_stats_T{
+    uint32_t hops;                  // scheduled hops, by packet count or dwell
+    uint32_t sync_losses;           // transmitter: the receiver stopped answering on the expected channel
+    uint32_t resyncs;               // transmitter: searches that found the receiver again
+    uint32_t search_attempts;       // transmitter: packets tried on other channels while searching
+    uint32_t silence_hops;          // receiver: hops taken because nothing was heard for silence_us
+    uint32_t failed;                // transmitter: packets that found the receiver on no channel
+};
+
+
+/**
+ * @brief Frequency hopping for a pair of NRF24s. Both ends build the same seed-derived permutation of the channel
+ * set and step through it, hopping after packets_per_hop delivered packets and/or dwell_us. Each hop is a single
+ * cached RF_CH write (NRF24::set_channel), nothing else is reconfigured.
+ *
+ * The transmitter sends with transmit_request, so auto-ack must be on for pipe 0 on both ends (set_ack_payloads),
+ * and a packet only counts once the receiver acknowledged it. That keeps both packet counters equal, a lost ACK or a
+ * jammed channel is what puts them out of step. Resynchronisation:
+ *  - transmitter: after retries_before_search failures it tries the packet on each following channel of the
+ *    sequence and adopts the one the receiver answers on
+ *  - receiver: after silence_us without a packet it moves on one channel, so it leaves a jammed channel and is found
+ *    on the transmitter's next search
+ *
+ * The receiver must report every packet with on_packet and call poll regularly, both from the same task, e.g. the
+ * consumer of a packet_ring or an rx_process loop.
+ */
+class frequency_hopper{
+    public:
+        static constexpr size_t max_sequence_length = NRF_regs::channel_count;
+
+        frequency_hopper(NRF24& radio, const hop_config_T& config, const hop_timing_T& timing = {});
+
+        /**
+         * @brief tunes the radio to the first channel of the sequence, both ends start here
+         *
+         * @return bool - false if the channel set is empty or RF_CH could not be written
+         */
+        bool start();
+
+        /**
+         * @brief transmitter side, sends one packet on the current channel, searching the sequence for the receiver
+         * when it stops answering, then hops if the schedule says so
+         *
+         * @param data packet bytes, 1 - NRF24::fifo_max_size
+         * @param length packet length
+         * @param reply destination for an ACK payload, must hold NRF24::fifo_max_size bytes
+         * @param reply_length set to the ACK payload length, 0 if none
+         *
+         * @return bool
+         * @retval true if the receiver acknowledged the packet
+         * @retval false if no channel of the sequence answered, the hopper stays where it was
+         */
+        bool transmit(const u8* data, u8 length, u8* reply, u8& reply_length);
+        bool transmit(const u8* data, u8 length);
+
+        /**
+         * @brief receiver side, counts one received packet and hops when the schedule says so
+         */
+        void on_packet();
+
+        /**
+         * @brief receiver side, hops on dwell_us and after silence_us without packets
+         */
+        void poll();
+
+        u8 channel() const { return sequence_[index_]; }
+        size_t hop_index() const { return index_; }
+        size_t sequence_length() const { return length_; }
+        const u8* sequence() const { return sequence_.data(); }
+        const hop_stats_T& stats() const { return stats_; }
+
+        /**
+         * @brief fills sequence with the hop order for a config, the same on every node
+         *
+         * @return size_t - sequence length, 0 if the channel set is empty
+         */
+        static size_t build_sequence(const hop_config_T& config, std::array<u8, max_sequence_length>& sequence);
+
+    private:
+        NRF24& radio_;
+        const hop_config_T config_;
+        const hop_timing_T timing_;
+        hop_stats_T stats_ = {};
+
+        std::array<u8, max_sequence_length> sequence_ = {};
+        size_t length_ = 0;
+        size_t index_ = 0;
+
+        uint16_t packets_on_channel_ = 0;
+        int64_t hop_started_us_ = 0;
+        int64_t last_packet_us_ = 0;
+
+        /**
+         * @brief moves to the next channel of the sequence
+         */
+        bool advance();
+
+        /**
+         * @brief counts a delivered packet and hops when packets_per_hop or dwell_us is reached
+         */
+        void count_packet();
+
+        bool dwell_expired(int64_t now_us) const;
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+/**
+ * @brief Host stand-in for ESP-IDF's driver/spi_master.h. Each device is keyed by its
+ * spics_io_num, transactions are handed to the esp_host backend and the virtual clock
+ * is advanced by the time the bytes take on the wire at the device's clock speed, plus
+ * an approximate per-transaction software cost: interrupt/DMA transactions pay for the
+ * ISR round trip and DMA descriptor setup, polling transactions only for register setup.
+ * A transaction queued while an earlier one is still uncollected is chained behind it
+ * and only pays the gap between the two.
+ */
+
+#define HOST_SPI_INTERRUPT_OVERHEAD_US  15
+#define HOST_SPI_POLLING_OVERHEAD_US    4
+#define HOST_SPI_QUEUED_GAP_US          2
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+typedef enum {
+    SPI1_HOST = 0,
+    SPI2_HOST = 1,
+    SPI3_HOST = 2,
+    SPI_HOST_MAX,
+} spi_host_device_t;
+
+typedef enum {
+    SPI_DMA_DISABLED = 0,
+    SPI_DMA_CH_AUTO = 3,
+} spi_dma_chan_t;
+
+typedef enum {
+    ESP_INTR_CPU_AFFINITY_AUTO = 0,
+} esp_intr_cpu_affinity_t;
+
+typedef enum {
+    SPI_CLK_SRC_DEFAULT = 0,
+} spi_clock_source_t;
+
+#define SPI_DEVICE_NO_DUMMY (1 << 6)
+
+typedef struct {
+    int mosi_io_num;
+    int miso_io_num;
+    int sclk_io_num;
+    int quadwp_io_num;
+    int quadhd_io_num;
+    bool data_io_default_level;
+    int max_transfer_sz;
+    uint32_t flags;
+    esp_intr_cpu_affinity_t isr_cpu_id;
+    int intr_flags;
+} spi_bus_config_t;
+
+typedef struct spi_transaction_t spi_transaction_t;
+typedef void (*transaction_cb_t)(spi_transaction_t* trans);
+
+typedef struct {
+    uint8_t command_bits;
+    uint8_t address_bits;
+    uint8_t dummy_bits;
+    uint8_t mode;
+    spi_clock_source_t clock_source;
+    uint16_t duty_cycle_pos;
+    uint16_t cs_ena_pretrans;
+    uint8_t cs_ena_posttrans;
+    int clock_speed_hz;
+    int input_delay_ns;
+    int spics_io_num;
+    uint32_t flags;
+    int queue_size;
+    transaction_cb_t pre_cb;
+    transaction_cb_t post_cb;
+} spi_device_interface_config_t;
+
+struct spi_transaction_t {
+    uint32_t flags;
+    uint16_t cmd;
+    uint64_t addr;
+    size_t length;
+    size_t rxlength;
+    void* user;
+    const void* tx_buffer;
+    void* rx_buffer;
+};
+
+typedef struct spi_device_t* spi_device_handle_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t* bus_config, spi_dma_chan_t dma_chan);
+esp_err_t spi_bus_free(spi_host_device_t host_id);
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t* dev_config, spi_device_handle_t* handle);
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle);
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc);
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t device, TickType_t wait);
+void spi_device_release_bus(spi_device_handle_t dev);
+
+/**
+ * @brief queued transactions are clocked out immediately on the host and handed back in order by
+ * spi_device_get_trans_result, so the virtual clock sees the same wire time as spi_device_transmit
+ */
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t ticks_to_wait);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc, TickType_t ticks_to_wait);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,7 @@
+#pragma once
+
+/**
+ * @brief Host stand-in for ESP-IDF's esp_attr.h, placement attributes have no meaning off target.
+ */
+
+#define IRAM_ATTR
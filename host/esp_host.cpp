@@ -0,0 +1,406 @@
+#include "esp_host.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "rom/ets_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+namespace{
+    std::atomic<int64_t> virtual_time_us{0};
+    esp_host::backend_T* installed_backend = nullptr;
+
+    struct isr_entry_T{
+        gpio_int_type_t type = GPIO_INTR_DISABLE;
+        int level = 1;
+        gpio_isr_t handler = nullptr;
+        void* argument = nullptr;
+    };
+    std::map<int, isr_entry_T> isr_entries;
+    std::map<int, int> spi_clock_limits;   // cs pin -> fastest SCLK the wiring carries
+    std::map<int, int> spi_bus_devices;    // initialised hosts -> devices attached
+    thread_local bool in_isr = false;
+    std::atomic<uint32_t> random_state{0x2401};
+}
+
+struct host_task_t{
+    std::mutex mutex;
+    std::condition_variable notified;
+    uint32_t notification_count = 0;
+};
+
+namespace{
+    thread_local host_task_t* current_task = nullptr;
+}
+
+struct spi_device_t{
+    spi_host_device_t host;
+    int cs_pin;
+    int clock_speed_hz;
+    int queue_size;
+    // finished queued transactions, a fixed ring like the IDF queue so queuing never touches the host heap
+    static constexpr size_t max_queue_size = 16;
+    std::array<spi_transaction_t*, max_queue_size> completed{};
+    size_t completed_head = 0;
+    size_t completed_count = 0;
+};
+
+struct host_semaphore_t{
+    std::recursive_timed_mutex mutex;
+};
+
+
+namespace esp_host{
+
+    std::recursive_mutex& backend_lock(){
+        static std::recursive_mutex lock;
+        return lock;
+    }
+
+    void install_backend(backend_T* backend){
+        std::lock_guard<std::recursive_mutex> guard(backend_lock());
+        installed_backend = backend;
+    }
+
+    void remove_backend(const backend_T* backend){
+        std::lock_guard<std::recursive_mutex> guard(backend_lock());
+        if (installed_backend == backend) {
+            installed_backend = nullptr;
+        }
+    }
+
+    void drive_gpio_input(int pin, int level){
+        std::lock_guard<std::recursive_mutex> guard(backend_lock());
+        isr_entry_T& entry = isr_entries[pin];
+        const int previous = entry.level;
+        entry.level = level;
+        if (entry.handler == nullptr || previous == level) return;
+
+        const bool fire = entry.type == GPIO_INTR_ANYEDGE
+                       || (entry.type == GPIO_INTR_NEGEDGE && level == 0)
+                       || (entry.type == GPIO_INTR_POSEDGE && level == 1)
+                       || (entry.type == GPIO_INTR_LOW_LEVEL && level == 0)
+                       || (entry.type == GPIO_INTR_HIGH_LEVEL && level == 1);
+        if (fire) {
+            in_isr = true;
+            entry.handler(entry.argument);
+            in_isr = false;
+        }
+    }
+
+    void set_spi_clock_limit(int cs_pin, int max_clock_hz){
+        std::lock_guard<std::recursive_mutex> guard(backend_lock());
+        if (max_clock_hz <= 0) {
+            spi_clock_limits.erase(cs_pin);
+        } else {
+            spi_clock_limits[cs_pin] = max_clock_hz;
+        }
+    }
+
+    int64_t now_us(){
+        return virtual_time_us.load();
+    }
+
+    void advance_us(int64_t delta_us){
+        if (delta_us <= 0) return;
+        std::lock_guard<std::recursive_mutex> guard(backend_lock());
+        const int64_t now = virtual_time_us.fetch_add(delta_us) + delta_us;
+        if (installed_backend) {
+            installed_backend->on_time_advanced(now);
+        }
+    }
+
+    void seed_random(uint32_t seed){
+        random_state.store(seed != 0 ? seed : 1); // xorshift never leaves 0
+    }
+}
+
+
+namespace{
+    esp_err_t host_transfer(spi_device_handle_t handle, spi_transaction_t* trans_desc, int64_t overhead_us){
+        if (handle == nullptr || trans_desc == nullptr || trans_desc->length % 8 != 0) return ESP_ERR_INVALID_ARG;
+        const size_t bytes = trans_desc->length / 8;
+
+        std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+        if (installed_backend) {
+            installed_backend->on_spi_transfer(handle->cs_pin,
+                                               static_cast<const uint8_t*>(trans_desc->tx_buffer),
+                                               static_cast<uint8_t*>(trans_desc->rx_buffer),
+                                               bytes);
+        }
+        const auto limit = spi_clock_limits.find(handle->cs_pin);
+        if (trans_desc->rx_buffer != nullptr && limit != spi_clock_limits.end() && handle->clock_speed_hz > limit->second) {
+            // sampled one bit late, each byte picks up the last bit of the one before it
+            uint8_t* rx = static_cast<uint8_t*>(trans_desc->rx_buffer);
+            uint8_t carried = 0;
+            for (size_t i = 0; i < bytes; ++i) {
+                const uint8_t next = rx[i] & 0x01;
+                rx[i] = static_cast<uint8_t>((rx[i] >> 1) | (carried << 7));
+                carried = next;
+            }
+        }
+        // time the bytes spend on the wire, rounded up to whole microseconds
+        const int64_t bits = static_cast<int64_t>(bytes) * 8;
+        esp_host::advance_us(overhead_us + (bits * 1000000 + handle->clock_speed_hz - 1) / handle->clock_speed_hz);
+        return ESP_OK;
+    }
+}
+
+
+extern "C" {
+
+int64_t esp_timer_get_time(void){
+    return esp_host::now_us();
+}
+
+void ets_delay_us(uint32_t us){
+    esp_host::advance_us(us);
+}
+
+uint32_t esp_random(void){
+    // xorshift32, good enough for backoff and jitter
+    uint32_t state = random_state.load();
+    uint32_t next = 0;
+    do {
+        next = state;
+        next ^= next << 13;
+        next ^= next >> 17;
+        next ^= next << 5;
+    } while (!random_state.compare_exchange_weak(state, next));
+    return next;
+}
+
+BaseType_t xPortInIsrContext(void){
+    return in_isr ? pdTRUE : pdFALSE;
+}
+
+void vTaskDelay(const TickType_t ticks_to_delay){
+    // the task wakes on the tick interrupt ending the count, which includes the tick already under way
+    const int64_t tick_us = 1000000 / configTICK_RATE_HZ;
+    if (ticks_to_delay > 0) {
+        esp_host::advance_us(static_cast<int64_t>(ticks_to_delay) * tick_us - esp_host::now_us() % tick_us);
+    }
+    std::this_thread::yield();
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void){
+    return new host_semaphore_t();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait){
+    if (ticks_to_wait == portMAX_DELAY) {
+        semaphore->mutex.lock();
+        return pdTRUE;
+    }
+    const auto timeout = std::chrono::milliseconds(ticks_to_wait * 1000 / configTICK_RATE_HZ);
+    return semaphore->mutex.try_lock_for(timeout) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore){
+    semaphore->mutex.unlock();
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore){
+    delete semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void){
+    return xSemaphoreCreateMutex(); // host mutexes are recursive already
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait){
+    return xSemaphoreTake(semaphore, ticks_to_wait);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t semaphore){
+    return xSemaphoreGive(semaphore);
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level){
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    if (installed_backend) {
+        installed_backend->on_gpio_write(gpio_num, level ? 1 : 0);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num){
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    if (!installed_backend) return 0;
+    const int level = installed_backend->on_gpio_read(gpio_num);
+    return level < 0 ? 0 : level;
+}
+
+esp_err_t gpio_config(const gpio_config_t* config){
+    if (config == nullptr) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    for (int pin = 0; pin < GPIO_NUM_MAX; ++pin) {
+        if (config->pin_bit_mask & (1ULL << pin)) {
+            isr_entries[pin].type = config->intr_type;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int){
+    static bool installed = false;
+    if (installed) return ESP_ERR_INVALID_STATE;
+    installed = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void* args){
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    isr_entry_T& entry = isr_entries[gpio_num];
+    entry.handler = isr_handler;
+    entry.argument = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num){
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    isr_entries[gpio_num].handler = nullptr;
+    return ESP_OK;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char*, uint32_t, void* parameters, UBaseType_t, TaskHandle_t* created_task){
+    host_task_t* task = new host_task_t();
+    if (created_task) *created_task = task;
+    std::thread([task, task_code, parameters]{
+        current_task = task;
+        task_code(parameters);
+    }).detach();
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t){
+    // the host thread ends when the task function returns, handles are left for late notifiers
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait){
+    host_task_t* task = current_task;
+    if (task == nullptr) return 0;
+
+    std::unique_lock<std::mutex> lock(task->mutex);
+    auto ready = [task]{ return task->notification_count > 0; };
+    if (ticks_to_wait == portMAX_DELAY) {
+        task->notified.wait(lock, ready);
+    } else if (!task->notified.wait_for(lock, std::chrono::milliseconds(ticks_to_wait * 1000 / configTICK_RATE_HZ), ready)) {
+        return 0;
+    }
+    const uint32_t count = task->notification_count;
+    task->notification_count = clear_count_on_exit ? 0 : count - 1;
+    return count;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task){
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notification_count++;
+    }
+    task->notified.notify_one();
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken){
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken) *higher_priority_task_woken = pdTRUE;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host_id, const spi_bus_config_t* bus_config, spi_dma_chan_t){
+    if (bus_config == nullptr || host_id == SPI1_HOST || host_id >= SPI_HOST_MAX) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    if (spi_bus_devices.count(host_id) != 0) return ESP_ERR_INVALID_STATE;
+    spi_bus_devices[host_id] = 0;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host_id){
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    const auto bus = spi_bus_devices.find(host_id);
+    if (bus == spi_bus_devices.end() || bus->second != 0) return ESP_ERR_INVALID_STATE;
+    spi_bus_devices.erase(bus);
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host_id, const spi_device_interface_config_t* dev_config, spi_device_handle_t* handle){
+    if (dev_config == nullptr || handle == nullptr || dev_config->clock_speed_hz <= 0) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    const auto bus = spi_bus_devices.find(host_id);
+    if (bus == spi_bus_devices.end()) return ESP_ERR_INVALID_STATE;
+    bus->second++;
+
+    spi_device_t* device = new spi_device_t();
+    device->host = host_id;
+    device->cs_pin = dev_config->spics_io_num;
+    device->clock_speed_hz = dev_config->clock_speed_hz;
+    device->queue_size = std::min(dev_config->queue_size, static_cast<int>(spi_device_t::max_queue_size));
+    *handle = device;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle){
+    if (handle == nullptr) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    if (handle->completed_count != 0) return ESP_ERR_INVALID_STATE;
+    spi_bus_devices[handle->host]--;
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc){
+    return host_transfer(handle, trans_desc, HOST_SPI_INTERRUPT_OVERHEAD_US);
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* trans_desc){
+    return host_transfer(handle, trans_desc, HOST_SPI_POLLING_OVERHEAD_US);
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t device, TickType_t){
+    return device == nullptr ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t){
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans_desc, TickType_t){
+    if (handle == nullptr) return ESP_ERR_INVALID_ARG;
+    bool chained = false;
+    {
+        std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+        if (static_cast<int>(handle->completed_count) >= handle->queue_size) return ESP_ERR_TIMEOUT;
+        chained = handle->completed_count != 0;     // DMA runs on from the previous descriptor
+    }
+    const esp_err_t result = host_transfer(handle, trans_desc, chained ? HOST_SPI_QUEUED_GAP_US : HOST_SPI_INTERRUPT_OVERHEAD_US);
+    if (result != ESP_OK) return result;
+
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    handle->completed[(handle->completed_head + handle->completed_count) % spi_device_t::max_queue_size] = trans_desc;
+    handle->completed_count++;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans_desc, TickType_t){
+    if (handle == nullptr || trans_desc == nullptr) return ESP_ERR_INVALID_ARG;
+    std::lock_guard<std::recursive_mutex> guard(esp_host::backend_lock());
+    if (handle->completed_count == 0) return ESP_ERR_TIMEOUT;
+    *trans_desc = handle->completed[handle->completed_head];
+    handle->completed_head = (handle->completed_head + 1) % spi_device_t::max_queue_size;
+    handle->completed_count--;
+    return ESP_OK;
+}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+ * @brief Host port of the ESP-IDF calls used by spi_object and NRF24.
+ *
+ * The shims under host/ forward GPIO and SPI traffic to a single installed backend and
+ * keep a virtual microsecond clock, so the driver runs unmodified on Linux and the
+ * emulated radios see exactly the timing the driver produces.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace esp_host{
+
+    class backend_T{
+        public:
+            virtual ~backend_T() = default;
+
+            /**
+             * @brief called for every SPI transaction, rx may be nullptr
+             *
+             * @param cs_pin spics_io_num of the device the transaction was issued on
+             */
+            virtual void on_spi_transfer(int cs_pin, const uint8_t* tx, uint8_t* rx, size_t length) = 0;
+
+            virtual void on_gpio_write(int pin, int level) = 0;
+
+            /**
+             * @return level of the pin, or -1 if the backend does not drive it
+             */
+            virtual int on_gpio_read(int pin) = 0;
+
+            /**
+             * @brief called after the virtual clock moves forward
+             */
+            virtual void on_time_advanced(int64_t now_us) = 0;
+    };
+
+    void install_backend(backend_T* backend);
+    void remove_backend(const backend_T* backend);
+
+    /**
+     * @brief called by a backend when it moves an input line, fires any ISR attached to the edge
+     */
+    void drive_gpio_input(int pin, int level);
+
+    /**
+     * @brief models board wiring that only carries SCLK up to max_clock_hz for the device on cs_pin,
+     * faster transfers hand back MISO bytes sampled one bit late. 0 removes the limit.
+     */
+    void set_spi_clock_limit(int cs_pin, int max_clock_hz);
+
+    int64_t now_us();
+    void advance_us(int64_t delta_us);
+
+    /**
+     * @brief restarts the esp_random sequence
+     */
+    void seed_random(uint32_t seed);
+
+    /**
+     * @brief lock serialising every call into the backend, hold it when poking emulator state directly
+     */
+    std::recursive_mutex& backend_lock();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+/**
+ * @brief Host stand-in for ESP-IDF's esp_random.h, a seeded generator so runs stay deterministic.
+ * esp_host::seed_random restarts the sequence.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t esp_random(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+
+/**
+ * @brief Host stand-in for ESP-IDF's esp_timer.h. Time is virtual and only moves
+ * when the driver delays, sleeps or clocks bytes over SPI.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
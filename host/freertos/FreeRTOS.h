@@ -0,0 +1,35 @@
+#pragma once
+
+/**
+ * @brief Host stand-in for the parts of FreeRTOS the driver touches.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE          1
+#define pdFALSE         0
+#define pdPASS          pdTRUE
+#define pdFAIL          pdFALSE
+#define portMAX_DELAY   ((TickType_t)0xffffffffUL)
+
+#define configTICK_RATE_HZ 1000
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define configASSERT(x) assert(x)
+
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+BaseType_t xPortInIsrContext(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task_t* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* parameters);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Advances the virtual clock by the tick count instead of sleeping.
+ */
+void vTaskDelay(const TickType_t ticks_to_delay);
+
+/**
+ * @brief Tasks are backed by detached host threads, stack size and priority are ignored.
+ */
+BaseType_t xTaskCreate(TaskFunction_t task_code, const char* name, uint32_t stack_depth,
+                       void* parameters, UBaseType_t priority, TaskHandle_t* created_task);
+void vTaskDelete(TaskHandle_t task);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,748 @@
+#include "nrf24_emulator.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace nrf_emu{
+
+    namespace{
+        // register file addresses
+        constexpr u8 CONFIG = 0x00;
+        constexpr u8 EN_AA = 0x01;
+        constexpr u8 EN_RXADDR = 0x02;
+        constexpr u8 SETUP_AW = 0x03;
+        constexpr u8 SETUP_RETR = 0x04;
+        constexpr u8 RF_CH = 0x05;
+        constexpr u8 RF_SETUP = 0x06;
+        constexpr u8 STATUS = 0x07;
+        constexpr u8 OBSERVE_TX = 0x08;
+        constexpr u8 RPD = 0x09;
+        constexpr u8 RX_ADDR_P0 = 0x0A;
+        constexpr u8 RX_ADDR_P1 = 0x0B;
+        constexpr u8 TX_ADDR = 0x10;
+        constexpr u8 RX_PW_P0 = 0x11;
+        constexpr u8 FIFO_STATUS = 0x17;
+        constexpr u8 DYNPD = 0x1C;
+        constexpr u8 FEATURE = 0x1D;
+
+        // CONFIG bits
+        constexpr u8 PRIM_RX = 1 << 0;
+        constexpr u8 PWR_UP = 1 << 1;
+        constexpr u8 CRCO = 1 << 2;
+        constexpr u8 EN_CRC = 1 << 3;
+        constexpr u8 IRQ_MASK_BITS = 0x70;
+
+        // STATUS bits
+        constexpr u8 RX_DR = 1 << 6;
+        constexpr u8 TX_DS = 1 << 5;
+        constexpr u8 MAX_RT = 1 << 4;
+        constexpr u8 STATUS_FLAGS = RX_DR | TX_DS | MAX_RT;
+
+        // FEATURE bits
+        constexpr u8 EN_DYN_ACK = 1 << 0;
+        constexpr u8 EN_ACK_PAY = 1 << 1;
+        constexpr u8 EN_DPL = 1 << 2;
+
+        constexpr int64_t history_window_us = 20000;
+
+        uint32_t payload_checksum(const u8* data, u8 length){
+            uint32_t hash = 2166136261u;
+            for (u8 i = 0; i < length; ++i) {
+                hash = (hash ^ data[i]) * 16777619u;
+            }
+            return hash ^ length;
+        }
+
+        command_kind classify(u8 command){
+            if ((command & 0xE0) == 0x00) return command_kind::R_REGISTER;
+            if ((command & 0xE0) == 0x20) return command_kind::W_REGISTER;
+            if ((command & 0xF8) == 0xA8) return command_kind::W_ACK_PAYLOAD;
+            switch (command) {
+                case 0x61: return command_kind::R_RX_PAYLOAD;
+                case 0xA0: return command_kind::W_TX_PAYLOAD;
+                case 0xE1: return command_kind::FLUSH_TX;
+                case 0xE2: return command_kind::FLUSH_RX;
+                case 0xE3: return command_kind::REUSE_TX_PL;
+                case 0x60: return command_kind::R_RX_PL_WID;
+                case 0xB0: return command_kind::W_TX_PAYLOAD_NOACK;
+                case 0xFF: return command_kind::NOP;
+                default:   return command_kind::Unknown;
+            }
+        }
+    }
+
+
+    const char* command_name(command_kind kind){
+        switch (kind) {
+            case command_kind::R_REGISTER:          return "R_REGISTER";
+            case command_kind::W_REGISTER:          return "W_REGISTER";
+            case command_kind::R_RX_PAYLOAD:        return "R_RX_PAYLOAD";
+            case command_kind::W_TX_PAYLOAD:        return "W_TX_PAYLOAD";
+            case command_kind::FLUSH_TX:            return "FLUSH_TX";
+            case command_kind::FLUSH_RX:            return "FLUSH_RX";
+            case command_kind::REUSE_TX_PL:         return "REUSE_TX_PL";
+            case command_kind::R_RX_PL_WID:         return "R_RX_PL_WID";
+            case command_kind::W_ACK_PAYLOAD:       return "W_ACK_PAYLOAD";
+            case command_kind::W_TX_PAYLOAD_NOACK:  return "W_TX_PAYLOAD_NOACK";
+            case command_kind::NOP:                 return "NOP";
+            default:                                return "UNKNOWN";
+        }
+    }
+
+
+    // ---------------------------------------------------------------- radio
+
+    radio::radio(air& medium, int csn_pin, int ce_pin, int irq_pin):
+        air_(medium), csn_pin_(csn_pin), ce_pin_(ce_pin), irq_pin_(irq_pin)
+    {
+        reset();
+        air_.attach(this);
+    }
+
+    radio::~radio(){
+        air_.detach(this);
+    }
+
+    void radio::reset(){
+        regs_.fill(0x00);
+        regs_[CONFIG] = EN_CRC;
+        regs_[EN_AA] = 0x3F;
+        regs_[EN_RXADDR] = 0x03;
+        regs_[SETUP_AW] = 0x03;
+        regs_[SETUP_RETR] = 0x03;
+        regs_[RF_CH] = 0x02;
+        regs_[RF_SETUP] = 0x0E;
+        regs_[0x0C] = 0xC3;
+        regs_[0x0D] = 0xC4;
+        regs_[0x0E] = 0xC5;
+        regs_[0x0F] = 0xC6;
+        rx_addr_p0_.fill(0xE7);
+        rx_addr_p1_.fill(0xC2);
+        tx_addr_.fill(0xE7);
+        rx_fifo_.clear();
+        tx_fifo_.clear();
+        last_rx_pid_.fill(-1);
+        last_rx_checksum_.fill(0);
+        state_ = radio_state::PowerDown;
+        ++generation_;
+    }
+
+    void radio::reset_counters(){
+        spi_counters_ = {};
+        counters_ = {};
+    }
+
+    u8 radio::reg(u8 address) const{
+        u8 value = 0;
+        read_register(address, &value, 1);
+        return value;
+    }
+
+    u8 radio::status() const{
+        const u8 rx_pipe = rx_fifo_.empty() ? 0b111 : rx_fifo_.front().pipe;
+        const u8 tx_full = tx_fifo_.size() >= fifo_depth ? 1 : 0;
+        return (regs_[STATUS] & STATUS_FLAGS) | static_cast<u8>(rx_pipe << 1) | tx_full;
+    }
+
+    u8 radio::fifo_status() const{
+        u8 value = 0;
+        if (reuse_tx_) value |= 1 << 6;
+        if (tx_fifo_.size() >= fifo_depth) value |= 1 << 5;
+        if (tx_fifo_.empty()) value |= 1 << 4;
+        if (rx_fifo_.size() >= fifo_depth) value |= 1 << 1;
+        if (rx_fifo_.empty()) value |= 1 << 0;
+        return value;
+    }
+
+    u8 radio::address_width() const{
+        const u8 setting = regs_[SETUP_AW] & 0x03;
+        return setting == 0 ? 3 : static_cast<u8>(setting + 2);
+    }
+
+    u8 radio::rate() const{
+        if (regs_[RF_SETUP] & (1 << 5)) return 0;   // RF_DR_LOW, 250 kbps
+        if (regs_[RF_SETUP] & (1 << 3)) return 2;   // RF_DR_HIGH, 2 Mbps
+        return 1;                                   // 1 Mbps
+    }
+
+    u8 radio::crc_bytes() const{
+        // EN_CRC is forced high while any pipe has auto acknowledge enabled
+        if (!(regs_[CONFIG] & EN_CRC) && (regs_[EN_AA] & 0x3F) == 0) return 0;
+        return (regs_[CONFIG] & CRCO) ? 2 : 1;
+    }
+
+    bool radio::dynamic_payloads(u8 pipe) const{
+        return (regs_[FEATURE] & EN_DPL) && (regs_[DYNPD] & (1 << pipe));
+    }
+
+    bool radio::auto_ack(u8 pipe) const{
+        return regs_[EN_AA] & (1 << pipe);
+    }
+
+    bool radio::irq_asserted() const{
+        const u8 unmasked = static_cast<u8>(~regs_[CONFIG]) & IRQ_MASK_BITS;
+        return (regs_[STATUS] & STATUS_FLAGS & unmasked) != 0;
+    }
+
+    void radio::set_flags(u8 flags){
+        regs_[STATUS] |= flags & STATUS_FLAGS;
+    }
+
+    void radio::sync_irq(){
+        const bool asserted = irq_asserted();
+        if (asserted == irq_reported_ || irq_pin_ < 0) return;
+        irq_reported_ = asserted;
+        if (asserted) {
+            counters_.irq_edges++;
+        }
+        esp_host::drive_gpio_input(irq_pin_, asserted ? 0 : 1);
+    }
+
+    void radio::read_register(u8 address, u8* out, size_t length) const{
+        if (length == 0) return;
+        memset(out, 0x00, length);
+
+        const std::array<u8, max_address_width>* multi_byte = nullptr;
+        if (address == RX_ADDR_P0) multi_byte = &rx_addr_p0_;
+        if (address == RX_ADDR_P1) multi_byte = &rx_addr_p1_;
+        if (address == TX_ADDR) multi_byte = &tx_addr_;
+        if (multi_byte) {
+            memcpy(out, multi_byte->data(), std::min<size_t>(length, max_address_width));
+            return;
+        }
+
+        switch (address) {
+            case STATUS:      out[0] = status(); break;
+            case FIFO_STATUS: out[0] = fifo_status(); break;
+            case RPD:         out[0] = rpd_ ? 1 : 0; break;
+            default:
+                if (address < register_count) out[0] = regs_[address];
+                break;
+        }
+    }
+
+    void radio::write_register(u8 address, const u8* data, size_t length){
+        if (length == 0 || data == nullptr) return;
+
+        std::array<u8, max_address_width>* multi_byte = nullptr;
+        if (address == RX_ADDR_P0) multi_byte = &rx_addr_p0_;
+        if (address == RX_ADDR_P1) multi_byte = &rx_addr_p1_;
+        if (address == TX_ADDR) multi_byte = &tx_addr_;
+        if (multi_byte) {
+            memcpy(multi_byte->data(), data, std::min<size_t>(length, max_address_width));
+            return;
+        }
+
+        switch (address) {
+            case STATUS:
+                regs_[STATUS] &= static_cast<u8>(~(data[0] & STATUS_FLAGS));    // write 1 to clear
+                update();   // a cleared MAX_RT lets a pending packet go out
+                break;
+            case OBSERVE_TX:
+            case RPD:
+            case FIFO_STATUS:
+                break;  // read only
+            case RF_CH:
+                regs_[RF_CH] = data[0] & 0x7F;
+                regs_[OBSERVE_TX] &= 0x0F;  // writing RF_CH resets PLOS_CNT
+                break;
+            case CONFIG:
+                regs_[CONFIG] = data[0] & 0x7F;
+                update();
+                break;
+            default:
+                if (address >= RX_PW_P0 && address < RX_PW_P0 + 6) {
+                    regs_[address] = data[0] & 0x3F;
+                } else if (address < register_count) {
+                    regs_[address] = data[0];
+                }
+                break;
+        }
+    }
+
+    void radio::spi_transfer(const u8* tx, u8* rx, size_t length){
+        if (length == 0) return;
+
+        const u8 command = tx ? tx[0] : 0x00;
+        const command_kind kind = classify(command);
+        const u8* arguments = tx ? tx + 1 : nullptr;
+        const size_t argument_length = length - 1;
+
+        u8 out[1 + max_payload_size + 8] = {};
+        const size_t out_length = std::min(length, sizeof(out));
+        out[0] = status();  // STATUS is always clocked out with the command byte
+
+        switch (kind) {
+            case command_kind::R_REGISTER:
+                read_register(command & 0x1F, out + 1, std::min(argument_length, out_length - 1));
+                break;
+            case command_kind::W_REGISTER:
+                write_register(command & 0x1F, arguments, argument_length);
+                break;
+            case command_kind::R_RX_PAYLOAD:
+                if (!rx_fifo_.empty()) {
+                    const rx_entry_T& entry = rx_fifo_.front();
+                    memcpy(out + 1, entry.data.data(), std::min<size_t>(std::min(argument_length, out_length - 1), entry.length));
+                    rx_fifo_.pop_front();
+                }
+                break;
+            case command_kind::W_TX_PAYLOAD:
+            case command_kind::W_TX_PAYLOAD_NOACK:
+            case command_kind::W_ACK_PAYLOAD:
+            {
+                if (kind == command_kind::W_ACK_PAYLOAD && !(regs_[FEATURE] & EN_ACK_PAY)) break;
+                if (tx_fifo_.size() >= fifo_depth || arguments == nullptr) break;
+                tx_entry_T entry{};
+                entry.pipe = command & 0x07;
+                entry.length = static_cast<u8>(std::min<size_t>(argument_length, max_payload_size));
+                entry.no_ack = kind == command_kind::W_TX_PAYLOAD_NOACK && (regs_[FEATURE] & EN_DYN_ACK);
+                entry.pid = tx_pid_;
+                tx_pid_ = (tx_pid_ + 1) & 0x03;
+                memcpy(entry.data.data(), arguments, entry.length);
+                tx_fifo_.push_back(entry);
+                reuse_tx_ = false;
+                update();
+                break;
+            }
+            case command_kind::FLUSH_TX:
+                tx_fifo_.clear();
+                reuse_tx_ = false;
+                break;
+            case command_kind::FLUSH_RX:
+                rx_fifo_.clear();
+                break;
+            case command_kind::REUSE_TX_PL:
+                reuse_tx_ = true;
+                break;
+            case command_kind::R_RX_PL_WID:
+                if (out_length > 1) out[1] = rx_fifo_.empty() ? 0 : rx_fifo_.front().length;
+                break;
+            default:
+                break;
+        }
+
+        if (rx) {
+            memset(rx, 0x00, length);
+            memcpy(rx, out, out_length);
+        }
+
+        const size_t index = static_cast<size_t>(kind);
+        ++spi_counters_.transactions;
+        spi_counters_.bytes += static_cast<uint32_t>(length);
+        ++spi_counters_.transactions_by_command[index];
+        spi_counters_.bytes_by_command[index] += static_cast<uint32_t>(length);
+    }
+
+    void radio::set_ce(bool level){
+        if (level == ce_) return;
+        ce_ = level;
+        update();
+    }
+
+    void radio::enter(radio_state state){
+        state_ = state;
+        ++generation_;
+        if (state == radio_state::Rx) {
+            rx_since_us_ = air_.now();
+            rpd_ = air_.config().strong_signal && air_.carrier(regs_[RF_CH], rx_since_us_);
+        }
+    }
+
+    void radio::schedule(int64_t delay_us, const std::function<void()>& action){
+        const uint32_t generation = generation_;
+        air_.schedule_at(air_.now() + delay_us, this, [this, generation, action]{
+            if (generation == generation_) action();
+        });
+    }
+
+    void radio::update(){
+        const bool powered = regs_[CONFIG] & PWR_UP;
+        const bool prim_rx = regs_[CONFIG] & PRIM_RX;
+
+        if (!powered) {
+            if (state_ != radio_state::PowerDown) enter(radio_state::PowerDown);
+            return;
+        }
+
+        switch (state_) {
+            case radio_state::PowerDown:
+                enter(radio_state::StartUp);
+                schedule(power_down_to_standby_us, [this]{
+                    enter(radio_state::StandbyI);
+                    update();
+                });
+                return;
+
+            case radio_state::StandbyI:
+            case radio_state::StandbyII:
+                if (!ce_) {
+                    if (state_ == radio_state::StandbyII) enter(radio_state::StandbyI);
+                    return;
+                }
+                if (prim_rx) {
+                    enter(radio_state::RxSettling);
+                    schedule(standby_to_active_us, [this]{ enter(radio_state::Rx); });
+                    return;
+                }
+                if (!tx_fifo_.empty() && !(regs_[STATUS] & MAX_RT)) {
+                    enter(radio_state::TxSettling);
+                    schedule(standby_to_active_us, [this]{
+                        retransmits_ = 0;
+                        start_transmission();
+                    });
+                    return;
+                }
+                if (state_ == radio_state::StandbyI) enter(radio_state::StandbyII);
+                return;
+
+            case radio_state::RxSettling:
+            case radio_state::Rx:
+                if (!ce_) {
+                    enter(radio_state::StandbyI);
+                } else if (!prim_rx) {
+                    enter(radio_state::StandbyII);
+                    update();
+                }
+                return;
+
+            default:
+                // StartUp and the TX/ACK states run to completion regardless of CE
+                return;
+        }
+    }
+
+    void radio::start_transmission(){
+        if (tx_fifo_.empty()) {
+            enter(radio_state::StandbyII);
+            update();
+            return;
+        }
+
+        const tx_entry_T& entry = tx_fifo_.front();
+        frame_T frame{};
+        frame.sender = this;
+        frame.channel = regs_[RF_CH];
+        frame.rate = rate();
+        frame.crc_bytes = crc_bytes();
+        frame.address_width = address_width();
+        frame.address = tx_addr_;
+        frame.payload = entry.data;
+        frame.length = entry.length;
+        frame.pid = entry.pid;
+        frame.dynamic_length = dynamic_payloads(0);
+        frame.no_ack = entry.no_ack;
+        frame.start_us = air_.now();
+        frame.end_us = frame.start_us + air::airtime_us(frame.rate, frame.address_width, frame.length, frame.crc_bytes);
+
+        enter(radio_state::Tx);
+        rpd_ = false;
+        ++counters_.frames_sent;
+        air_.transmit(frame);
+
+        schedule(frame.end_us - frame.start_us, [this]{ transmission_finished(); });
+    }
+
+    void radio::transmission_finished(){
+        const bool needs_ack = auto_ack(0) && !tx_fifo_.front().no_ack;
+
+        if (!needs_ack) {
+            if (!reuse_tx_) tx_fifo_.pop_front();
+            set_flags(TX_DS);
+            enter(radio_state::StandbyII);
+            update();
+            return;
+        }
+
+        // the receiver answers after its own 130us turnaround, ARD bounds the wait
+        enter(radio_state::AckWait);
+        const int64_t retransmit_delay_us = ((regs_[SETUP_RETR] >> 4) + 1) * 250;
+        schedule(retransmit_delay_us, [this]{ ack_timeout(); });
+    }
+
+    void radio::ack_timeout(){
+        const u8 retransmit_limit = regs_[SETUP_RETR] & 0x0F;
+        if (retransmits_ < retransmit_limit) {
+            ++retransmits_;
+            ++counters_.retransmits;
+            regs_[OBSERVE_TX] = (regs_[OBSERVE_TX] & 0xF0) | (retransmits_ & 0x0F);
+            start_transmission();
+            return;
+        }
+
+        const u8 lost = std::min(15, (regs_[OBSERVE_TX] >> 4) + 1);
+        regs_[OBSERVE_TX] = static_cast<u8>(lost << 4) | (retransmits_ & 0x0F);
+        ++counters_.max_rt_events;
+        set_flags(MAX_RT);  // the payload stays in the TX FIFO until flushed
+        enter(radio_state::StandbyII);
+        update();
+    }
+
+    void radio::ack_received(const frame_T& ack){
+        tx_fifo_.pop_front();
+        ++counters_.acks_received;
+        rpd_ = air_.config().strong_signal;    // on a transmitter RPD reports the ACK it just received
+        regs_[OBSERVE_TX] = (regs_[OBSERVE_TX] & 0xF0) | (retransmits_ & 0x0F);
+
+        u8 flags = TX_DS;
+        if (ack.length > 0) {
+            if (rx_fifo_.size() < fifo_depth) {
+                rx_entry_T entry{};
+                entry.pipe = 0;
+                entry.length = ack.length;
+                entry.data = ack.payload;
+                rx_fifo_.push_back(entry);
+                flags |= RX_DR;
+            } else {
+                ++counters_.rx_fifo_overflows;
+            }
+        }
+        set_flags(flags);
+        enter(radio_state::StandbyII);
+        update();
+    }
+
+    int radio::match_pipe(const frame_T& frame) const{
+        const u8 width = address_width();
+        if (frame.address_width != width) return -1;
+
+        const u8 enabled = regs_[EN_RXADDR];
+        if ((enabled & 0x01) && memcmp(frame.address.data(), rx_addr_p0_.data(), width) == 0) return 0;
+        if ((enabled & 0x02) && memcmp(frame.address.data(), rx_addr_p1_.data(), width) == 0) return 1;
+
+        // pipes 2-5 only own their LSByte, the upper bytes are shared with pipe 1
+        if (memcmp(frame.address.data() + 1, rx_addr_p1_.data() + 1, width - 1) != 0) return -1;
+        for (u8 pipe = 2; pipe < 6; ++pipe) {
+            if ((enabled & (1 << pipe)) && frame.address[0] == regs_[RX_ADDR_P0 + pipe]) return pipe;
+        }
+        return -1;
+    }
+
+    void radio::receive(const frame_T& frame){
+        if (frame.channel != regs_[RF_CH] || frame.rate != rate()) return;
+
+        if (frame.is_ack) {
+            if (state_ != radio_state::AckWait) return;
+            if (frame.address_width != address_width()) return;
+            if (memcmp(frame.address.data(), rx_addr_p0_.data(), frame.address_width) != 0) return;
+            ack_received(frame);
+            return;
+        }
+
+        if (state_ != radio_state::Rx || rx_since_us_ > frame.start_us) return;
+
+        const int pipe = match_pipe(frame);
+        if (pipe < 0) {
+            ++counters_.address_mismatches;
+            return;
+        }
+        if (frame.crc_bytes != crc_bytes()) return;
+
+        if (dynamic_payloads(pipe) != frame.dynamic_length) return;
+        if (!frame.dynamic_length && regs_[RX_PW_P0 + pipe] != frame.length) return;
+
+        const bool needs_ack = auto_ack(pipe) && !frame.no_ack;
+        const uint32_t checksum = payload_checksum(frame.payload.data(), frame.length);
+        const bool duplicate = needs_ack && last_rx_pid_[pipe] == frame.pid && last_rx_checksum_[pipe] == checksum;
+
+        if (!duplicate) {
+            if (rx_fifo_.size() >= fifo_depth) {
+                ++counters_.rx_fifo_overflows;
+                return;
+            }
+            rx_entry_T entry{};
+            entry.pipe = static_cast<u8>(pipe);
+            entry.length = frame.length;
+            entry.data = frame.payload;
+            rx_fifo_.push_back(entry);
+            ++counters_.frames_received;
+            set_flags(RX_DR);
+            last_rx_pid_[pipe] = frame.pid;
+            last_rx_checksum_[pipe] = checksum;
+        }
+
+        if (needs_ack) send_ack(static_cast<u8>(pipe), frame, duplicate);
+    }
+
+    void radio::send_ack(u8 pipe, const frame_T& frame, bool duplicate){
+        enter(radio_state::AckTx);
+        schedule(standby_to_active_us, [this, pipe, frame, duplicate]{
+            frame_T ack{};
+            ack.sender = this;
+            ack.channel = frame.channel;
+            ack.rate = frame.rate;
+            ack.crc_bytes = frame.crc_bytes;
+            ack.address_width = frame.address_width;
+            ack.address = frame.address;
+            ack.pid = frame.pid;
+            ack.dynamic_length = true;
+            ack.is_ack = true;
+
+            const bool ack_payloads = (regs_[FEATURE] & EN_ACK_PAY) && (regs_[FEATURE] & EN_DPL);
+            if (ack_payloads && !duplicate) {
+                auto queued = std::find_if(tx_fifo_.begin(), tx_fifo_.end(),
+                                           [pipe](const tx_entry_T& entry){ return entry.pipe == pipe; });
+                if (queued != tx_fifo_.end()) {
+                    ack.payload = queued->data;
+                    ack.length = queued->length;
+                    tx_fifo_.erase(queued);
+                }
+            }
+
+            ack.start_us = air_.now();
+            ack.end_us = ack.start_us + air::airtime_us(ack.rate, ack.address_width, ack.length, ack.crc_bytes);
+            ++counters_.acks_sent;
+            air_.transmit(ack);
+
+            schedule(ack.end_us - ack.start_us, [this]{
+                enter(radio_state::Rx);
+                update();
+            });
+        });
+    }
+
+
+    // ---------------------------------------------------------------- air
+
+    air::air(const air_config_T& config):
+        config_(config), rng_(config.seed)
+    {
+        esp_host::install_backend(this);
+    }
+
+    air::~air(){
+        esp_host::remove_backend(this);
+    }
+
+    void air::set_config(const air_config_T& config){
+        config_ = config;
+        rng_.seed(config.seed);
+    }
+
+    int64_t air::now() const{
+        return in_event_ ? event_time_us_ : esp_host::now_us();
+    }
+
+    int64_t air::airtime_us(u8 rate, u8 address_width, u8 payload_length, u8 crc_bytes){
+        // preamble + address + payload + CRC, plus the 9 bit packet control field
+        const int64_t bits = 8 * (1 + address_width + payload_length + crc_bytes) + 9;
+        const int64_t bits_per_second = rate == 0 ? 250000 : (rate == 2 ? 2000000 : 1000000);
+        return (bits * 1000000 + bits_per_second - 1) / bits_per_second;
+    }
+
+    bool air::carrier(u8 channel, int64_t at_us) const{
+        for (const frame_T& frame : history_) {
+            if (frame.channel == channel && frame.start_us <= at_us && at_us < frame.end_us) return true;
+        }
+        return false;
+    }
+
+    radio* air::find_by_csn(int pin) const{
+        for (radio* r : radios_) {
+            if (r->csn_pin() == pin) return r;
+        }
+        return nullptr;
+    }
+
+    void air::attach(radio* r){
+        radios_.push_back(r);
+    }
+
+    void air::detach(radio* r){
+        radios_.erase(std::remove(radios_.begin(), radios_.end(), r), radios_.end());
+        for (auto it = events_.begin(); it != events_.end();) {
+            it = it->second.owner == r ? events_.erase(it) : std::next(it);
+        }
+    }
+
+    void air::schedule_at(int64_t at_us, const radio* owner, const std::function<void()>& action){
+        events_.emplace(at_us, event_T{owner, action});
+    }
+
+    void air::transmit(const frame_T& frame){
+        ++counters_.frames;
+        history_.push_back(frame);
+        for (radio* r : radios_) {
+            if (config_.strong_signal && r != frame.sender && r->state_ == radio_state::Rx && r->regs_[RF_CH] == frame.channel) {
+                r->rpd_ = true;
+            }
+        }
+        schedule_at(frame.end_us + config_.latency_us, nullptr, [this, frame]{ deliver(frame); });
+    }
+
+    bool air::collided(const frame_T& frame) const{
+        for (const frame_T& other : history_) {
+            if (other.sender == frame.sender || other.channel != frame.channel) continue;
+            if (other.start_us < frame.end_us && frame.start_us < other.end_us) return true;
+        }
+        return false;
+    }
+
+    void air::deliver(const frame_T& frame){
+        if (collided(frame)) {
+            ++counters_.collisions;
+            return;
+        }
+
+        std::uniform_real_distribution<double> roll(0.0, 1.0);
+        for (radio* r : radios_) {
+            if (r == frame.sender || r->regs_[RF_CH] != frame.channel) continue;
+            if (r->state_ != radio_state::Rx && r->state_ != radio_state::AckWait) continue;
+            if (config_.loss_probability > 0.0 && roll(rng_) < config_.loss_probability) {
+                ++counters_.losses;
+                continue;
+            }
+            ++counters_.deliveries;
+            r->receive(frame);
+        }
+    }
+
+    void air::sync_irq_lines(){
+        for (radio* r : radios_) {
+            r->sync_irq();
+        }
+    }
+
+    void air::on_spi_transfer(int cs_pin, const uint8_t* tx, uint8_t* rx, size_t length){
+        radio* r = find_by_csn(cs_pin);
+        if (r) {
+            r->spi_transfer(tx, rx, length);
+        } else if (rx) {
+            memset(rx, 0xFF, length);   // nothing drives MISO
+        }
+        sync_irq_lines();
+    }
+
+    void air::on_gpio_write(int pin, int level){
+        for (radio* r : radios_) {
+            if (r->ce_pin() == pin) r->set_ce(level != 0);
+        }
+        sync_irq_lines();
+    }
+
+    int air::on_gpio_read(int pin){
+        for (radio* r : radios_) {
+            if (r->ce_pin() == pin) return r->ce() ? 1 : 0;
+            if (r->irq_pin() == pin) return r->irq_asserted() ? 0 : 1;
+        }
+        return -1;
+    }
+
+    void air::on_time_advanced(int64_t now_us){
+        while (!events_.empty() && events_.begin()->first <= now_us) {
+            auto next = events_.begin();
+            const int64_t at_us = next->first;
+            const std::function<void()> action = next->second.action;
+            events_.erase(next);
+
+            in_event_ = true;
+            event_time_us_ = at_us;
+            action();
+            sync_irq_lines();
+            in_event_ = false;
+        }
+
+        while (!history_.empty() && history_.front().end_us + config_.latency_us + history_window_us < now_us) {
+            history_.pop_front();
+        }
+    }
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+/**
+ * @brief Cycle-approximate nRF24L01+ model for host builds.
+ *
+ * Every radio keeps the register file dump_all_registers lists, 3-deep TX/RX FIFOs,
+ * STATUS/FIFO_STATUS semantics and the PowerDown/Standby/RX/TX state timing from the
+ * datasheet. Radios are linked through an air object which delivers frames between them
+ * with configurable loss and latency, and which stands in as the esp_host backend so the
+ * real spi_object/NRF24 code drives the models through GPIO and SPI.
+ */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "esp_host.hpp"
+
+namespace nrf_emu{
+
+    using u8 = uint8_t;
+
+    inline constexpr u8 register_count = 0x1E;
+    inline constexpr u8 fifo_depth = 3;
+    inline constexpr u8 max_payload_size = 32;
+    inline constexpr u8 max_address_width = 5;
+
+    /**
+     * @brief datasheet timings in microseconds
+     */
+    inline constexpr int64_t power_down_to_standby_us = 1500;
+    inline constexpr int64_t standby_to_active_us = 130;
+    inline constexpr int64_t min_ce_pulse_us = 10;
+
+    enum class radio_state :u8{
+        PowerDown,
+        StartUp,
+        StandbyI,
+        StandbyII,
+        RxSettling,
+        Rx,
+        TxSettling,
+        Tx,
+        AckWait,
+        AckTx
+    };
+
+    /**
+     * @brief SPI command classes used to break down the wire cost of driver calls
+     */
+    enum class command_kind :u8{
+        R_REGISTER,
+        W_REGISTER,
+        R_RX_PAYLOAD,
+        W_TX_PAYLOAD,
+        FLUSH_TX,
+        FLUSH_RX,
+        REUSE_TX_PL,
+        R_RX_PL_WID,
+        W_ACK_PAYLOAD,
+        W_TX_PAYLOAD_NOACK,
+        NOP,
+        Unknown,
+        Count
+    };
+
+    const char* command_name(command_kind kind);
+
+    struct spi_counters_T{
+        uint32_t transactions = 0;
+        uint32_t bytes = 0;
+        std::array<uint32_t, static_cast<size_t>(command_kind::Count)> transactions_by_command{};
+        std::array<uint32_t, static_cast<size_t>(command_kind::Count)> bytes_by_command{};
+    };
+
+    struct radio_counters_T{
+        uint32_t frames_sent = 0;
+        uint32_t frames_received = 0;
+        uint32_t acks_sent = 0;
+        uint32_t acks_received = 0;
+        uint32_t retransmits = 0;
+        uint32_t max_rt_events = 0;
+        uint32_t rx_fifo_overflows = 0;
+        uint32_t address_mismatches = 0;
+        uint32_t irq_edges = 0;         // falling edges driven on the IRQ pin
+    };
+
+    struct frame_T{
+        const class radio* sender = nullptr;
+        u8 channel = 0;
+        u8 rate = 0;
+        u8 crc_bytes = 0;
+        u8 address_width = 0;
+        std::array<u8, max_address_width> address{};
+        std::array<u8, max_payload_size> payload{};
+        u8 length = 0;
+        u8 pid = 0;
+        bool dynamic_length = false;
+        bool no_ack = false;
+        bool is_ack = false;
+        int64_t start_us = 0;
+        int64_t end_us = 0;
+    };
+
+    struct air_config_T{
+        double loss_probability = 0.0;  // chance any single receiver misses a frame
+        int64_t latency_us = 0;         // extra delay between end of frame and delivery
+        uint32_t seed = 0x2401;
+        bool strong_signal = true;      // frames raise RPD at their receivers, false models a link below -64 dBm
+    };
+
+    struct air_counters_T{
+        uint32_t frames = 0;
+        uint32_t deliveries = 0;
+        uint32_t losses = 0;
+        uint32_t collisions = 0;
+    };
+
+    class air;
+
+
+    class radio{
+        public:
+            /**
+             * @param medium air the radio transmits into
+             * @param csn_pin spics_io_num of the spi_object the driver uses for this radio
+             * @param ce_pin Pins_T::CE of the driver
+             * @param irq_pin Pins_T::IRQ of the driver, GPIO_NUM_NC (-1) if unused
+             */
+            radio(air& medium, int csn_pin, int ce_pin, int irq_pin = -1);
+            ~radio();
+
+            radio(const radio&) = delete;
+            radio& operator=(const radio&) = delete;
+
+            /**
+             * @brief one CSN-low to CSN-high SPI transaction, rx may be nullptr
+             */
+            void spi_transfer(const u8* tx, u8* rx, size_t length);
+
+            void set_ce(bool level);
+            bool ce() const { return ce_; }
+
+            /**
+             * @return true while the active-low IRQ line is pulled down
+             */
+            bool irq_asserted() const;
+
+            int csn_pin() const { return csn_pin_; }
+            int ce_pin() const { return ce_pin_; }
+            int irq_pin() const { return irq_pin_; }
+
+            radio_state state() const { return state_; }
+            u8 reg(u8 address) const;
+            size_t rx_fifo_count() const { return rx_fifo_.size(); }
+            size_t tx_fifo_count() const { return tx_fifo_.size(); }
+
+            const spi_counters_T& spi_counters() const { return spi_counters_; }
+            const radio_counters_T& counters() const { return counters_; }
+            void reset_counters();
+
+        private:
+            friend class air;
+
+            struct rx_entry_T{
+                u8 pipe;
+                u8 length;
+                std::array<u8, max_payload_size> data;
+            };
+
+            struct tx_entry_T{
+                u8 pipe;    // ack payload pipe when used as PRX, unused as PTX
+                u8 length;
+                u8 pid;
+                bool no_ack;
+                std::array<u8, max_payload_size> data;
+            };
+
+            air& air_;
+            const int csn_pin_;
+            const int ce_pin_;
+            const int irq_pin_;
+
+            std::array<u8, register_count> regs_{};
+            std::array<u8, max_address_width> rx_addr_p0_{};
+            std::array<u8, max_address_width> rx_addr_p1_{};
+            std::array<u8, max_address_width> tx_addr_{};
+
+            std::deque<rx_entry_T> rx_fifo_;
+            std::deque<tx_entry_T> tx_fifo_;
+
+            radio_state state_ = radio_state::PowerDown;
+            uint32_t generation_ = 0;   // bumped on every state change, stale events are dropped
+            bool ce_ = false;
+            bool irq_reported_ = false;
+            int64_t rx_since_us_ = 0;
+            bool rpd_ = false;
+
+            u8 tx_pid_ = 0;
+            u8 retransmits_ = 0;
+            std::array<int, 6> last_rx_pid_{};
+            std::array<uint32_t, 6> last_rx_checksum_{};
+            bool reuse_tx_ = false;
+
+            spi_counters_T spi_counters_;
+            radio_counters_T counters_;
+
+            void reset();
+            void write_register(u8 address, const u8* data, size_t length);
+            void read_register(u8 address, u8* out, size_t length) const;
+
+            u8 status() const;
+            u8 fifo_status() const;
+            u8 address_width() const;
+            u8 rate() const;
+            u8 crc_bytes() const;
+            bool dynamic_payloads(u8 pipe) const;
+            bool auto_ack(u8 pipe) const;
+            int match_pipe(const frame_T& frame) const;
+
+            void enter(radio_state state);
+            void schedule(int64_t delay_us, const std::function<void()>& action);
+            void update();
+
+            void start_transmission();
+            void transmission_finished();
+            void ack_timeout();
+            void ack_received(const frame_T& ack);
+
+            void receive(const frame_T& frame);
+            void send_ack(u8 pipe, const frame_T& frame, bool duplicate);
+
+            void set_flags(u8 flags);
+
+            /**
+             * @brief reports IRQ level changes to esp_host so attached ISRs see the edge
+             */
+            void sync_irq();
+    };
+
+
+    class air : public esp_host::backend_T{
+        public:
+            explicit air(const air_config_T& config = {});
+            ~air() override;
+
+            air(const air&) = delete;
+            air& operator=(const air&) = delete;
+
+            void set_config(const air_config_T& config);
+            const air_config_T& config() const { return config_; }
+            const air_counters_T& counters() const { return counters_; }
+
+            /**
+             * @brief time of the event being processed, or the virtual clock outside of events
+             */
+            int64_t now() const;
+
+            /**
+             * @brief on-air duration of a frame in microseconds including preamble and packet control field
+             */
+            static int64_t airtime_us(u8 rate, u8 address_width, u8 payload_length, u8 crc_bytes);
+
+            /**
+             * @brief true if a frame is on air on the channel at the given time
+             */
+            bool carrier(u8 channel, int64_t at_us) const;
+
+            radio* find_by_csn(int pin) const;
+
+            void on_spi_transfer(int cs_pin, const uint8_t* tx, uint8_t* rx, size_t length) override;
+            void on_gpio_write(int pin, int level) override;
+            int on_gpio_read(int pin) override;
+            void on_time_advanced(int64_t now_us) override;
+
+        private:
+            friend class radio;
+
+            struct event_T{
+                const radio* owner;     // nullptr for events owned by the air itself
+                std::function<void()> action;
+            };
+
+            air_config_T config_;
+            air_counters_T counters_;
+            std::vector<radio*> radios_;
+            std::multimap<int64_t, event_T> events_;
+            std::deque<frame_T> history_;   // recent frames, used for collisions and carrier detect
+            std::mt19937 rng_;
+            bool in_event_ = false;
+            int64_t event_time_us_ = 0;
+
+            void attach(radio* r);
+            void detach(radio* r);
+            void schedule_at(int64_t at_us, const radio* owner, const std::function<void()>& action);
+            void transmit(const frame_T& frame);
+            void deliver(const frame_T& frame);
+            bool collided(const frame_T& frame) const;
+            void sync_irq_lines();
+    };
+}
@@ -0,0 +1,153 @@
+// Turns an exported trace_ring into text.
+//
+//   g++ -std=c++17 -Ihost -I. host/nrf_trace_decode.cpp -o nrf_trace_decode
+//   ./nrf_trace_decode < console.log        NRFTRACE lines from trace_ring::dump, anything else is skipped
+//   ./nrf_trace_decode -b trace.bin         raw trace_record_T array, e.g. a snapshot written to flash
+
+#include "nrf_trace.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+const char* register_name(u8 address) {
+    static constexpr const char* names[] = {
+        "CONFIG", "EN_AA", "EN_RXADDR", "SETUP_AW", "SETUP_RETR", "RF_CH", "RF_SETUP", "STATUS",
+        "OBSERVE_TX", "RPD", "RX_ADDR_P0", "RX_ADDR_P1", "RX_ADDR_P2", "RX_ADDR_P3", "RX_ADDR_P4", "RX_ADDR_P5",
+        "TX_ADDR", "RX_PW_P0", "RX_PW_P1", "RX_PW_P2", "RX_PW_P3", "RX_PW_P4", "RX_PW_P5", "FIFO_STATUS",
+        "0x18", "0x19", "0x1A", "0x1B", "DYNPD", "FEATURE"
+    };
+    return address < sizeof(names) / sizeof(names[0]) ? names[address] : "?";
+}
+
+std::string command_name(u8 command) {
+    switch (command) {
+        case 0x50: return "ACTIVATE";
+        case 0x60: return "R_RX_PL_WID";
+        case 0x61: return "R_RX_PAYLOAD";
+        case 0xA0: return "W_TX_PAYLOAD";
+        case 0xB0: return "W_TX_PAYLOAD_NOACK";
+        case 0xE1: return "FLUSH_TX";
+        case 0xE2: return "FLUSH_RX";
+        case 0xE3: return "REUSE_TX_PL";
+        case 0xFF: return "NOP";
+        default: break;
+    }
+    if ((command & 0xF8) == 0xA8 && (command & 0x07) < 6) {
+        return "W_ACK_PAYLOAD P" + std::to_string(command & 0x07);
+    }
+    char hex[8];
+    snprintf(hex, sizeof(hex), "0x%02X", command);
+    return hex;
+}
+
+std::string status_text(u8 status) {
+    std::string text;
+    if (status & 0x40) text += " RX_DR";
+    if (status & 0x20) text += " TX_DS";
+    if (status & 0x10) text += " MAX_RT";
+    const u8 pipe = (status >> 1) & 0x07;
+    text += pipe == 7 ? " RX_EMPTY" : " RX_P" + std::to_string(pipe);
+    if (status & 0x01) text += " TX_FULL";
+    return text;
+}
+
+void print_record(const trace_record_T& record, uint32_t previous_us, bool first) {
+    const uint32_t delta_us = first ? 0 : record.timestamp_us - previous_us; // unsigned, survives the 32 bit wrap
+    printf("%10u us +%-7u %-10s", static_cast<unsigned>(record.timestamp_us), static_cast<unsigned>(delta_us),
+           trace_event_name(record.event));
+
+    switch (static_cast<Trace_Event>(record.event)) {
+        case Trace_Event::Register_Read:
+            printf(" %-11s = 0x%02X", register_name(record.reg), record.value);
+            break;
+        case Trace_Event::Register_Write:
+        case Trace_Event::Mode_Rx:
+        case Trace_Event::Mode_Tx:
+            printf(" %-11s <- 0x%02X", register_name(record.reg), record.value);
+            break;
+        case Trace_Event::Command:
+            printf(" %s, %u bytes", command_name(record.reg).c_str(), record.value);
+            break;
+        case Trace_Event::Spi_Error:
+            printf(" %s, %u bytes", command_name(record.reg).c_str(), record.value);
+            break;
+        case Trace_Event::Tx_Sent:
+        case Trace_Event::Tx_Failed:
+            printf(" packet %u", record.value);
+            break;
+        case Trace_Event::Rx_Drain:
+            printf(" %u packets", record.value);
+            break;
+        default:
+            break;
+    }
+    if (record.status != 0) {
+        printf("   STATUS 0x%02X%s", record.status, status_text(record.status).c_str());
+    }
+    printf("\n");
+}
+
+bool parse_line(const char* line, trace_record_T& record) {
+    const char* hex = strstr(line, "NRFTRACE ");
+    if (hex == nullptr) {
+        return false;
+    }
+    hex += strlen("NRFTRACE ");
+    if (strspn(hex, "0123456789abcdefABCDEF") != 2 * sizeof(trace_record_T)) {
+        return false; // the begin / end markers
+    }
+    u8 bytes[sizeof(trace_record_T)];
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        unsigned value = 0;
+        if (sscanf(hex + 2 * i, "%2x", &value) != 1) {
+            return false;
+        }
+        bytes[i] = static_cast<u8>(value);
+    }
+    memcpy(&record, bytes, sizeof(record));
+    return true;
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    std::vector<trace_record_T> records;
+
+    if (argc == 3 && strcmp(argv[1], "-b") == 0) {
+        FILE* file = fopen(argv[2], "rb");
+        if (file == nullptr) {
+            fprintf(stderr, "cannot open %s\n", argv[2]);
+            return 1;
+        }
+        trace_record_T record;
+        while (fread(&record, sizeof(record), 1, file) == 1) {
+            records.push_back(record);
+        }
+        fclose(file);
+    } else if (argc == 1) {
+        char line[256];
+        trace_record_T record;
+        while (fgets(line, sizeof(line), stdin) != nullptr) {
+            if (parse_line(line, record)) {
+                records.push_back(record);
+            }
+        }
+    } else {
+        fprintf(stderr, "usage: %s [-b trace.bin] < console.log\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t previous_us = 0;
+    for (size_t i = 0; i < records.size(); ++i) {
+        print_record(records[i], previous_us, i == 0);
+        previous_us = records[i].timestamp_us;
+    }
+    fprintf(stderr, "%zu records\n", records.size());
+    return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+/**
+ * @brief Host stand-in for the ROM busy-wait, advances the virtual clock.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void ets_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
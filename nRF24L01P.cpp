@@ -1,153 +1,374 @@
 #include "nRF24L01P.hpp"
+#include <algorithm> // for std::sort, std::stable_sort
+
+
+namespace {
+    // setup_config's register defaults, checked against the datasheet rules at compile time
+    constexpr rf_settings_T setup_rf_settings = { Data_Rate::Rate_250kbps, PA_Level::High_6dBm, 1500, 3 };
+    constexpr std::array<u8, nrf_map::max_address_bytes> setup_pipe_address = {0x03, 0x03, 0x03}; // experimenting (tx is odd and seems prone to changing)
+
+    constexpr nrf_map::register_image make_setup_image(){
+        using namespace nrf_map;
+        register_image image;
+        image.set<setup_aw::aw>(Address_Width::Bytes_3)
+             .set<setup_retr::ard>(setup_retr::ard_for_us(setup_rf_settings.retransmit_delay_us))
+             .set<setup_retr::arc>(setup_rf_settings.retransmit_count)
+             .set_address<rx_addr_p0>(setup_pipe_address)
+             .set_address<tx_addr>(setup_pipe_address)
+             .set<rf_setup::rf_dr>(setup_rf_settings.data_rate)
+             .set<rf_setup::rf_pwr>(setup_rf_settings.pa_level)
+             .set<rf_ch::channel>(2)
+             .set_value<feature>(0x00)                  // no EN_DPL, EN_ACK_PAY, EN_DYN_ACK
+             .set_value<dynpd>(0x00)                    // set_dynamic_payloads / configure_pipe turn DPL on
+             .set<rx_pw<0>::width>(32)
+             .set<rx_pw<1>::width>(32)
+             .set<en_rxaddr::pipes>(0b00000011)
+             .set_value<en_aa>(0x00);
+        return image;
+    }
+    constexpr radio_profile_T boot_profile("setup", make_setup_image()); // does not compile if the image breaks a datasheet rule
+}
 
 
 
 // Constructor with logging
-NRF24::NRF24(const spi_object& spi, const Pins_T& pins, u8 buffer_size):
-    spi_(spi), pins_layout(pins_data), buffer_size_(buffer_size)
+NRF24::NRF24(spi_object& spi, const Pins_T& pins, u8 buffer_size, const radio_clock_T& clock):
+    spi_(&spi), pins_layout(pins), buffer_size_(buffer_size), timing_(clock)
 {
-   
-    drop_ce_pin();
-    setup_config(Antenna_Mode::Recieve);
-    raise_ce_pin();
-
+    timing_.wait_power_on_reset(); // long over unless the radio is constructed right after boot
 
+    drop_ce_pin(); // state_ assumes CE low, the pin may still be high from before an MCU reset
+    state_since_us_ = timing_.now_us();
+    setup_config(Antenna_Mode::Recieve);
+    if (spi.settings().calibrate_clock) {
+        calibrate_spi_clock(); // CE is still low and no traffic has started, keeps the configured rate if none passes
+    }
+    enter_state(Radio_State::RxActive); // waits out the rest of Tpd2stby, the register writes of setup_config already took part of it
 
-    vTaskDelay(pdMS_TO_TICKS(5));
     //leave_standby();
-    printf("[NRF24] Initialization complete\n");
+    NRF_LOGI("[NRF24] Initialization complete\n");
+}
+
+NRF24::~NRF24(){
+    stop_irq_rx();
 }
 
 
 
 const bool NRF24::spi_command_wrapper(const u8& register_address, const u8& data_bytes_length, const u8* databytes)const{
 
-    const u8 full_buffer_size = data_bytes_length + sizeof(register_address);
-    const u8 *return_buffer = write_register(register_address, data_bytes_length, databytes);
+    const spi_frame_T response = write_register(register_address, data_bytes_length, databytes);
 
-    if(return_buffer!= nullptr){
-        printf("[NRF24] Write_register to address: %d returned: 0x%02X\n",register_address, return_buffer[0]);
-        memset(return_buffer, 0x00, full_buffer_size);
-        free(return_buffer);
+    if(response){
+        NRF_LOGD("[NRF24] Write_register to address: %d returned: 0x%02X\n",register_address, response.status());
         return true;
     } else {
-        printf("[NRF24] Error: write_register returned nullptr to address: %d\n",register_address);
+        NRF_LOGE("[NRF24] Error: write_register failed for address: %d\n",register_address);
         return false;
     }
 }
 
 
 bool NRF24::change_antenna_mode(const Antenna_Mode& requested_mode){
-    u8 config = 0;
-    printf("[NRF24::change_antenna_mode] Changing register 0x00 \n");
-    if(requested_mode == Antenna_Mode::Recieve){
-        printf("[NRF24::change_antenna_mode] Setting config to recieve\n");
-        config =  0b00000011;
-    }else if (requested_mode == Antenna_Mode::Transmit){
-        printf("[NRF24::change_antenna_mode] Setting config to transmit\n");
-        config = 0b00000010;
-    } else{
+    return write_config(requested_mode, state_ != Radio_State::PowerDown);
+}
+
+
+bool NRF24::write_config(Antenna_Mode direction, bool powered){
+    if (direction != Antenna_Mode::Recieve && direction != Antenna_Mode::Transmit) {
         return false;
     }
+    NRF_LOGD("[NRF24::write_config] Setting config to %s\n", direction == Antenna_Mode::Recieve ? "recieve" : "transmit");
+    const u8 config = nrf_map::compose<nrf_map::config>(nrf_map::config::pwr_up(powered), nrf_map::config::prim_rx(direction)) | irq_mask_;
 
-    const u8 config_register_address = 0x00;
+    constexpr u8 config_register_address = nrf_map::config::address;
 
-    bool antenna_mode_changed_successfully = spi_command_wrapper(config_register_address, sizeof(config), &config);
+    // through the cache, so a switch to the mode already in CONFIG costs no SPI transaction
+    const bool unchanged = shadow_length_[config_register_address] != 0 && shadow_registers_[config_register_address] == config;
+    bool antenna_mode_changed_successfully = write_register_cached(config_register_address, sizeof(config), &config);
+    if (!unchanged) {
+        state_stats_.config_writes++;
+        trace(direction == Antenna_Mode::Recieve ? Trace_Event::Mode_Rx : Trace_Event::Mode_Tx, config_register_address, 0, config);
+    }
+    if (antenna_mode_changed_successfully) {
+        mode_ = direction;
+    }
     return antenna_mode_changed_successfully;
 }
 
 
-const bool NRF24::setup_config(const Antenna_Mode& antenna_mode) {
-    // 1. Ensure CE LOW
+bool NRF24::enter_state(Radio_State target){
+    if (target >= Radio_State::Count) {
+        return false;
+    }
+    if (state_ == target) {
+        state_stats_.redundant++;
+        return true;
+    }
+    while (state_ != target) {
+        const Radio_State next = radio_transitions::next_step[static_cast<size_t>(state_)][static_cast<size_t>(target)];
+        if (!step_state(next)) {
+            return false;
+        }
+    }
+    return true;
+}
 
-    // 2. CONFIG: power up & PRIM_RX (1=RX, 0=TX)
-    u8 config_register_values =  0b00000011;  // PWR_UP=1, PRIM_RX=1 (RX mode)
-    spi_command_wrapper(NRF_regs::config_register_address, sizeof(config_register_values), &config_register_values);
-    vTaskDelay(pdMS_TO_TICKS(200));  // allow oscillator to stabilize
 
+bool NRF24::step_state(Radio_State next){
+    if (!radio_transitions::legal[static_cast<size_t>(state_)][static_cast<size_t>(next)]) {
+        NRF_LOGE("[NRF24::step_state] %s to %s is not a legal transition\n", radio_state_name(state_), radio_state_name(next));
+        return false;
+    }
+
+    const int64_t started_us = timing_.now_us();
+    const uint32_t started_spi_bytes = spi_->stats().bytes;
+    bool ok = true;
+    switch (next) {
+        case Radio_State::PowerDown:
+            set_ce(false);
+            ok = write_config(mode_, false);
+            timing_.powered_down();
+            break;
+
+        case Radio_State::StandbyI:
+            // leaving RX/TX is only CE, a pulsed TX already ended by itself
+            set_ce(false);
+            if (state_ == Radio_State::PowerDown) {
+                ok = write_config(mode_, true);
+                timing_.powered_up(); // the crystal needs Tpd2stby, registers can be written meanwhile, CE waits for it
+            }
+            break;
+
+        case Radio_State::RxActive:
+            ok = write_config(Antenna_Mode::Recieve, true);
+            if (ok) {
+                set_ce(true); // waits out Tpd2stby if the radio just powered up
+            }
+            break;
+
+        case Radio_State::StandbyII:
+        case Radio_State::TxActive:
+            // the same on the pins, the TX FIFO decides whether the radio sends or idles in standby-II
+            ok = write_config(Antenna_Mode::Transmit, true);
+            if (ok) {
+                set_ce(true);
+            }
+            break;
+
+        default:
+            return false;
+    }
+    if (!ok) {
+        NRF_LOGE("[NRF24::step_state] CONFIG write failed going %s to %s\n", radio_state_name(state_), radio_state_name(next));
+        return false;
+    }
+
+    record_transition(next, started_us, started_spi_bytes);
+    return true;
+}
 
-    // 3. Address width & retries
-    constexpr u8 address_width_values = 0b01;  // 5-byte addresses
-    spi_command_wrapper(NRF_regs::address_width_address, sizeof(address_width_values), &address_width_values);   // SETUP_AW
 
-    constexpr u8 retransmission_values = 0xF3;  // 1500us, 3 retries
-    spi_command_wrapper(NRF_regs::retransmit_details_address, sizeof(retransmission_values), &retransmission_values); // SETUP_RETR
+void NRF24::set_ce(bool high){
+    if (timing_.ce_high() == high) {
+        return;
+    }
+    if (high) {
+        raise_ce_pin();
+    } else {
+        drop_ce_pin();
+    }
+    state_stats_.ce_toggles++;
+}
 
-    // 4. Addresses
 
-    constexpr u8 address_width = 3;// must align with address_width_values, however their literal values will not match
-    constexpr u8 pipe_zero_values[address_width] = {0x03,0x03,0x03}; // experimenting (tx is odd and seems prone to changing)
+void NRF24::record_transition(Radio_State next, int64_t started_us, uint32_t started_spi_bytes){
+    const size_t from = static_cast<size_t>(state_);
+    const size_t to = static_cast<size_t>(next);
+    const int64_t now_us = timing_.now_us();
 
-    spi_command_wrapper(NRF_regs::rx_pipe_zero_address, address_width, pipe_zero_values);
-    spi_command_wrapper(NRF_regs::tx_pipe_zero_address, address_width, pipe_zero_values);
+    state_stats_.time_in_us[from] += started_us - state_since_us_;
+    state_stats_.transitions[from][to]++;
+    state_stats_.transition_us[from][to] += now_us - started_us;
+    state_stats_.transition_spi_bytes[from][to] += spi_->stats().bytes - started_spi_bytes;
 
-    // 5. RF setup
-    constexpr u8 rf_setup_values = 0b00100100;  // 1Mbps, 0dBm
-    spi_command_wrapper(NRF_regs::rf_setup_address, sizeof(rf_setup_values), &rf_setup_values);  // RF_SETUP
+    state_ = next;
+    state_since_us_ = now_us;
+}
 
-    constexpr u8 frequency_channel = 0x02;
-    spi_command_wrapper(NRF_regs::frequency_register_address, sizeof(frequency_channel), &frequency_channel);      // RF_CH
 
+Radio_State NRF24::pause_active(){
+    const Radio_State previous = state_;
+    if (previous == Radio_State::RxActive || previous == Radio_State::StandbyII || previous == Radio_State::TxActive) {
+        enter_state(Radio_State::StandbyI);
+    }
+    return previous;
+}
 
 
-    /*
+bool NRF24::resume_active(Radio_State previous){
+    if (previous == Radio_State::RxActive || previous == Radio_State::StandbyII) {
+        return enter_state(previous);
+    }
+    return true;
+}
 
-    // 6. Feature & dynamic payload
-    constexpr u8 features_address = 0x1D;
-    constexpr u8 features_values = 0b00000100;   // enable DPL
-    spi_command_wrapper(features_address, sizeof(features_values), &features_values);       // FEATURE
 
-    constexpr u8 dynamic_payload_address = 0x1C;    // pipe0 DPL
-    constexpr u8 dynamic_payload_value = 0b00000001;    // pipe0 DPL
-    spi_command_wrapper(dynamic_payload_address, sizeof(dynamic_payload_value), &dynamic_payload_value);        // DYNPD
-    */
+bool NRF24::power_down(){
+    return enter_state(Radio_State::PowerDown);
+}
 
-    // 6. Disable dynamic payload & features
-    constexpr u8 features_values = 0x00;   // Disable EN_DPL, EN_ACK_PAY, EN_DYN_ACK
-    spi_command_wrapper(NRF_regs::features_address, sizeof(features_values), &features_values);
 
-    constexpr u8 dynamic_payload_value = 0x00;      // Disable DPL for all pipes
-    spi_command_wrapper(NRF_regs::dynamic_payload_address, sizeof(dynamic_payload_value), &dynamic_payload_value);
+void NRF24::reset_state_stats(){
+    state_stats_ = {};
+    state_since_us_ = timing_.now_us();
+}
 
-    constexpr u8 fixed_payload_size = fifo_max_size;  // fixed size in bytes
-    spi_command_wrapper(NRF24::rx_width_Address, sizeof(fixed_payload_size), &fixed_payload_size);
 
+void NRF24::dump_state_stats() const{
+    const int64_t current_us = timing_.now_us() - state_since_us_;
+    printf("[NRF24::dump_state_stats] transitions (count / us / SPI bytes), %u CONFIG writes, %u CE edges, %u redundant requests\n",
+        state_stats_.config_writes, state_stats_.ce_toggles, state_stats_.redundant);
+    for (size_t from = 0; from < radio_state_count; ++from) {
+        for (size_t to = 0; to < radio_state_count; ++to) {
+            if (state_stats_.transitions[from][to] == 0) {
+                continue;
+            }
+            printf("  %-9s -> %-9s %8u %10llu %8u\n", radio_state_name(static_cast<Radio_State>(from)),
+                radio_state_name(static_cast<Radio_State>(to)), state_stats_.transitions[from][to],
+                static_cast<unsigned long long>(state_stats_.transition_us[from][to]), state_stats_.transition_spi_bytes[from][to]);
+        }
+    }
+    printf("  time in state (us):");
+    for (size_t state = 0; state < radio_state_count; ++state) {
+        const uint64_t time_us = state_stats_.time_in_us[state] + (state == static_cast<size_t>(state_) ? current_us : 0);
+        printf(" %s %llu", radio_state_name(static_cast<Radio_State>(state)), static_cast<unsigned long long>(time_us));
+    }
+    printf("\n");
+}
 
 
+const bool NRF24::setup_config(const Antenna_Mode& antenna_mode) {
+    // 1. Ensure CE LOW
 
+    // 2. CONFIG: power up & PRIM_RX (1=RX, 0=TX), standby-I is reached Tpd2stby later while the rest is written
+    mode_ = antenna_mode;
+    if (!enter_state(Radio_State::StandbyI) || !change_antenna_mode(antenna_mode)) {
+        NRF_LOGE("[NRF24::setup_config] Failed powering up\n");
+        return false;
+    }
 
-    // 7. Enable pipe0, disable auto‑ack
-    constexpr u8 enabled_rx_pipes_values = 0b00000011;
-    spi_command_wrapper(NRF24::enable_rx_pipes_address, sizeof(enabled_rx_pipes_values), &enabled_rx_pipes_values);      // EN_RXADDR
 
-    constexpr u8 auto_acknowledge_value = 0x00;
-    spi_command_wrapper(NRF24::auto_acknowledge_config_address, sizeof(auto_acknowledge_value), &auto_acknowledge_value);     // EN_AA
+    // 3 - 7 only touch registers the shadow cache covers, anything that changed goes out as one burst
+    if (!apply_profile(boot_profile)) {
+        NRF_LOGE("[NRF24::setup_config] Failed writing the default registers\n");
+        return false;
+    }
 
     // 8. Flush FIFOs & clear interrupts
-    // STATUS register bit definitions
-    constexpr u8 STATUS_RX_DR = 1 << 6; // Data Ready RX FIFO interrupt
-    constexpr u8 STATUS_TX_DS = 1 << 5; // Data Sent TX FIFO interrupt
-    constexpr u8 STATUS_MAX_RT = 1 << 4; // Max number of TX retransmits interrupt
-
-    const u8 clear_flags = STATUS_RX_DR | STATUS_TX_DS | STATUS_MAX_RT;
-    constexpr u8 status_register_address = 0x07;
-    spi_command_wrapper(status_register_address, sizeof(clear_flags), &clear_flags);
+    constexpr u8 clear_flags = nrf_map::status_irq_flags;
+    spi_command_wrapper(NRF_regs::status_register_address, sizeof(clear_flags), &clear_flags);
 
     flush_rx_buffer();
+    return true;
+}
 
-    // Set mode for your logic
-    mode_ = antenna_mode;
+
+const radio_profile_T& NRF24::setup_profile(){
+    return boot_profile;
+}
+
+
+bool NRF24::apply_profile(const radio_profile_T& profile){
+    const nrf_map::register_image& image = profile.image;
+    if (const char* problem = profile.problem()) { // a profile built at run time was not checked by the compiler
+        NRF_LOGE("[NRF24::apply_profile] Profile %s rejected: %s\n", profile.name, problem);
+        return false;
+    }
+    if (image.defines(nrf_map::setup_retr::address) && image.defines(nrf_map::rf_setup::address)) {
+        const uint16_t delay_us = (image.get<nrf_map::setup_retr::ard>() + 1) * nrf_map::setup_retr::ard_step_us;
+        const uint16_t min_delay_us = min_retransmit_delay_us(image.get<nrf_map::rf_setup::rf_dr>(), profile.ack_payload_length);
+        if (delay_us < min_delay_us) {
+            NRF_LOGE("[NRF24::apply_profile] Profile %s: ARD of %u us is below the %u us its rate needs\n", profile.name, delay_us, min_delay_us);
+            return false;
+        }
+    }
+
+    const int64_t started_us = timing_.now_us();
+    const register_cache_stats_T cache_before = cache_stats_;
+    const Radio_State previous_state = pause_active();
+
+    bool written = false;
+    {
+        // more registers than one queued batch holds go out as consecutive batches without giving up the bus
+        spi_burst burst(*spi_);
+        register_batch_T batch = {};
+        written = queue_image(batch, image);
+        written = flush_register_batch(batch) && written;
+    }
+    written = written && refresh_mirrors(image, profile.ack_payload_length);
+
+    // counted before resuming, the CONFIG write back into RX is not part of the profile
+    const uint32_t registers_written = cache_stats_.writes - cache_before.writes;
+    profile_stats_.switches++;
+    profile_stats_.registers_written += registers_written;
+    profile_stats_.registers_skipped += cache_stats_.writes_skipped - cache_before.writes_skipped;
+
+    resume_active(previous_state);
+    profile_stats_.switch_us += timing_.now_us() - started_us;
+    if (written) {
+        profile_ = &profile;
+    }
+    NRF_LOGD("[NRF24::apply_profile] Profile %s, %u registers written, result: %s\n", profile.name, registers_written, written ? "true" : "false");
+    return written;
+}
+
+
+bool NRF24::refresh_mirrors(const nrf_map::register_image& image, u8 ack_payload_length){
+    using namespace nrf_map;
+    u8 rf_setup_value = 0;
+    u8 retransmit = 0;
+    u8 features = 0;
+    u8 dynamic_payload = 0;
+    if (!read_register_cached(rf_setup::address, 1, &rf_setup_value)
+        || !read_register_cached(setup_retr::address, 1, &retransmit)
+        || !read_register_cached(feature::address, 1, &features)
+        || !read_register_cached(dynpd::address, 1, &dynamic_payload)) {
+        NRF_LOGE("[NRF24::refresh_mirrors] Failed reading RF_SETUP / SETUP_RETR / FEATURE / DYNPD\n");
+        return false;
+    }
+
+    rf_settings_ = {
+        rf_setup::rf_dr::decode(rf_setup_value),
+        rf_setup::rf_pwr::decode(rf_setup_value),
+        static_cast<uint16_t>((setup_retr::ard::decode(retransmit) + 1) * setup_retr::ard_step_us),
+        setup_retr::arc::decode(retransmit)
+    };
+    ack_payload_length_ = ack_payload_length;
+    dynamic_pipes_ = feature::en_dpl::test(features) ? dynamic_payload : 0;
+    dynamic_ack_ = feature::en_dyn_ack::test(features);
+    for (u8 pipe = 0; pipe < NRF_regs::rx_pipe_count; ++pipe) {
+        const u8 width_address = rx_pw<0>::address + pipe;
+        if (image.defines(width_address)) {
+            pipe_widths_[pipe] = image.value(width_address);
+        }
+    }
     return true;
 }
 
 
 void NRF24::drop_ce_pin() const{
     gpio_set_level(pins_layout.CE , voltage_flow::low);
+    timing_.ce_dropped();
+    trace(Trace_Event::Ce_Low, 0, 0, 0);
     return;
 }
 
 void NRF24::raise_ce_pin() const{
+    timing_.wait_standby(); // CE high before the crystal runs would start RX/TX from power down
     gpio_set_level(pins_layout.CE , voltage_flow::high);
+    timing_.ce_raised();
+    trace(Trace_Event::Ce_High, 0, 0, 0);
     return;
 }
 
@@ -158,220 +379,432 @@ void NRF24::raise_ce_pin() const{
 
 
 
-void NRF24::pulse_ce()const {
-    printf("\n\nPulsing CE \n\n");
-    // pulse to transmit then return to standby
+void NRF24::pulse_ce() {
+    NRF_LOGD("\n\nPulsing CE \n\n");
+    const int64_t started_us = timing_.now_us();
+    const uint32_t started_spi_bytes = spi_->stats().bytes;
+
+    // pulse to transmit then return to standby, the packet goes on air Tstby2a after the rising edge
+    timing_.wait_standby();
     gpio_set_level(pins_layout.CE , voltage_flow::high);
-    ets_delay_us(150);     // pulse ≥10 µs
+    timing_.ce_raised();
+    timing_.wait_ce_pulse();
     gpio_set_level(pins_layout.CE , voltage_flow::low);
+    timing_.ce_dropped();
+    trace(Trace_Event::Ce_Pulse, 0, 0, 0);
+
+    state_stats_.ce_toggles += 2;
+    record_transition(Radio_State::TxActive, started_us, started_spi_bytes);
     return;
 }
 
 void NRF24::flush_tx_buffer() const{
-    u8 command_size(1);
+    constexpr u8 command_size(1);
     u8 dummy_rx[command_size] = {}; // TODO more inuitive command size
     write_spi_command(&commands::flush_tx_command, dummy_rx, command_size);
     return;
 }
 
 void NRF24::flush_rx_buffer() const{
-    u8 command_size(1);
+    constexpr u8 command_size(1);
     u8 dummy_rx[command_size] = {};
-    write_spi_command(flush_rx_command, dummy_rx, command_size);
+    write_spi_command(&commands::flush_rx_command, dummy_rx, command_size);
     return;
 }
 
-bool NRF24::transmit_data(u8* databuffer, u8 data_bytes_length) {
-
+bool NRF24::transmit_data(u8* databuffer, u8 data_bytes_length, bool no_ack) {
 
 
-    printf("[NRF24::transmit_data] Data to transmit (databuffer): ");
-    for (size_t i = 0; i < fifo_max_size; i++) {
-        printf("0x%02X ", databuffer[i]);
-    }
-    printf("\n");
 
-    drop_ce_pin();
-    printf("\n\n [NRF24::transmit_data] Starting Transmission \n\n");
     if (databuffer == nullptr) {
-        printf("[NRF24::transmit_data] Passed nullptr to transmit_data\n");
+        NRF_LOGE("[NRF24::transmit_data] Passed nullptr to transmit_data\n");
         return false;
     }
 
+    NRF_LOGV("[NRF24::transmit_data] Data to transmit (databuffer): ");
+    for (size_t i = 0; i < data_bytes_length; i++) {
+        NRF_LOGV("0x%02X ", databuffer[i]);
+    }
+    NRF_LOGV("\n");
 
+    // checked before anything changes, a rejected payload leaves the radio where it was
+    if (data_bytes_length > fifo_max_size || (tx_dynamic_payloads() && data_bytes_length == 0)) {
+        NRF_LOGE("[NRF24::transmit_data] Payload of %d bytes does not fit the tx fifo\n", data_bytes_length);
+        return false;
+    }
 
+    if (no_ack && !enable_dynamic_ack()) {
+        NRF_LOGE("[NRF24::transmit_data] Failed enabling EN_DYN_ACK for a no-ack packet\n");
+        return false;
+    }
 
+    if (csma_.enabled && !listen_before_talk()) {
+        NRF_LOGW("[NRF24::transmit_data] Channel stayed busy, packet not sent\n");
+        switch_to_recieve(); // listening ends in standby-I, the node keeps receiving
+        return false;
+    }
 
-    printf("[NRF24::transmit_data] Flushing tx buffer\n");
-    //flush_tx_buffer();
-    printf("[NRF24::transmit_data] Flush complete\n");
-
+    enter_state(Radio_State::StandbyI);
+    NRF_LOGD("\n\n [NRF24::transmit_data] Starting Transmission \n\n");
 
-    u8 data_packet[fifo_max_size] = {};
+    // with static payloads the receiver expects all fifo_max_size bytes so the remainder stays zero padded,
+    // with dynamic payloads only the real bytes are clocked out and sent
+    const u8 packet_size = sizeof(commands::write_tx_command) + (tx_dynamic_payloads() ? data_bytes_length : fifo_max_size);
+    u8 data_packet[sizeof(commands::write_tx_command) + fifo_max_size] = {};
 
-    data_packet[0] = commands::write_tx_command; // W_TX_PAYLOAD command
+    data_packet[0] = no_ack ? commands::write_tx_no_ack_command : commands::write_tx_command; // W_TX_PAYLOAD(_NOACK) command
     memcpy(data_packet + sizeof(commands::write_tx_command), databuffer, data_bytes_length);
 
-    printf("[NRF24::transmit_data] Data to transmit: ");
-    for (size_t i = 0; i < fifo_max_size; i++) {
-        printf("0x%02X ", data_packet[i]);
+    NRF_LOGV("[NRF24::transmit_data] Data to transmit: ");
+    for (size_t i = 0; i < packet_size; i++) {
+        NRF_LOGV("0x%02X ", data_packet[i]);
     }
-    printf("\n");
+    NRF_LOGV("\n");
 
 
-    u8 recieve_data[fifo_max_size] = {};
+    u8 recieve_data[sizeof(data_packet)] = {};
 
 
-    printf("[NRF24::transmit_data] Writing spi command to send packet\n");
-    if (!write_spi_command(data_packet, recieve_data, fifo_max_size)) {
-        printf("failure writing spi command in NRF24::transmit_data\n");
+    NRF_LOGD("[NRF24::transmit_data] Writing spi command to send packet\n");
+    if (!write_spi_command(data_packet, recieve_data, packet_size)) {
+        NRF_LOGE("failure writing spi command in NRF24::transmit_data\n");
+        flush_tx_buffer();
+        switch_to_recieve();
         return false;
     }
-    printf("[NRF24::transmit_data]  write_spi_command returned: %s\n", success ? "true" : "false");
-
-
-
-    ets_delay_us(200);
-
-    printf("[NRF24::transmit_data]  transmit_data called with %d bytes\n", data_bytes_length);
-    if (mode_ != Antenna_Mode::Transmit) {
-        if (!switch_to_transmit()) {
-            printf("[NRF24::transmit_data]  Error occured trying to change to transmit mode");
-            return false;
-        }
+    NRF_LOGD("[NRF24::transmit_data]  write_spi_command returned: true\n");
 
+    NRF_LOGD("[NRF24::transmit_data]  transmit_data called with %d bytes\n", data_bytes_length);
+    if (!switch_to_transmit()) { // no action when CONFIG is already set for TX
+        NRF_LOGE("[NRF24::transmit_data]  Error occured trying to change to transmit mode");
+        flush_tx_buffer();
+        switch_to_recieve();
+        return false;
     }
 
-    printf("[NRF24::transmit_data] Passed antenna mode check \n");
+    NRF_LOGD("[NRF24::transmit_data] Passed antenna mode check \n");
 
     pulse_ce(); // this pulses CE pin on then off
 
-    // NOP -> STATUS
-    {
-        constexpr u8 cmd_len = 2;
-        u8 cmd[cmd_len] = { 0xFF, 0x00 };
-        u8 resp[cmd_len] = {};
-        write_spi_command(cmd, resp, cmd_len);
-        printf("[DIAG TX] NOP STATUS = 0x%02X\n", resp[0]);
-    }
-
-    // FIFO_STATUS (reg 0x17)
+#if NRF_LOG_LEVEL >= NRF_LOG_LEVEL_VERBOSE
+    // FIFO_STATUS (reg 0x17), the STATUS snapshot clocked out with the command makes a separate NOP unnecessary
     {
         constexpr u8 cmd_len = 2;
         u8 cmd[cmd_len] = { 0x17, 0x00 }; // R_REGISTER 0x17
         u8 resp[cmd_len] = {};
         write_spi_command(cmd, resp, cmd_len);
-        printf("[DIAG TX] FIFO_STATUS = 0x%02X\n", resp[1]); // resp[0] is STATUS snapshot, resp[1] is reg value
+        NRF_LOGV("[DIAG TX] STATUS = 0x%02X\n", resp[0]);
+        NRF_LOGV("[DIAG TX] FIFO_STATUS = 0x%02X\n", resp[1]);
     }
 
-    // TX_ADDR (reg 0x10, 5 bytes)
+    // TX_ADDR (reg 0x10, 5 bytes), only the driver writes it so the shadow copy answers
     {
-        constexpr u8 cmd_len = 6;
-        u8 cmd[cmd_len] = { 0x10, 0,0,0,0,0 }; // R_REGISTER 0x10 + 5 dummy
-        u8 resp[cmd_len] = {};
-        write_spi_command(cmd, resp, cmd_len);
-        printf("[DIAG TX] TX_ADDR = %02X %02X %02X %02X %02X\n",
-            resp[1], resp[2], resp[3], resp[4], resp[5]);
+        u8 addr[max_address_width] = {};
+        read_register_cached(NRF_regs::tx_pipe_zero_address, max_address_width, addr);
+        NRF_LOGV("[DIAG TX] TX_ADDR = %02X %02X %02X %02X %02X\n",
+            addr[0], addr[1], addr[2], addr[3], addr[4]);
     }
 
     // RX_ADDR_P0 (reg 0x0A, 5 bytes)
     {
-        constexpr u8 cmd_len = 6;
-        u8 cmd[cmd_len] = { 0x0A, 0,0,0,0,0 };
-        u8 resp[cmd_len] = {};
-        write_spi_command(cmd, resp, cmd_len);
-        printf("[DIAG TX] RX_ADDR_P0 = %02X %02X %02X %02X %02X\n",
-            resp[1], resp[2], resp[3], resp[4], resp[5]);
+        u8 addr[max_address_width] = {};
+        read_register_cached(NRF_regs::rx_pipe_zero_address, max_address_width, addr);
+        NRF_LOGV("[DIAG TX] RX_ADDR_P0 = %02X %02X %02X %02X %02X\n",
+            addr[0], addr[1], addr[2], addr[3], addr[4]);
+    }
+#endif
+
+    NRF_LOGD("[NRF24::transmit_data] Pulsed CE pin. \n");
+
+    // nothing is on air before Tstby2a, after that TX_DS / MAX_RT follow the airtime and any retransmits
+    timing_.wait_active();
+    NRF_LOGD("[NRF24::transmit_data] polling STATUS for TX_DS / MAX_RT\n");
+
+    const int64_t timeout_us = tx_completion_timeout_us(request_timeout_us);
+    u8 status = 0;
+    if (!poll_tx_outcome(packet_size - sizeof(commands::write_tx_command), timeout_us, status)) {
+        NRF_LOGE("[transmit_status] SPI failed\n");
+        return false;
+    }
+    enter_state(Radio_State::StandbyI); // CE is already low, this only books the end of the TX
+    NRF_LOGD("[NRF24::transmit_data] Status after transmission: 0x%02X", status);
+    trace(status & NRF_regs::status_tx_ds ? Trace_Event::Tx_Sent : Trace_Event::Tx_Failed, 0, status, 0);
+    if (status & NRF_regs::status_tx_ds) {
+        NRF_LOGD(" Transmission successful\n");
+        u8 clear_val = NRF_regs::status_tx_ds;
+        spi_command_wrapper(NRF_regs::status_register_address, 1, &clear_val);
+    }
+    else if (status & NRF_regs::status_max_rt) {
+        NRF_LOGD(" Transmission failed (MAX_RT)\n");
+        u8 clear_val = NRF_regs::status_max_rt;
+        spi_command_wrapper(NRF_regs::status_register_address, 1, &clear_val);
+        flush_tx_buffer();
+    }
+    else {
+        // neither flag within the timeout, the payload would otherwise go out with the next transmit
+        NRF_LOGW("[NRF24::transmit_data] No TX_DS or MAX_RT after %lld us, dropping the packet\n", static_cast<long long>(timeout_us));
+        flush_tx_buffer();
     }
 
-    printf("[NRF24::transmit_data] Pulsed CE pin. \n");
+    switch_to_recieve();
+    return (status & NRF_regs::status_tx_ds) != 0;
+}
 
+bool NRF24::listen_before_talk(){
+    if (!switch_to_recieve()) {
+        return false;
+    }
 
+    const uint16_t listen_us = csma_.listen_us < rpd_min_dwell_us ? rpd_min_dwell_us : csma_.listen_us;
+    const u8 rpd_command[2] = { NRF_regs::received_power_detector_address, commands::nop_command };
+    u8 exponent = 0;
+    for (u8 attempt = 0; attempt < csma_.max_attempts; ++attempt) {
+        // RPD only covers the current RX entry, so every listen starts from standby
+        enter_state(Radio_State::StandbyI);
+        enter_state(Radio_State::RxActive);
+        timing_.delay_us(listen_us);
+        enter_state(Radio_State::StandbyI);
+
+        u8 rpd_response[2] = {};
+        if (!write_spi_command(rpd_command, rpd_response, sizeof(rpd_command))) {
+            NRF_LOGE("[NRF24::listen_before_talk] SPI failed reading RPD\n");
+            return false;
+        }
+        if (!(rpd_response[1] & NRF_regs::rpd_bit)) {
+            if (attempt == 0) {
+                csma_stats_.clear_first++;
+            } else {
+                csma_stats_.collisions_avoided++;
+            }
+            return true;
+        }
 
-    ets_delay_us(200);  // 200 µs gives plenty of time
+        csma_stats_.deferrals++;
+        if (exponent < csma_.max_backoff_exponent) {
+            exponent++;
+        }
+        const uint32_t slots = 1 + esp_random() % (1u << exponent);
+        const uint32_t backoff_us = slots * csma_.backoff_slot_us;
+        csma_stats_.backoff_us += backoff_us;
 
+        timing_.delay_us(backoff_us); // the system clock sleeps whole ticks so other tasks run
+    }
 
+    csma_stats_.access_failures++;
+    return csma_.transmit_when_exhausted;
+}
 
-    constexpr u8 command_size = 2;
-    u8 status_command[command_size] = { 0xFF, 0x00 }; // NOP + dummy
-    u8 status_response[command_size] = {};
 
-    printf("[NRF24::transmit_data] transmitting check status command \n");
+size_t NRF24::transmit_stream(const tx_packet_T* packets, size_t count, tx_complete_callback_T on_complete, void* context){
+    stream_stats_ = {};
+    if (packets == nullptr || count == 0) {
+        return 0;
+    }
+    const int64_t started_us = timing_.now_us();
+
+    // FEATURE is written in standby, not halfway through the stream with CE high
+    for (size_t i = 0; i < count; ++i) {
+        if (packets[i].no_ack) {
+            if (!enable_dynamic_ack()) {
+                NRF_LOGE("[NRF24::transmit_stream] Failed enabling EN_DYN_ACK for the no-ack packets\n");
+                return 0;
+            }
+            break;
+        }
+    }
 
-    vTaskDelay(pdMS_TO_TICKS(1)); // tiny settle delay
-    bool ok = write_spi_command(status_command, status_response, command_size);
+    if (!switch_to_transmit()) { // leaves CE low
+        NRF_LOGE("[NRF24::transmit_stream] Error occured trying to change to transmit mode\n");
+        return 0;
+    }
 
+    constexpr u8 completion_flags = NRF_regs::status_tx_ds | NRF_regs::status_max_rt;
+    const u8 status_write_command = nrf_map::status::write;
+    const int64_t stall_timeout_us = tx_completion_timeout_us(tx_stream_timeout_us);
+
+    size_t next_load = 0;       // next packet to write into the TX FIFO
+    size_t next_done = 0;       // oldest packet not reported yet, the one at the head of the TX FIFO
+    int64_t last_progress_us = started_us;
+    bool ce_high = false;
+    u8 status = 0;
+
+    auto report = [&](bool delivered) {
+        if (delivered) {
+            stream_stats_.delivered++;
+        } else {
+            stream_stats_.failed++;
+        }
+        trace(delivered ? Trace_Event::Tx_Sent : Trace_Event::Tx_Failed, 0, status, static_cast<u8>(next_done));
+        if (on_complete != nullptr) {
+            on_complete(next_done, delivered, context);
+        }
+        next_done++;
+        last_progress_us = timing_.now_us();
+    };
 
-    if (!ok) {
-        printf("[transmit_status] SPI failed\n");
-        return false;
+    // anything left over from an earlier transmit_data would be taken for this stream's completions
+    const u8 clear_stale[2] = { status_write_command, completion_flags };
+    u8 flush_tx = commands::flush_tx_command;
+    const spi_transfer_T start_transfers[] = {
+        { sizeof(clear_stale), clear_stale, nullptr },
+        { sizeof(flush_tx), &flush_tx, nullptr },
+    };
+    if (!write_spi_batch(start_transfers, sizeof(start_transfers) / sizeof(start_transfers[0]))) {
+        NRF_LOGE("[NRF24::transmit_stream] Failed preparing the TX FIFO\n");
+        return 0;
     }
 
+    // TX_DS is sticky, one flag can stand for several packets. Completions are counted from the TX FIFO occupancy
+    // instead: FIFO_STATUS only tells empty from not empty, so at most two packets are queued and a TX_DS seen
+    // since the last poll tells one remaining from two. The radio still never idles, one is on air while the
+    // next waits.
+    constexpr size_t stream_fifo_depth = 2;
+    const u8 clear_tx_ds[2] = { status_write_command, NRF_regs::status_tx_ds };
+    const u8 poll_command[2] = { NRF_regs::fifo_status_address, commands::nop_command };
+
+    while (next_done < count) {
+        const size_t outstanding = next_load - next_done;
+        bool flush_needed = false;
+
+        if (outstanding > 0) {
+            // one transfer gives STATUS and FIFO_STATUS. A set TX_DS is cleared and FIFO_STATUS read again until
+            // no packet completed in between, then the occupancy read covers every TX_DS cleared
+            u8 poll_response[sizeof(poll_command)] = {};
+            bool completed = false;
+            bool polled = write_spi_command(poll_command, poll_response, sizeof(poll_command));
+            stream_stats_.polls++;
+            while (polled && (poll_response[0] & NRF_regs::status_tx_ds)) {
+                completed = true;
+                polled = write_spi_command(clear_tx_ds, nullptr, sizeof(clear_tx_ds))
+                      && write_spi_command(poll_command, poll_response, sizeof(poll_command));
+                stream_stats_.polls++;
+            }
+            if (!polled) {
+                NRF_LOGE("[NRF24::transmit_stream] SPI failed while polling\n");
+                break;
+            }
+            status = poll_response[0];
+            const u8 fifo_status = poll_response[1];
+
+            // the packets still queued, a MAX_RT packet stays at the head until flushed
+            size_t queued = outstanding;
+            if (fifo_status & NRF_regs::fifo_status_tx_empty) {
+                queued = 0;
+            } else if (completed) {
+                queued = 1;
+            }
+            while (next_done < next_load - queued) {
+                report(true);
+            }
+            if (status & NRF_regs::status_max_rt) {
+                // the radio stalls on the head packet until MAX_RT clears, drop it and reload the rest
+                report(false);
+                next_load = next_done;
+                flush_needed = true;
+            }
+
+            if (timing_.now_us() - last_progress_us > stall_timeout_us) {
+                NRF_LOGW("[NRF24::transmit_stream] No completion for %lld us, aborting\n", static_cast<long long>(stall_timeout_us));
+                break;
+            }
+        }
+
+        // clear the flags seen, flush after MAX_RT and top the FIFO back up, all in one queued batch
+        std::array<spi_transfer_T, 2 + stream_fifo_depth> transfers = {};
+        std::array<std::array<u8, sizeof(commands::write_tx_command) + fifo_max_size>, stream_fifo_depth> payload_commands;
+        const u8 clear_command[2] = { status_write_command, static_cast<u8>(status & NRF_regs::status_max_rt) };
+        size_t transfer_count = 0;
 
+        if (flush_needed) {
+            transfers[transfer_count++] = { sizeof(flush_tx), &flush_tx, nullptr };
+        }
+        if (clear_command[1] != 0) {
+            transfers[transfer_count++] = { sizeof(clear_command), clear_command, nullptr };
+        }
 
-    u8 status = status_response[0];
-    printf("[NRF24::transmit_data] Status after transmission: 0x%02X", status);
-    if (status & (1 << 5)) {  // TX_DS
-        printf(" Transmission successful\n");
-        u8 clear_val = 0b00100000;
-        spi_command_wrapper(NRF_regs::status_register_address, 1, &clear_val);
+        size_t loads = 0;
+        while (next_load < count && next_load - next_done < stream_fifo_depth) {
+            const tx_packet_T& packet = packets[next_load];
+            if (packet.data == nullptr || packet.length > fifo_max_size || (tx_dynamic_payloads() && packet.length == 0)) {
+                NRF_LOGE("[NRF24::transmit_stream] Packet %zu has an invalid length %d, stopping\n", next_load, packet.length);
+                break;
+            }
+            std::array<u8, sizeof(commands::write_tx_command) + fifo_max_size>& command = payload_commands[loads++];
+            command.fill(0x00);
+            command[0] = packet.no_ack ? commands::write_tx_no_ack_command : commands::write_tx_command;
+            memcpy(command.data() + sizeof(commands::write_tx_command), packet.data, packet.length);
+
+            const size_t command_size = sizeof(commands::write_tx_command) + (tx_dynamic_payloads() ? packet.length : fifo_max_size);
+            transfers[transfer_count++] = { command_size, command.data(), nullptr };
+            next_load++;
+        }
+
+        if (transfer_count > 0 && !write_spi_batch(transfers.data(), transfer_count)) {
+            NRF_LOGE("[NRF24::transmit_stream] SPI failed while loading the TX FIFO\n");
+            break;
+        }
+
+        if (next_load == next_done && loads == 0) {
+            break; // nothing in flight and nothing loadable, an invalid packet stopped the stream
+        }
+
+        if (!ce_high) {
+            enter_state(Radio_State::TxActive); // CE stays high, the radio sends FIFO entries back to back
+            ce_high = true;
+            last_progress_us = timing_.now_us();
+        }
     }
-    else if (status & (1 << 4)) { // MAX_RT
-        printf(" Transmission failed (MAX_RT)\n");
-        u8 clear_val = 0b00010000;
-        spi_command_wrapper(NRF_regs::status_register_address, 1, &clear_val);
+
+    enter_state(Radio_State::StandbyI);
+
+    // whatever is still queued or was never loaded did not go out
+    if (next_done < count) {
         flush_tx_buffer();
+        while (next_done < count) {
+            report(false);
+        }
     }
-    else {
-        printf(" Transmission still pending or no event yet\n");
-    }
-
-    switch_to_receive();
-    return true;
-}
 
-bool NRF24::switch_to_recieve() {
+    switch_to_recieve();
 
-    
+    stream_stats_.elapsed_us = timing_.now_us() - started_us;
+    NRF_LOGD("[NRF24::transmit_stream] %u delivered, %u failed, %u polls in %lld us\n",
+        stream_stats_.delivered, stream_stats_.failed, stream_stats_.polls, static_cast<long long>(stream_stats_.elapsed_us));
+    return stream_stats_.delivered;
+}
 
-    if (mode_ == Antenna_Mode::Transmit) {
-        drop_ce_pin();
-        printf("[NRF24::switch_to_recieve] Was in transmit mode, switching to recieve\n");
-        if(!change_antenna_mode(Antenna_Mode::Recieve)){
-            printf("[NRF24::switch_to_recieve] Unkown error, change antenna returned false? \n");
-            return false;
-        }
-        //clear_rx_buffer();
 
-        mode_ = Antenna_Mode::Recieve;
-        printf("[NRF24::switch_to_recieve] Now in RECEIVE mode, CE = HIGH\n");
-        raise_ce_pin();
-    } else if(mode_ == Antenna_Mode::Recieve){
-        printf("[NRF24::switch_to_recieve] Already in RECEIVE mode, no action taken\n");
-    } else {
-        printf("[NRF24::switch_to_recieve] Unknown mode?? <---- \n\n\n");
+bool NRF24::switch_to_recieve() {
+    if (state_ == Radio_State::RxActive) {
+        NRF_LOGD("[NRF24::switch_to_recieve] Already in RECEIVE mode, no action taken\n");
+        return true;
     }
-    raise_ce_pin();
+    if(!enter_state(Radio_State::RxActive)){
+        NRF_LOGE("[NRF24::switch_to_recieve] Unkown error, change antenna returned false? \n");
+        return false;
+    }
+    NRF_LOGD("[NRF24::switch_to_recieve] Now in RECEIVE mode, CE = HIGH\n");
     return true;
 }
 
 
 bool NRF24::switch_to_transmit(){
-
-    if (mode_ == Antenna_Mode::Recieve){
-        drop_ce_pin();
-        printf("[NRF24::switch_to_transmit] Was in Recieve mode, switching to transmit\n");
-        if(!change_antenna_mode(Antenna_Mode::Transmit)){
-            printf("Unkown error, change antenna returned false? \n");
-            return false;
-        }
-        mode_ = Antenna_Mode::Transmit;
-    } else  if(mode_ == Antenna_Mode::Transmit){
-        printf("[NRF24::switch_to_transmit] Already in TRANSMIT mode, no action taken\n");
-    }else {
-        printf("[NRF24::switch_to_transmit] Unknown mode?? <---- \n\n\n");
+    // standby-I with PRIM_RX cleared, the next CE pulse or enter_state(TxActive) sends
+    if (!enter_state(Radio_State::StandbyI)) {
+        return false;
+    }
+    if (mode_ == Antenna_Mode::Transmit) {
+        NRF_LOGD("[NRF24::switch_to_transmit] Already in TRANSMIT mode, no action taken\n");
+        return true;
+    }
+    NRF_LOGD("[NRF24::switch_to_transmit] Was in Recieve mode, switching to transmit\n");
+    const int64_t started_us = timing_.now_us();
+    const uint32_t started_spi_bytes = spi_->stats().bytes;
+    if(!change_antenna_mode(Antenna_Mode::Transmit)){
+        NRF_LOGE("Unkown error, change antenna returned false? \n");
+        return false;
     }
-    drop_ce_pin();
+    record_transition(Radio_State::StandbyI, started_us, started_spi_bytes); // PRIM_RX flips inside standby-I
     return true;
 }
 
@@ -379,12 +812,12 @@ bool NRF24::switch_to_transmit(){
 
 
 
-void NRF24::rx_process(u8* return_buffer){
+u8 NRF24::rx_process(u8* return_buffer){
 
 
-    constexpr u8 clear_all_flags   = 0b01110000; // bits 6,5,4
+    constexpr u8 clear_all_flags = nrf_map::status_irq_flags;
 
-    spi_command_wrapper(status_register_address,
+    spi_command_wrapper(NRF_regs::status_register_address,
                         sizeof(clear_all_flags),
                         &clear_all_flags);
         
@@ -392,9 +825,9 @@ void NRF24::rx_process(u8* return_buffer){
     auto reset_registers_and_return = [&]() {
         flush_rx_buffer();
         clear_RxDR();
-        constexpr u8 clear_all_flags   = 0b01110000; // bits 6,5,4
+        constexpr u8 clear_all_flags = nrf_map::status_irq_flags;
 
-        spi_command_wrapper(status_register_address,
+        spi_command_wrapper(NRF_regs::status_register_address,
                             sizeof(clear_all_flags),
                             &clear_all_flags);
             
@@ -404,47 +837,43 @@ void NRF24::rx_process(u8* return_buffer){
     switch_to_recieve();
 
     memset(return_buffer,0x00, fifo_max_size);
-    printf("[NRF24::rx_process] Switch to recieve passed\n");
+    NRF_LOGD("[NRF24::rx_process] Switch to recieve passed\n");
     if(!check_rx_buffer_has_data()){
         reset_registers_and_return();
-        return;
+        return 0;
     }
-    printf("[NRF24::rx_process] Fifo_Status suggests data in rx buffer \n");
+    NRF_LOGD("[NRF24::rx_process] Fifo_Status suggests data in rx buffer \n");
     
 
-    /*
-    u8 rx_buffer_length = get_rx_size();
+    const u8 rx_buffer_length = get_rx_size();
 
     if (rx_buffer_length == fifo_empty_size || rx_buffer_length>fifo_max_size){
-        printf("[NRF24::rx_process] Rx_size is out of bounds (%d), Aborting the rx_process method \n", rx_buffer_length);
+        NRF_LOGE("[NRF24::rx_process] Rx_size is out of bounds (%d), Aborting the rx_process method \n", rx_buffer_length);
         reset_registers_and_return();
-        return;
+        return 0;
     }
-    */
-    u8 rx_buffer_length = fifo_max_size;
-    printf("[NRF24::rx_process] Rx_buffer size has been provided: %d \n", rx_buffer_length);
+    NRF_LOGD("[NRF24::rx_process] Rx_buffer size has been provided: %d \n", rx_buffer_length);
 
     if(!read_rx_payload(return_buffer, rx_buffer_length)){
-        printf("[NRF24::rx_process] Failure reading rx buffer\n");
+        NRF_LOGE("[NRF24::rx_process] Failure reading rx buffer\n");
         reset_registers_and_return();
-        return;
+        return 0;
     }
-    printf("[NRF24::rx_process]Received payload: ");
+    NRF_LOGV("[NRF24::rx_process]Received payload: ");
     for (u8 i = 0; i < rx_buffer_length; ++i) {
-        printf("%02x", return_buffer[i]);
+        NRF_LOGV("%02x", return_buffer[i]);
     }
-    printf("\n");
+    NRF_LOGV("\n");
 
-    drop_ce_pin();
+    // FIFO and flags change while listening, restarting RX would only add Tstby2a of deafness
     reset_registers_and_return();
-    raise_ce_pin();
-    return;
+    return rx_buffer_length;
 }
 
 void NRF24::clear_RxDR() const{
-    printf("[NRF24::clear_RxDR] Clearing RX_DR flag\n");
-    u8 clear = 0x40;
-    bool write_status = spi_command_wrapper(status_register_address, sizeof(clear), &clear);
+    NRF_LOGD("[NRF24::clear_RxDR] Clearing RX_DR flag\n");
+    u8 clear = NRF_regs::status_rx_dr;
+    spi_command_wrapper(NRF_regs::status_register_address, sizeof(clear), &clear);
     return;
 }
 
@@ -453,27 +882,42 @@ const u8 NRF24::get_rx_size()const{
 
 
     constexpr u8 command_size = 2; 
-    u8 check_rx_data_size_command[command_size] = {get_rx_size_command,0x00};
+    u8 check_rx_data_size_command[command_size] = {commands::get_rx_size_command,0x00};
     u8 fifo_data[command_size] ={};
 
-    gpio_set_level(pins_layout.CSN, voltage_flow::high);
-    vTaskDelay(pdMS_TO_TICKS(5));
+    // CSN is framed by the SPI driver, R_RX_PL_WID needs no settling time
     bool check_status = write_spi_command(check_rx_data_size_command, fifo_data, command_size);
-    gpio_set_level(pins_layout.CSN, voltage_flow::low);
 
     if(!check_status){
-        printf("[NRF24::get_rx_size] Failed trying to check rx fifo data size \n");
+        NRF_LOGE("[NRF24::get_rx_size] Failed trying to check rx fifo data size \n");
+        return 0;
+    }
+    if((fifo_data[0] & NRF_regs::status_rx_p_no_mask) == NRF_regs::status_rx_fifo_empty){
         return 0;
     }
-    if(fifo_data[1] > fifo_max_size || fifo_data[1] ==fifo_empty_size ){
+    const u8 width = payload_width(fifo_data[0], fifo_data[1]);
+    if(width > fifo_max_size || width ==fifo_empty_size ){
         flush_rx_buffer();
-        printf("[NRF24::get_rx_size] Fifo size out of range: %d\n", fifo_data[1]);
-        printf("[NRF24::get_rx_size] Returned Data: 0x%02X, 0x%02X \n", fifo_data[0], fifo_data[1]);
+        NRF_LOGE("[NRF24::get_rx_size] Fifo size out of range: %d\n", width);
+        NRF_LOGE("[NRF24::get_rx_size] Returned Data: 0x%02X, 0x%02X \n", fifo_data[0], fifo_data[1]);
         return 0;
     }
 
 
-    return fifo_data[1];
+    return width;
+}
+
+
+u8 NRF24::payload_width(u8 status, u8 reported_width) const{
+    const u8 pipe = nrf_map::status::rx_p_no::decode(status);
+    if (pipe >= NRF_regs::rx_pipe_count) {
+        return 0;
+    }
+    if (dynamic_pipes_ & (1 << pipe)) {
+        return reported_width;
+    }
+    // RX_PW of 0 means the width was never set through the driver, keep the old fixed read
+    return pipe_widths_[pipe] != 0 ? pipe_widths_[pipe] : fifo_max_size;
 }
 
 
@@ -481,7 +925,6 @@ bool NRF24::check_rx_buffer_has_data() {
     //printf("\n\nChecking the rx buffer\n\n");
     // Prepare the “FIFO_STATUS” register read command
     u8 command_data_size = 1;
-    u8* fifo_data = nullptr;
 
     //printf("[NRF24] check_rx_fifo: about to send command 0x17 to read FIFO_STATUS\n");
     //printf("[NRF24] check_rx_fifo: transmit buffer: 0x%02X 0x%02X\n",
@@ -491,27 +934,26 @@ bool NRF24::check_rx_buffer_has_data() {
 
 
     // Issue the SPI transaction
-    fifo_data = read_register(fifo_status_address,
+    const spi_frame_T fifo_data = read_register(NRF_regs::fifo_status_address,
         command_data_size);
 
 
-    if (fifo_data == nullptr) {
-        printf("[NRF24] check_rx_fifo: SPI transaction FAILED\n");
+    if (!fifo_data) {
+        NRF_LOGE("[NRF24] check_rx_fifo: SPI transaction FAILED\n");
         return false;
     }
 
     // Log the raw SPI response
-    printf("[NRF24::check_rx_buffer_has_data] check_rx_fifo: SPI transaction successful, received buffer: ");
-    printf("0x%02X 0x%02X\n", fifo_data[0], *(fifo_data+1));
+    NRF_LOGD("[NRF24::check_rx_buffer_has_data] check_rx_fifo: SPI transaction successful, received buffer: ");
+    NRF_LOGD("0x%02X 0x%02X\n", fifo_data[0], fifo_data[1]);
 
     // fifo_data[0] is the STATUS byte, fifo_data[1] is the FIFO_STATUS register
-    bool rx_fifo_empty = (fifo_data[1] & 0x01);
-    printf("[NRF24::check_rx_buffer_has_data]  Fifo Data byte 0 : (0x%02X)\n", fifo_data[0]);
-    printf("[NRF24::check_rx_buffer_has_data]  Fifo Data byte 1 : (0x%02X)\n", fifo_data[1]);
+    bool rx_fifo_empty = nrf_map::fifo_status::rx_empty::test(fifo_data[1]);
+    NRF_LOGD("[NRF24::check_rx_buffer_has_data]  Fifo Data byte 0 : (0x%02X)\n", fifo_data[0]);
+    NRF_LOGD("[NRF24::check_rx_buffer_has_data]  Fifo Data byte 1 : (0x%02X)\n", fifo_data[1]);
 
-    free(fifo_data);
     if (rx_fifo_empty) {
-        printf("[NRF24] check_rx_fifo: no data available (RX FIFO empty)\n");
+        NRF_LOGD("[NRF24] check_rx_fifo: no data available (RX FIFO empty)\n");
        return false;
     }
 
@@ -523,154 +965,1061 @@ bool NRF24::check_rx_buffer_has_data() {
 const bool NRF24::read_rx_payload( u8* databuffer, const u8& data_bytes_length)const {
 
 
-    u8 transmit_data[max_buffer_size] = {};
-    u8 receive_data[max_buffer_size] = {};
+    if (data_bytes_length > max_buffer_size) {
+        NRF_LOGE("[NRF24::read_rx_payload] Requested %d bytes, larger than the rx fifo\n", data_bytes_length);
+        return false;
+    }
+
+    constexpr size_t command_size = sizeof(commands::read_rx_buffer_command) + max_buffer_size;
+    u8 transmit_data[command_size] = {};
+    u8 receive_data[command_size] = {};
 
 
-    transmit_data[0] = read_rx_buffer_command;
+    transmit_data[0] = commands::read_rx_buffer_command;
  
-    memset(transmit_data + sizeof(read_rx_buffer_command), 0x00, data_bytes_length); // TODO : check why i put oxff?
+    memset(transmit_data + sizeof(commands::read_rx_buffer_command), 0x00, data_bytes_length); // TODO : check why i put oxff?
 
-    drop_ce_pin();
-    bool success = write_spi_command(transmit_data, receive_data, max_buffer_size);
-    raise_ce_pin();
+    bool success = write_spi_command(transmit_data, receive_data, sizeof(commands::read_rx_buffer_command) + data_bytes_length);
 
     if (!success) {
-        printf("[NRF24] SPI read RX payload failed\n");
+        NRF_LOGE("[NRF24] SPI read RX payload failed\n");
         return false;
     }
 
-    printf("[NRF24::read_rx_payload] Raw RX buffer: ");
+    NRF_LOGV("[NRF24::read_rx_payload] Raw RX buffer: ");
         for (u8 i = 0; i < 1 + data_bytes_length; ++i) {
-            printf("%02X ", receive_data[i]);
+            NRF_LOGV("%02X ", receive_data[i]);
         }
-    printf("\n");
+    NRF_LOGV("\n");
 
 
     memcpy(databuffer, receive_data + 1, data_bytes_length); // skip status byte
     return true;
 }
 
-u8* NRF24::read_register(const u8& register_address, const u8& data_bytes_length) const{
-    if (data_bytes_length == 0) {
-        printf("[NRF24] Error: data_bytes_length must be > 0\n");
-        return nullptr;
+u8 NRF24::shadow_slot_size(const u8& register_address){
+    switch (register_address) {
+        case NRF_regs::rx_pipe_zero_address:
+        case NRF_regs::rx_pipe_one_address:
+        case NRF_regs::tx_pipe_zero_address:
+            return max_address_width;
+        default:
+            return 1;
     }
+}
 
-    const u8 full_buffer_size = sizeof(register_address) + data_bytes_length;
-
-    printf("\n \n Creating buffer of size: %d \n", full_buffer_size);
 
-    u8* rx_buffer = (u8*)malloc(full_buffer_size);
-    if (rx_buffer == nullptr) {
-        printf("[NRF24] Memory allocation failed in read_register\n");
-        return nullptr;
-    }
-    u8* tx_buffer = (u8*)malloc(full_buffer_size);
-    if (tx_buffer == nullptr) {
-        printf("[NRF24] Memory allocation failed in read_register\n");
-        return nullptr;
+u8* NRF24::shadow_slot(const u8& register_address){
+    switch (register_address) {
+        case NRF_regs::status_register_address:
+        case NRF_regs::observe_tx_address:
+        case NRF_regs::received_power_detector_address:
+        case NRF_regs::fifo_status_address:
+            return nullptr; // owned by the radio, always read live
+        case NRF_regs::rx_pipe_zero_address:
+            return shadow_addresses_[0].data();
+        case NRF_regs::rx_pipe_one_address:
+            return shadow_addresses_[1].data();
+        case NRF_regs::tx_pipe_zero_address:
+            return shadow_addresses_[2].data();
+        default:
+            if (register_address >= register_file_size || (register_address > NRF_regs::fifo_status_address && register_address < NRF_regs::dynamic_payload_address)) {
+                return nullptr;
+            }
+            return &shadow_registers_[register_address];
     }
+}
 
-    tx_buffer[0] = register_address; // Read command – MSBs should already be 0
 
-    // Fill rest of transmit_data with 0x00 (dummy bytes for reading)
-    memset(tx_buffer + sizeof(uint8_t), 0x00, data_bytes_length);
-    
-    printf("[NRF24] read_register called: reg=0x%02X, len=%d, cmd=", register_address, data_bytes_length);
-    for (u8 i = 0; i < full_buffer_size; ++i) {
-        printf("0x%02X ", tx_buffer[i]);
+bool NRF24::write_register_cached(const u8& register_address, const u8& data_bytes_length, const u8* databytes){
+    u8* slot = shadow_slot(register_address);
+
+    if (slot == nullptr || data_bytes_length > shadow_slot_size(register_address)) {
+        return spi_command_wrapper(register_address, data_bytes_length, databytes);
     }
-    printf("\n");
-    
-    gpio_set_level(pins_layout.CSN, voltage_flow::low);
-    
 
-    vTaskDelay(pdMS_TO_TICKS(5));
-    bool result = write_spi_command(tx_buffer, rx_buffer, full_buffer_size);
-    gpio_set_level(pins_layout.CSN, voltage_flow::high);
+    if (shadow_length_[register_address] >= data_bytes_length && memcmp(slot, databytes, data_bytes_length) == 0) {
+        cache_stats_.writes_skipped++;
+        return true;
+    }
 
-    printf("Pin after attempting to Raise it: ");
-    if (gpio_get_level(pins_layout.CSN) == voltage_flow::high) {
-        printf("Pin is HIGH\n");
-    } else {
-        printf("Pin is LOW\n");
+    cache_stats_.writes++;
+    if (!spi_command_wrapper(register_address, data_bytes_length, databytes)) {
+        shadow_length_[register_address] = 0;
+        return false;
     }
 
+    update_shadow(register_address, data_bytes_length, databytes);
+    return true;
+}
+
 
-    //printf("[NRF24] write_spi_command result: %s\n", result ? "true" : "false");
-    free(tx_buffer);
-    if (!result) {
-        free(rx_buffer);
-        return nullptr;
+void NRF24::update_shadow(const u8& register_address, const u8& data_bytes_length, const u8* databytes){
+    u8* slot = shadow_slot(register_address);
+    if (slot == nullptr || data_bytes_length > shadow_slot_size(register_address)) {
+        return;
     }
-    
-    printf("[NRF24] SPI read returned: ");
-    for (u8 i = 0; i < full_buffer_size; ++i) {
-        printf("0x%02X ", rx_buffer[i]);
+    memcpy(slot, databytes, data_bytes_length);
+    // a shorter write leaves the upper address bytes as they were, they stay known only if they were before
+    if (shadow_length_[register_address] < data_bytes_length) {
+        shadow_length_[register_address] = data_bytes_length;
     }
-
-    printf("\n\n");
-    return rx_buffer;
 }
 
 
+bool NRF24::queue_register_write(register_batch_T& batch, const u8& register_address, const u8& data_bytes_length, const u8* databytes){
+    u8* slot = shadow_slot(register_address);
+    if (slot == nullptr || data_bytes_length > shadow_slot_size(register_address)) {
+        // keep the write order, anything queued before this one goes first
+        return flush_register_batch(batch) && spi_command_wrapper(register_address, data_bytes_length, databytes);
+    }
 
+    if (shadow_length_[register_address] >= data_bytes_length && memcmp(slot, databytes, data_bytes_length) == 0) {
+        cache_stats_.writes_skipped++;
+        return true;
+    }
+
+    if (batch.count == register_batch_T::max_writes && !flush_register_batch(batch)) {
+        return false;
+    }
 
-const u8* NRF24::write_register(const u8& register_address, const u8& data_bytes_length, const u8* databytes) const {
+    std::array<u8, 1 + max_address_width>& command = batch.commands[batch.count];
+    command[0] = nrf_map::write_command(register_address);
+    memcpy(command.data() + 1, databytes, data_bytes_length);
+    batch.lengths[batch.count] = data_bytes_length;
+    batch.count++;
+    return true;
+}
 
 
-    printf("[NRF24::write_register] write_register called: reg=0x%02X, len=%d, data=0x", register_address, data_bytes_length);
-    for (u8 i = 0; i < data_bytes_length; ++i) {
-        printf("%02X ", databytes[i]);
+bool NRF24::flush_register_batch(register_batch_T& batch){
+    if (batch.count == 0) {
+        return true;
     }
-    printf("\n");
 
-    u8 full_buffer_size = data_bytes_length+sizeof(register_address);
+    spi_transfer_T transfers[register_batch_T::max_writes] = {};
+    for (u8 i = 0; i < batch.count; ++i) {
+        transfers[i] = { static_cast<size_t>(1 + batch.lengths[i]), batch.commands[i].data(), nullptr };
+    }
+
+    const bool written = write_spi_batch(transfers, batch.count);
+    NRF_LOGD("[NRF24::flush_register_batch] %d register writes, result: %s\n", batch.count, written ? "true" : "false");
+
+    for (u8 i = 0; i < batch.count; ++i) {
+        const u8 register_address = batch.commands[i][0] & ~NRF_regs::write_register_prefix;
+        if (written) {
+            update_shadow(register_address, batch.lengths[i], batch.commands[i].data() + 1);
+        } else {
+            shadow_length_[register_address] = 0;
+        }
+    }
+    cache_stats_.writes += batch.count;
+    batch.count = 0;
+    return written;
+}
+
+
+bool NRF24::queue_image(register_batch_T& batch, const nrf_map::register_image& image){
+    bool queued = true;
+    for (u8 address = 0; address < nrf_map::register_count; ++address) {
+        // CONFIG belongs to the state machine, it changes with CE
+        if (address == nrf_map::config::address || !image.defines(address)) {
+            continue;
+        }
+        queued = queue_register_write(batch, address, image.length(address), image.data(address)) && queued;
+    }
+    return queued;
+}
+
+
+bool NRF24::read_register_cached(const u8& register_address, const u8& data_bytes_length, u8* databuffer){
+    u8* slot = shadow_slot(register_address);
+    if (slot != nullptr && shadow_length_[register_address] >= data_bytes_length) {
+        memcpy(databuffer, slot, data_bytes_length);
+        cache_stats_.reads_served++;
+        return true;
+    }
+
+    cache_stats_.reads++;
+    const spi_frame_T response = read_register(register_address, data_bytes_length);
+    if (!response) {
+        return false;
+    }
+    memcpy(databuffer, response.data(), data_bytes_length);
+
+    if (slot != nullptr && data_bytes_length <= shadow_slot_size(register_address)) {
+        memcpy(slot, response.data(), data_bytes_length);
+        shadow_length_[register_address] = data_bytes_length;
+    }
+    return true;
+}
+
+
+bool NRF24::resync(){
+    bool all_read = true;
+    shadow_length_.fill(0);
+
+    for (u8 address = 0; address < register_file_size; ++address) {
+        u8* slot = shadow_slot(address);
+        if (slot == nullptr) {
+            continue;
+        }
+        const u8 length = shadow_slot_size(address);
+
+        const spi_frame_T response = read_register(address, length);
+        if (!response) {
+            NRF_LOGE("[NRF24::resync] Failed reading register 0x%02X\n", address);
+            all_read = false;
+            continue;
+        }
+        memcpy(slot, response.data(), length);
+        shadow_length_[address] = length;
+    }
+    return all_read;
+}
+
+
+bool NRF24::verify(){
+    bool matches = true;
+
+    for (u8 address = 0; address < register_file_size; ++address) {
+        u8* slot = shadow_slot(address);
+        const u8 length = shadow_length_[address];
+        if (slot == nullptr || length == 0) {
+            continue;
+        }
+
+        const spi_frame_T response = read_register(address, length);
+        if (!response) {
+            NRF_LOGE("[NRF24::verify] Failed reading register 0x%02X\n", address);
+            matches = false;
+            continue;
+        }
+        if (memcmp(slot, response.data(), length) != 0) {
+            NRF_LOGW("[NRF24::verify] Register 0x%02X differs, cached 0x%02X, chip 0x%02X\n", address, slot[0], response.data()[0]);
+            matches = false;
+        }
+    }
+    return matches;
+}
+
+
+bool NRF24::spi_link_passes() const{
+    // alternating, inverted and walking bits so a late or early sampled MISO line shows up in every byte
+    constexpr u8 patterns[][max_address_width] = {
+        {0xA5, 0x5A, 0xA5, 0x5A, 0xA5},
+        {0x5A, 0xA5, 0x5A, 0xA5, 0x5A},
+        {0x01, 0x02, 0x04, 0x08, 0x10},
+        {0xFE, 0xFD, 0xFB, 0xF7, 0xEF},
+        {0x80, 0x40, 0x20, 0x10, 0x08}
+    };
+
+    for (const auto& pattern : patterns) {
+        if (!write_register(NRF_regs::tx_pipe_zero_address, max_address_width, pattern)) {
+            return false;
+        }
+        const spi_frame_T response = read_register(NRF_regs::tx_pipe_zero_address, max_address_width);
+        if (!response || memcmp(response.data(), pattern, max_address_width) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+int NRF24::calibrate_spi_clock(const int* candidate_hz, size_t count){
+    const int original_hz = spi_->clock_speed_hz();
+
+    // taken at the clock the driver has been running at, so it is known good
+    u8 tx_address[max_address_width] = {};
+    if (!read_register_cached(NRF_regs::tx_pipe_zero_address, max_address_width, tx_address)) {
+        NRF_LOGE("[NRF24::calibrate_spi_clock] Failed reading TX_ADDR at %d Hz\n", original_hz);
+        return 0;
+    }
+
+    int chosen_hz = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (candidate_hz[i] <= 0 || candidate_hz[i] > max_spi_clock_hz) {
+            continue;
+        }
+        if (spi_->set_clock_speed(candidate_hz[i]) != ESP_OK) {
+            NRF_LOGE("[NRF24::calibrate_spi_clock] Could not switch SPI to %d Hz\n", candidate_hz[i]);
+            continue;
+        }
+        const bool passed = spi_link_passes();
+        NRF_LOGI("[NRF24::calibrate_spi_clock] %d Hz: %s\n", candidate_hz[i], passed ? "pass" : "fail");
+        if (passed) {
+            chosen_hz = candidate_hz[i];
+            break;
+        }
+    }
+
+    if (chosen_hz == 0) {
+        spi_->set_clock_speed(original_hz);
+    }
+
+    // the last test pattern is still in the chip
+    if (!write_register(NRF_regs::tx_pipe_zero_address, max_address_width, tx_address)) {
+        NRF_LOGE("[NRF24::calibrate_spi_clock] Failed restoring TX_ADDR\n");
+        shadow_length_[NRF_regs::tx_pipe_zero_address] = 0;
+    }
+
+    // a failing clock can corrupt MOSI as well, make sure nothing else was hit on the way down
+    if (!verify()) {
+        NRF_LOGW("[NRF24::calibrate_spi_clock] Registers changed during calibration, call resync() or setup again\n");
+    }
+
+    NRF_LOGI("[NRF24::calibrate_spi_clock] Running at %d Hz\n", chosen_hz == 0 ? original_hz : chosen_hz);
+    return chosen_hz;
+}
+
+
+bool NRF24::set_dynamic_payloads(bool enabled){
+    u8 features_values = 0;
+    u8 auto_acknowledge = 0;
+    if (!read_register_cached(NRF_regs::features_address, 1, &features_values)
+        || !read_register_cached(NRF_regs::auto_acknowledge_config_address, 1, &auto_acknowledge)) {
+        NRF_LOGE("[NRF24::set_dynamic_payloads] Failed reading FEATURE / EN_AA\n");
+        return false;
+    }
+    // DPL on a pipe needs ENAA_Px on that pipe as well, pipes without auto-ack keep their static width
+    const u8 dynamic_payload_value = enabled ? (auto_acknowledge & NRF_regs::dynamic_payload_all_pipes) : 0x00;
+    if (enabled && dynamic_payload_value == 0) {
+        NRF_LOGE("[NRF24::set_dynamic_payloads] No pipe has auto-ack, enable it with configure_pipe first\n");
+        return false;
+    }
+    // EN_DYN_ACK is independent, ACK payloads cannot exist without DPL
+    features_values = enabled ? (features_values | NRF_regs::feature_en_dpl)
+                              : (features_values & ~(NRF_regs::feature_en_dpl | NRF_regs::feature_en_ack_pay));
+
+    // registers change in standby, CE goes back up afterwards if the radio was listening
+    const Radio_State previous_state = pause_active();
+
+    register_batch_T batch = {};
+    bool written = queue_register_write(batch, NRF_regs::features_address, sizeof(features_values), &features_values)
+                && queue_register_write(batch, NRF_regs::dynamic_payload_address, sizeof(dynamic_payload_value), &dynamic_payload_value);
+    written = flush_register_batch(batch) && written;
+
+    resume_active(previous_state);
+
+    if (written) {
+        dynamic_pipes_ = dynamic_payload_value;
+    }
+    NRF_LOGD("[NRF24::set_dynamic_payloads] Dynamic payloads %s on pipes 0x%02X: %s\n", enabled ? "on" : "off", dynamic_payload_value, written ? "true" : "false");
+    return written;
+}
+
+
+bool NRF24::configure_pipe(u8 pipe, const pipe_config_T& config){
+    if (pipe >= NRF_regs::rx_pipe_count) {
+        NRF_LOGE("[NRF24::configure_pipe] Pipe %d does not exist\n", pipe);
+        return false;
+    }
+    if (!config.dynamic_payload && (config.payload_width == fifo_empty_size || config.payload_width > fifo_max_size)) {
+        NRF_LOGE("[NRF24::configure_pipe] Payload width %d out of range for pipe %d\n", config.payload_width, pipe);
+        return false;
+    }
+    if (config.dynamic_payload && !config.auto_ack) {
+        NRF_LOGE("[NRF24::configure_pipe] Dynamic payloads need auto-ack on pipe %d\n", pipe);
+        return false;
+    }
+
+    u8 enabled_pipes = 0;
+    u8 auto_acknowledge = 0;
+    u8 dynamic_payload = 0;
+    u8 features = 0;
+    u8 address_width_setting = 0;
+    if (!read_register_cached(NRF_regs::enable_rx_pipes_address, 1, &enabled_pipes)
+        || !read_register_cached(NRF_regs::auto_acknowledge_config_address, 1, &auto_acknowledge)
+        || !read_register_cached(NRF_regs::dynamic_payload_address, 1, &dynamic_payload)
+        || !read_register_cached(NRF_regs::features_address, 1, &features)
+        || !read_register_cached(NRF_regs::address_width_address, 1, &address_width_setting)) {
+        NRF_LOGE("[NRF24::configure_pipe] Failed reading the pipe registers\n");
+        return false;
+    }
+
+    const u8 pipe_bit = 1 << pipe;
+    auto apply = [pipe_bit](u8 value, bool set) -> u8 {
+        return set ? (value | pipe_bit) : (value & ~pipe_bit);
+    };
+    enabled_pipes = apply(enabled_pipes, config.enabled);
+    auto_acknowledge = apply(auto_acknowledge, config.auto_ack);
+    dynamic_payload = apply(dynamic_payload, config.dynamic_payload);
+    if (dynamic_payload == 0 && (features & NRF_regs::feature_en_ack_pay)) {
+        // EN_ACK_PAY without EN_DPL is not a valid combination, the caller turns ACK payloads off first
+        NRF_LOGE("[NRF24::configure_pipe] Pipe %d would clear EN_DPL while ACK payloads are on\n", pipe);
+        return false;
+    }
+    features = dynamic_payload != 0 ? (features | NRF_regs::feature_en_dpl) : (features & ~NRF_regs::feature_en_dpl);
+
+    // pipes 0 and 1 take the full SETUP_AW width (01 = 3 bytes ... 11 = 5 bytes), pipes 2 - 5 only their LSByte
+    const u8 address_width = pipe < 2 ? (address_width_setting & 0b11) + 2 : 1;
+    const u8 width = config.payload_width;
 
-    u8* rx_buffer = (u8*)malloc(full_buffer_size);
+    // registers change in standby, CE goes back up afterwards if the radio was listening
+    const Radio_State previous_state = pause_active();
 
-    if(rx_buffer == nullptr){
-        printf("[NRF24::write_register] failed allocating memory for return_buffer in NRF::24.write_register(). \n");
-        return nullptr;
+    register_batch_T batch = {};
+    bool written = queue_register_write(batch, NRF_regs::rx_pipe_zero_address + pipe, address_width, config.address.data());
+    if (!config.dynamic_payload) {
+        written = queue_register_write(batch, NRF_regs::rx_width_Address + pipe, sizeof(width), &width) && written;
     }
+    written = queue_register_write(batch, NRF_regs::features_address, sizeof(features), &features) && written;
+    written = queue_register_write(batch, NRF_regs::dynamic_payload_address, sizeof(dynamic_payload), &dynamic_payload) && written;
+    written = queue_register_write(batch, NRF_regs::auto_acknowledge_config_address, sizeof(auto_acknowledge), &auto_acknowledge) && written;
+    written = queue_register_write(batch, NRF_regs::enable_rx_pipes_address, sizeof(enabled_pipes), &enabled_pipes) && written;
+    written = flush_register_batch(batch) && written;
+
+    resume_active(previous_state);
+
+    if (written) {
+        dynamic_pipes_ = (features & NRF_regs::feature_en_dpl) ? dynamic_payload : 0;
+        if (!config.dynamic_payload) {
+            pipe_widths_[pipe] = width;
+        }
+    }
+    NRF_LOGD("[NRF24::configure_pipe] Pipe %d %s, result: %s\n", pipe, config.enabled ? "enabled" : "disabled", written ? "true" : "false");
+    return written;
+}
+
+
+bool NRF24::enable_dynamic_ack(){
+    if (dynamic_ack_) {
+        return true;
+    }
+    u8 features = 0;
+    if (!read_register_cached(NRF_regs::features_address, 1, &features)) {
+        return false;
+    }
+    features |= NRF_regs::feature_en_dyn_ack;
+    const Radio_State previous_state = pause_active();
+    dynamic_ack_ = write_register_cached(NRF_regs::features_address, sizeof(features), &features);
+    resume_active(previous_state);
+    return dynamic_ack_;
+}
+
+
+bool NRF24::set_ack_payloads(bool enabled){
+    u8 features = 0;
+    u8 enabled_pipes = 0;
+    u8 dynamic_payload = 0;
+    u8 auto_acknowledge = 0;
+    if (!read_register_cached(NRF_regs::features_address, 1, &features)
+        || !read_register_cached(NRF_regs::enable_rx_pipes_address, 1, &enabled_pipes)
+        || !read_register_cached(NRF_regs::dynamic_payload_address, 1, &dynamic_payload)
+        || !read_register_cached(NRF_regs::auto_acknowledge_config_address, 1, &auto_acknowledge)) {
+        NRF_LOGE("[NRF24::set_ack_payloads] Failed reading the feature registers\n");
+        return false;
+    }
+
+    if (enabled) {
+        // ACK payloads only exist with dynamic payloads, pipe 0 is where a transmitter receives its ACKs
+        const u8 pipes = enabled_pipes | 0x01;
+        features |= NRF_regs::feature_en_ack_pay | NRF_regs::feature_en_dpl;
+        dynamic_payload |= pipes;
+        auto_acknowledge |= pipes;
+    } else {
+        features &= ~NRF_regs::feature_en_ack_pay;
+    }
+
+    register_batch_T batch = {};
+    bool written = queue_register_write(batch, NRF_regs::features_address, sizeof(features), &features);
+    written = queue_register_write(batch, NRF_regs::dynamic_payload_address, sizeof(dynamic_payload), &dynamic_payload) && written;
+    written = queue_register_write(batch, NRF_regs::auto_acknowledge_config_address, sizeof(auto_acknowledge), &auto_acknowledge) && written;
+    if (batch.count != 0) {
+        const Radio_State previous_state = pause_active();
+        written = flush_register_batch(batch) && written;
+        resume_active(previous_state);
+    }
+
+    if (written) {
+        dynamic_pipes_ = (features & NRF_regs::feature_en_dpl) ? dynamic_payload : 0;
+    }
+    NRF_LOGD("[NRF24::set_ack_payloads] ACK payloads %s: %s\n", enabled ? "on" : "off", written ? "true" : "false");
+    return written;
+}
+
+
+bool NRF24::queue_ack_payload(u8 pipe, const u8* data, u8 length){
+    if (data == nullptr || pipe >= NRF_regs::rx_pipe_count || length == fifo_empty_size || length > fifo_max_size) {
+        NRF_LOGE("[NRF24::queue_ack_payload] Invalid reply for pipe %d, %d bytes\n", pipe, length);
+        return false;
+    }
+
+    u8 command[sizeof(commands::write_ack_payload_command) + fifo_max_size] = {};
+    command[0] = commands::write_ack_payload_command | pipe;
+    memcpy(command + 1, data, length);
+
+    u8 response[sizeof(command)] = {};
+    if (!write_spi_command(command, response, 1 + length)) {
+        NRF_LOGE("[NRF24::queue_ack_payload] SPI failed loading the reply for pipe %d\n", pipe);
+        return false;
+    }
+    // the STATUS clocked out with the command is from before the write, TX_FULL there means the chip dropped it
+    if (response[0] & NRF_regs::status_tx_full) {
+        NRF_LOGW("[NRF24::queue_ack_payload] TX FIFO full, reply for pipe %d not loaded\n", pipe);
+        return false;
+    }
+    return true;
+}
+
+
+bool NRF24::transmit_request(const u8* data, u8 length, u8* reply, u8& reply_length){
+    reply_length = 0;
+    if (data == nullptr || reply == nullptr || length == fifo_empty_size || length > fifo_max_size) {
+        NRF_LOGE("[NRF24::transmit_request] Invalid request of %d bytes\n", length);
+        return false;
+    }
+    if (!switch_to_transmit()) { // leaves CE low, nothing to do when already transmitting
+        return false;
+    }
+
+    constexpr u8 exchange_flags = NRF_regs::status_tx_ds | NRF_regs::status_max_rt | NRF_regs::status_rx_dr;
+    const u8 clear_command[2] = { nrf_map::status::write, exchange_flags };
+
+    u8 payload_command[sizeof(commands::write_tx_command) + fifo_max_size] = { commands::write_tx_command };
+    memcpy(payload_command + 1, data, length);
+    const u8 payload_size = sizeof(commands::write_tx_command) + (tx_dynamic_payloads() ? length : fifo_max_size);
+
+    const spi_transfer_T load_transfers[] = {
+        { sizeof(clear_command), clear_command, nullptr },
+        { payload_size, payload_command, nullptr },
+    };
+    if (!write_spi_batch(load_transfers, sizeof(load_transfers) / sizeof(load_transfers[0]))) {
+        NRF_LOGE("[NRF24::transmit_request] Failed loading the request\n");
+        return false;
+    }
+
+    // a CE pulse over 10 µs sends one packet, the radio drops back to standby-I once the ACK is in
+    pulse_ce();
+    timing_.wait_active(); // nothing is on air before Tstby2a
+
+    const int64_t timeout_us = tx_completion_timeout_us(request_timeout_us);
+    u8 status = 0;
+    if (!poll_tx_outcome(payload_size - sizeof(commands::write_tx_command), timeout_us, status)) {
+        NRF_LOGE("[NRF24::transmit_request] SPI failed while waiting for the ACK\n");
+        flush_tx_buffer();
+        return false;
+    }
+    if (!(status & (NRF_regs::status_tx_ds | NRF_regs::status_max_rt))) {
+        NRF_LOGW("[NRF24::transmit_request] No ACK or MAX_RT after %lld us\n", static_cast<long long>(timeout_us));
+        trace(Trace_Event::Tx_Failed, 0, status, 0);
+        flush_tx_buffer();
+        enter_state(Radio_State::StandbyI);
+        return false;
+    }
+    enter_state(Radio_State::StandbyI); // CE is already low, this only books the end of the TX
+
+    trace(status & NRF_regs::status_max_rt ? Trace_Event::Tx_Failed : Trace_Event::Tx_Sent, 0, status, 0);
+    if (status & NRF_regs::status_max_rt) {
+        // the request stays at the head of the TX FIFO until flushed
+        flush_tx_buffer();
+        const spi_transfer_T clear = { sizeof(clear_command), clear_command, nullptr };
+        write_spi_batch(&clear, 1);
+        return false;
+    }
+
+    if (status & NRF_regs::status_rx_dr) {
+        reply_length = read_ack_payload(reply); // also clears RX_DR
+    }
+    const spi_transfer_T clear = { sizeof(clear_command), clear_command, nullptr };
+    write_spi_batch(&clear, 1);
+    return true;
+}
+
+
+u8 NRF24::read_ack_payload(u8* buffer){
+    if (buffer == nullptr) {
+        return 0;
+    }
+
+    const u8 width = get_rx_size(); // sized per pipe, flushes a corrupt width
+    if (width == fifo_empty_size) {
+        return 0;
+    }
+
+    u8 payload_command[sizeof(commands::read_rx_buffer_command) + fifo_max_size] = { commands::read_rx_buffer_command };
+    u8 payload_response[sizeof(payload_command)] = {};
+    const u8 clear_command[2] = { nrf_map::status::write, NRF_regs::status_rx_dr };
+    const spi_transfer_T transfers[] = {
+        { static_cast<size_t>(sizeof(commands::read_rx_buffer_command) + width), payload_command, payload_response },
+        { sizeof(clear_command), clear_command, nullptr },
+    };
+    if (!write_spi_batch(transfers, sizeof(transfers) / sizeof(transfers[0]))) {
+        NRF_LOGE("[NRF24::read_ack_payload] Failed reading the payload\n");
+        return 0;
+    }
+    memcpy(buffer, payload_response + 1, width);
+    return width;
+}
+
+
+bool NRF24::apply_rf_settings(const rf_settings_T& settings, u8 ack_payload_length){
+    const uint16_t delay_us = settings.retransmit_delay_us;
+    const uint16_t min_delay_us = min_retransmit_delay_us(settings.data_rate, ack_payload_length);
+    if (delay_us < NRF_regs::retransmit_delay_step_us || delay_us > 16 * NRF_regs::retransmit_delay_step_us
+        || delay_us % NRF_regs::retransmit_delay_step_us != 0) {
+        NRF_LOGE("[NRF24::apply_rf_settings] ARD of %u us is not a multiple of 250 us in 250 - 4000 us\n", delay_us);
+        return false;
+    }
+    if (delay_us < min_delay_us) {
+        NRF_LOGE("[NRF24::apply_rf_settings] ARD of %u us is below the %u us this rate needs for %d byte ACK payloads\n",
+               delay_us, min_delay_us, ack_payload_length);
+        return false;
+    }
+    if (settings.retransmit_count > NRF_regs::max_retransmit_count || static_cast<u8>(settings.pa_level) > 3
+        || static_cast<u8>(settings.data_rate) > static_cast<u8>(Data_Rate::Rate_2Mbps) || ack_payload_length > fifo_max_size) {
+        NRF_LOGE("[NRF24::apply_rf_settings] Invalid ARC %d, PA level or data rate\n", settings.retransmit_count);
+        return false;
+    }
+
+    u8 rf_setup = 0;
+    if (!read_register_cached(NRF_regs::rf_setup_address, 1, &rf_setup)) { // keeps CONT_WAVE and PLL_LOCK as they are
+        NRF_LOGE("[NRF24::apply_rf_settings] Failed reading RF_SETUP\n");
+        return false;
+    }
+    rf_setup = nrf_map::rf_setup::rf_dr::update(rf_setup, settings.data_rate);
+    rf_setup = nrf_map::rf_setup::rf_pwr::update(rf_setup, settings.pa_level);
+
+    using nrf_map::setup_retr;
+    const u8 retransmit = nrf_map::compose<setup_retr>(setup_retr::ard(setup_retr::ard_for_us(delay_us)), setup_retr::arc(settings.retransmit_count));
+
+    register_batch_T batch = {};
+    bool written = queue_register_write(batch, NRF_regs::rf_setup_address, sizeof(rf_setup), &rf_setup);
+    written = queue_register_write(batch, NRF_regs::retransmit_details_address, sizeof(retransmit), &retransmit) && written;
+    if (batch.count != 0) {
+        // RF_SETUP changes in standby, a rate controller may call this while the radio listens
+        const Radio_State previous_state = pause_active();
+        written = flush_register_batch(batch) && written;
+        resume_active(previous_state);
+    }
+    if (!written) {
+        NRF_LOGE("[NRF24::apply_rf_settings] Failed writing RF_SETUP / SETUP_RETR\n");
+        return false;
+    }
+
+    rf_settings_ = settings;
+    ack_payload_length_ = ack_payload_length;
+    return true;
+}
+
+
+bool NRF24::set_data_rate(Data_Rate rate){
+    rf_settings_T settings = rf_settings_;
+    settings.data_rate = rate;
+    return apply_rf_settings(settings, ack_payload_length_);
+}
+
+
+bool NRF24::set_pa_level(PA_Level level){
+    rf_settings_T settings = rf_settings_;
+    settings.pa_level = level;
+    return apply_rf_settings(settings, ack_payload_length_);
+}
+
+
+bool NRF24::set_retransmit(uint16_t delay_us, u8 count, u8 ack_payload_length){
+    rf_settings_T settings = rf_settings_;
+    settings.retransmit_delay_us = delay_us;
+    settings.retransmit_count = count;
+    return apply_rf_settings(settings, ack_payload_length);
+}
+
+
+bool NRF24::read_link_quality(link_quality_T& quality) const{
+    const u8 observe_command[2] = { NRF_regs::observe_tx_address, commands::nop_command };
+    const u8 rpd_command[2] = { NRF_regs::received_power_detector_address, commands::nop_command };
+    u8 observe_response[2] = {};
+    u8 rpd_response[2] = {};
+    const spi_transfer_T transfers[] = {
+        { sizeof(observe_command), observe_command, observe_response },
+        { sizeof(rpd_command), rpd_command, rpd_response },
+    };
+    if (!write_spi_batch(transfers, sizeof(transfers) / sizeof(transfers[0]))) {
+        NRF_LOGE("[NRF24::read_link_quality] Failed reading OBSERVE_TX / RPD\n");
+        return false;
+    }
+    quality.retransmits = nrf_map::observe_tx::arc_cnt::decode(observe_response[1]);
+    quality.lost_packets = nrf_map::observe_tx::plos_cnt::decode(observe_response[1]);
+    quality.strong_signal = rpd_response[1] & NRF_regs::rpd_bit;
+    return true;
+}
+
+
+bool NRF24::set_channel(u8 channel){
+    if (channel >= NRF_regs::channel_count) {
+        NRF_LOGE("[NRF24::set_channel] Channel %d is out of range\n", channel);
+        return false;
+    }
+    if (channel == this->channel()) {
+        return true;
+    }
+
+    // RF_CH is taken on the next RX/TX entry, so listening restarts on the new channel
+    const Radio_State previous_state = pause_active();
+    const bool written = write_register_cached(NRF_regs::frequency_register_address, sizeof(channel), &channel);
+    resume_active(previous_state);
+    if (!written) {
+        NRF_LOGE("[NRF24::set_channel] Failed writing RF_CH\n");
+    }
+    return written;
+}
+
+
+u8 NRF24::channel() const{
+    return shadow_registers_[NRF_regs::frequency_register_address];
+}
+
+
+bool NRF24::scan_channels(uint16_t sweeps, uint16_t dwell_us){
+    if (sweeps == 0 || irq_running_.load()) {
+        NRF_LOGE("[NRF24::scan_channels] Cannot scan %u sweeps now\n", sweeps);
+        return false;
+    }
+    if (dwell_us < rpd_min_dwell_us) {
+        dwell_us = rpd_min_dwell_us;
+    }
+
+    channel_scan_ = {};
+    channel_scan_.sweeps = sweeps;
+    channel_scan_.dwell_us = dwell_us;
+    const int64_t started_us = timing_.now_us();
+
+    if (!switch_to_recieve() || !enter_state(Radio_State::StandbyI)) {
+        return false;
+    }
+
+    // RF_CH is written around the shadow cache, which keeps the working channel for the restore below
+    const u8 rf_ch_command = nrf_map::rf_ch::write;
+    const u8 rpd_command[2] = { NRF_regs::received_power_detector_address, commands::nop_command };
+    u8 rpd_response[2] = {};
+    u8 channel_command[2] = { rf_ch_command, 0 };
+
+    bool ok = write_spi_command(channel_command, nullptr, sizeof(channel_command));
+    for (uint16_t sweep = 0; ok && sweep < sweeps; ++sweep) {
+        for (u8 channel = 0; channel < NRF_regs::channel_count; ++channel) {
+            enter_state(Radio_State::RxActive);
+            timing_.delay_us(dwell_us);
+            enter_state(Radio_State::StandbyI); // leaving RX latches RPD
+
+            // read this channel's RPD and tune to the next one in the same batch
+            const u8 next_channel = channel + 1 < NRF_regs::channel_count ? channel + 1 : 0;
+            channel_command[1] = next_channel;
+            const spi_transfer_T transfers[] = {
+                { sizeof(rpd_command), rpd_command, rpd_response },
+                { sizeof(channel_command), channel_command, nullptr },
+            };
+            if (!write_spi_batch(transfers, sizeof(transfers) / sizeof(transfers[0]))) {
+                NRF_LOGE("[NRF24::scan_channels] SPI failed on channel %d\n", channel);
+                ok = false;
+                break;
+            }
+            if (rpd_response[1] & NRF_regs::rpd_bit) {
+                channel_scan_.busy[channel]++;
+            }
+        }
+    }
+
+    const u8 working_channel = channel();
+    channel_command[1] = working_channel;
+    ok = write_spi_command(channel_command, nullptr, sizeof(channel_command)) && ok;
+    flush_rx_buffer();
+    clear_RxDR();
+    enter_state(Radio_State::RxActive);
+
+    channel_scan_.elapsed_us = timing_.now_us() - started_us;
+    NRF_LOGI("[NRF24::scan_channels] %u sweeps of %d channels in %lld us, back on channel %d\n", sweeps,
+           NRF_regs::channel_count, static_cast<long long>(channel_scan_.elapsed_us), working_channel);
+    return ok;
+}
+
+
+void NRF24::dump_channel_scan() const{
+    printf("[NRF24::dump_channel_scan] busy sweeps per channel out of %u, %u us dwell\n", channel_scan_.sweeps, channel_scan_.dwell_us);
+    for (u8 row = 0; row < NRF_regs::channel_count; row += 16) {
+        printf("  %3d:", row);
+        for (u8 channel = row; channel < row + 16 && channel < NRF_regs::channel_count; ++channel) {
+            printf(" %3u", channel_scan_.busy[channel]);
+        }
+        printf("\n");
+    }
+}
+
+
+uint32_t NRF24::channel_score(u8 channel) const{
+    // doubled so each neighbour counts half
+    uint32_t score = 2u * channel_scan_.busy[channel];
+    if (channel > 0) {
+        score += channel_scan_.busy[channel - 1];
+    }
+    if (channel + 1 < NRF_regs::channel_count) {
+        score += channel_scan_.busy[channel + 1];
+    }
+    return score;
+}
+
+
+u8 NRF24::quietest_channel(u8 first, u8 last) const{
+    u8 channel = 0;
+    return quietest_channels(&channel, 1, 0, first, last) == 1 ? channel : this->channel();
+}
+
+
+size_t NRF24::quietest_channels(u8* channels, size_t count, u8 min_spacing, u8 first, u8 last) const{
+    if (channels == nullptr || channel_scan_.sweeps == 0) {
+        return 0;
+    }
+    if (last >= NRF_regs::channel_count) {
+        last = NRF_regs::channel_count - 1;
+    }
+    if (first > last) {
+        return 0;
+    }
+
+    std::array<u8, NRF_regs::channel_count> order = {};
+    const size_t candidates = last - first + 1;
+    for (size_t i = 0; i < candidates; ++i) {
+        order[i] = static_cast<u8>(first + i);
+    }
+    std::stable_sort(order.begin(), order.begin() + candidates, [this](u8 a, u8 b) { return channel_score(a) < channel_score(b); });
+
+    size_t picked = 0;
+    for (size_t i = 0; i < candidates && picked < count; ++i) {
+        bool spaced = true;
+        for (size_t j = 0; j < picked; ++j) {
+            const int distance = static_cast<int>(order[i]) - static_cast<int>(channels[j]);
+            if (distance < min_spacing && -distance < min_spacing) {
+                spaced = false;
+                break;
+            }
+        }
+        if (spaced) {
+            channels[picked++] = order[i];
+        }
+    }
+    return picked;
+}
+
+
+int64_t NRF24::tx_completion_timeout_us(int64_t floor_us) const{
+    // 32 byte packet at 250kbps with 5 byte address and 2 byte CRC is ~1.3 ms on air, plus 130 µs settling
+    constexpr int64_t worst_attempt_overhead_us = 1500;
+    const int64_t attempts = static_cast<int64_t>(rf_settings_.retransmit_count) + 1;
+    const int64_t budget_us = attempts * (rf_settings_.retransmit_delay_us + worst_attempt_overhead_us);
+    return budget_us > floor_us ? budget_us : floor_us;
+}
+
+
+uint32_t NRF24::packet_airtime_us(u8 payload_bytes) const{
+    const u8 config_value = shadow_registers_[NRF_regs::config_register_address];
+    const u8 address_bytes = static_cast<u8>(nrf_map::setup_aw::aw::decode(shadow_registers_[NRF_regs::address_width_address])) + 2;
+    // the radio forces EN_CRC on while any pipe has auto-ack
+    const bool crc = nrf_map::config::en_crc::decode(config_value) || shadow_registers_[NRF_regs::auto_acknowledge_config_address] != 0;
+    const u8 crc_bytes = !crc ? 0 : (nrf_map::config::crco::decode(config_value) ? 2 : 1);
+    const uint32_t bits = 8u * (1 + address_bytes + payload_bytes + crc_bytes) + 9;
+    switch (rf_settings_.data_rate) {
+        case Data_Rate::Rate_250kbps: return bits * 4;
+        case Data_Rate::Rate_1Mbps: return bits;
+        default: return bits / 2;
+    }
+}
+
+
+bool NRF24::poll_tx_outcome(u8 payload_bytes, int64_t timeout_us, u8& status){
+    const int64_t started_us = timing_.now_us();
+    timing_.delay_us(packet_airtime_us(payload_bytes));
+
+    uint32_t pause_us = tx_poll_min_us;
+    while (true) {
+        if (!write_spi_command(&commands::nop_command, &status, sizeof(commands::nop_command))) {
+            return false;
+        }
+        if ((status & (NRF_regs::status_tx_ds | NRF_regs::status_max_rt)) || timing_.now_us() - started_us > timeout_us) {
+            return true;
+        }
+        timing_.delay_us(pause_us);
+        pause_us = pause_us * 2 < tx_poll_max_us ? pause_us * 2 : tx_poll_max_us;
+    }
+}
+
+
+size_t NRF24::sweep_link(const rf_settings_T* settings, size_t count, link_sweep_result_T* results, uint16_t packets_per_setting,
+                         u8 payload_length, sweep_peer_hook_T peer_hook, void* context){
+    if (settings == nullptr || results == nullptr || count == 0 || packets_per_setting == 0 || packets_per_setting > sweep_max_packets
+        || payload_length == fifo_empty_size || payload_length > fifo_max_size) {
+        NRF_LOGE("[NRF24::sweep_link] Invalid sweep of %u packets of %d bytes\n", packets_per_setting, payload_length);
+        return 0;
+    }
+
+    const rf_settings_T original = rf_settings_;
+    const u8 original_ack_payload_length = ack_payload_length_;
+
+    u8 payload[fifo_max_size] = {};
+    for (u8 i = 0; i < payload_length; ++i) {
+        payload[i] = i;
+    }
+    u8 reply[fifo_max_size] = {};
+    std::array<uint32_t, sweep_max_packets> latencies = {};
+
+    size_t measured = 0;
+    for (size_t index = 0; index < count; ++index) {
+        link_sweep_result_T& result = results[index];
+        result = {};
+        result.settings = settings[index];
+
+        if (peer_hook != nullptr && !peer_hook(settings[index], context)) {
+            NRF_LOGW("[NRF24::sweep_link] Peer rejected setting %u\n", static_cast<unsigned>(index));
+            continue;
+        }
+        if (!apply_rf_settings(settings[index], original_ack_payload_length)) {
+            continue;
+        }
+        result.applied = true;
+        measured++;
+
+        const int64_t started_us = timing_.now_us();
+        for (uint16_t packet = 0; packet < packets_per_setting; ++packet) {
+            payload[0] = static_cast<u8>(packet);
+            u8 reply_length = 0;
+            result.sent++;
+
+            const int64_t sent_us = timing_.now_us();
+            if (!transmit_request(payload, payload_length, reply, reply_length)) {
+                continue;
+            }
+            latencies[result.delivered++] = static_cast<uint32_t>(timing_.now_us() - sent_us);
+
+            const spi_frame_T observe = read_register(NRF_regs::observe_tx_address, 1);
+            if (observe) {
+                result.retransmits += nrf_map::observe_tx::arc_cnt::decode(observe.data()[0]);
+            }
+        }
+        const int64_t elapsed_us = timing_.now_us() - started_us;
+
+        if (result.delivered > 0) {
+            std::sort(latencies.begin(), latencies.begin() + result.delivered);
+            auto percentile = [&](uint32_t percent) { return latencies[(result.delivered - 1) * percent / 100]; };
+            result.latency_p50_us = percentile(50);
+            result.latency_p90_us = percentile(90);
+            result.latency_p99_us = percentile(99);
+            result.latency_max_us = latencies[result.delivered - 1];
+        }
+        if (elapsed_us > 0) {
+            result.goodput_bps = static_cast<uint32_t>(static_cast<uint64_t>(result.delivered) * payload_length * 8 * 1000000 / elapsed_us);
+        }
+
+        NRF_LOGI("[NRF24::sweep_link] rate %d pa %d ard %u arc %d: %u/%u delivered, %u retransmits, p50 %u p90 %u p99 %u max %u us, %u bps\n",
+               static_cast<int>(result.settings.data_rate), static_cast<int>(result.settings.pa_level), result.settings.retransmit_delay_us,
+               result.settings.retransmit_count, result.delivered, result.sent, result.retransmits, result.latency_p50_us,
+               result.latency_p90_us, result.latency_p99_us, result.latency_max_us, result.goodput_bps);
+    }
+
+    if (peer_hook != nullptr) {
+        peer_hook(original, context);
+    }
+    apply_rf_settings(original, original_ack_payload_length);
+    switch_to_recieve();
+    return measured;
+}
+
+
+spi_frame_T NRF24::read_register(const u8& register_address, const u8& data_bytes_length) const{
+    spi_frame_T response;
+    if (data_bytes_length == 0 || data_bytes_length >= spi_frame_T::capacity) {
+        NRF_LOGE("[NRF24] Error: data_bytes_length must be between 1 and %d\n", spi_frame_T::capacity - 1);
+        return response;
+    }
+
+    const u8 full_buffer_size = sizeof(register_address) + data_bytes_length;
+
+    // dummy bytes after the command are zero, they only clock the register out
+    std::array<u8, spi_frame_T::capacity> tx_buffer = {};
+    tx_buffer[0] = register_address; // Read command – MSBs should already be 0
+    
+    NRF_LOGV("[NRF24] read_register called: reg=0x%02X, len=%d, cmd=", register_address, data_bytes_length);
+    for (u8 i = 0; i < full_buffer_size; ++i) {
+        NRF_LOGV("0x%02X ", tx_buffer[i]);
+    }
+    NRF_LOGV("\n");
+    
+    gpio_set_level(pins_layout.CSN, voltage_flow::low);
+    bool result = write_spi_command(tx_buffer.data(), response.bytes.data(), full_buffer_size);
+    gpio_set_level(pins_layout.CSN, voltage_flow::high);
+
+#if NRF_LOG_LEVEL >= NRF_LOG_LEVEL_VERBOSE
+    NRF_LOGV("Pin after attempting to Raise it: ");
+    if (gpio_get_level(pins_layout.CSN) == voltage_flow::high) {
+        NRF_LOGV("Pin is HIGH\n");
+    } else {
+        NRF_LOGV("Pin is LOW\n");
+    }
+#endif
+
+
+    //printf("[NRF24] write_spi_command result: %s\n", result ? "true" : "false");
+    if (!result) {
+        return response;
+    }
+    response.length = full_buffer_size;
+    response.ok = true;
     
+    NRF_LOGV("[NRF24] SPI read returned: ");
+    for (u8 i = 0; i < full_buffer_size; ++i) {
+        NRF_LOGV("0x%02X ", response[i]);
+    }
+
+    NRF_LOGV("\n\n");
+    return response;
+}
+
+
+
+
+spi_frame_T NRF24::write_register(const u8& register_address, const u8& data_bytes_length, const u8* databytes) const {
+
+
+    NRF_LOGV("[NRF24::write_register] write_register called: reg=0x%02X, len=%d, data=0x", register_address, data_bytes_length);
+    for (u8 i = 0; i < data_bytes_length; ++i) {
+        NRF_LOGV("%02X ", databytes[i]);
+    }
+    NRF_LOGV("\n");
 
-    u8 command_data[max_buffer_size] = {};
+    spi_frame_T response;
+    const u8 full_buffer_size = data_bytes_length+sizeof(register_address);
 
+    if (data_bytes_length >= spi_frame_T::capacity) {
+        NRF_LOGE("[NRF24::write_register] data_bytes_length %d too large\n", data_bytes_length);
+        return response;
+    }
 
-    u8 write_register_prefix = 0x20;
+    std::array<u8, spi_frame_T::capacity> command_data = {};
 
-    command_data[0] = write_register_prefix | register_address;//TODO : consider changing this, it limits register address but can create obsfucated bugs
-    memcpy(command_data + sizeof(write_register_prefix), databytes, data_bytes_length);//TODO Last byte likely ignored
+    command_data[0] = nrf_map::write_command(register_address);
+    memcpy(command_data.data() + sizeof(NRF_regs::write_register_prefix), databytes, data_bytes_length);//TODO Last byte likely ignored
 
-    bool result = write_spi_command(command_data, rx_buffer, full_buffer_size);
-    printf("[NRF24::write_register] write_spi_command result: %s\n", result ? "true" : "false");
+    bool result = write_spi_command(command_data.data(), response.bytes.data(), full_buffer_size);
+    NRF_LOGD("[NRF24::write_register] write_spi_command result: %s\n", result ? "true" : "false");
 
     if(!result){
-        printf("[NRF24::write_register] Returning null buffer from Write Register.\n");
-        free(rx_buffer);
-        return nullptr;
+        NRF_LOGE("[NRF24::write_register] Returning failed frame from Write Register.\n");
+        return response;
     }
 
-    return rx_buffer;
+    response.length = full_buffer_size;
+    response.ok = true;
+    return response;
 
 }
 
 
 void NRF24::clear_rx(){
-    drop_ce_pin();
-
-    u8 command_size(1);
+    constexpr u8 command_size(1);
     u8 dummy_rx[command_size] = {};
 
-    write_spi_command(commands::flush_rx_command, dummy_rx, command_size);
+    write_spi_command(&commands::flush_rx_command, dummy_rx, command_size);
 
-    u8 clear = 0x40;
+    u8 clear = NRF_regs::status_rx_dr;
     spi_command_wrapper(NRF_regs::status_register_address, sizeof(clear), &clear);
-
-
-    raise_ce_pin(); // TODO : Return ce to original state
     return;
 }
 
@@ -680,23 +2029,66 @@ void NRF24::clear_rx(){
 
 
 
-bool NRF24::write_spi_command(u8* transmit_buffer, u8* recieve_buffer, u8 buffer_length) {
+bool NRF24::write_spi_command(const u8* transmit_buffer, u8* recieve_buffer, u8 buffer_length) const {
     // printf("[NRF24] write_spi_command called with buffer_length: %d\n", buffer_length);
 
     if (buffer_length == 0 || !transmit_buffer) {
-        printf("[NRF24::write_spi_command] Error: invalid buffer_length (%d) or transmit_buffer is null\n", buffer_length);
+        NRF_LOGE("[NRF24::write_spi_command] Error: invalid buffer_length (%d) or transmit_buffer is null\n", buffer_length);
         return false;
     }
     esp_err_t result = spi_->send_data(buffer_length, transmit_buffer, recieve_buffer);
+    trace_spi(transmit_buffer, recieve_buffer, buffer_length, result == ESP_OK);
+
+    if (result != ESP_OK) {
+        NRF_LOGE("[NRF24::write_spi_command] SPI transfer failed with error: 0x%x\n", result);
+        return false;
+    }
+    return true;
+}
 
+bool NRF24::write_spi_batch(const spi_transfer_T* transfers, size_t count) const {
+    if (transfers == nullptr || count == 0) {
+        NRF_LOGE("[NRF24::write_spi_batch] Error: empty batch\n");
+        return false;
+    }
+    esp_err_t result = spi_->send_batch(transfers, count);
+#if NRF_TRACE_ENABLED
+    for (size_t i = 0; i < count; ++i) {
+        trace_spi(transfers[i].tx_data, transfers[i].rx_data, transfers[i].data_size, result == ESP_OK);
+    }
+#endif
 
     if (result != ESP_OK) {
-        printf("[NRF24::write_spi_command] SPI transfer failed with error: 0x%x\n", result);
+        NRF_LOGE("[NRF24::write_spi_batch] SPI batch failed with error: 0x%x\n", result);
         return false;
     }
     return true;
 }
 
+void NRF24::trace_spi(const u8* transmit_buffer, const u8* recieve_buffer, size_t length, bool ok) const {
+#if NRF_TRACE_ENABLED
+    if (trace_ == nullptr || transmit_buffer == nullptr || length == 0 || transmit_buffer[0] == commands::nop_command) {
+        return; // NOPs are STATUS polls, the outcome events carry STATUS instead
+    }
+    const u8 command = transmit_buffer[0];
+    const u8 status = recieve_buffer != nullptr ? recieve_buffer[0] : 0;
+    const u8 length_byte = static_cast<u8>(length);
+    if (!ok) {
+        trace_->record(Trace_Event::Spi_Error, command, status, length_byte);
+    } else if (command < NRF_regs::write_register_prefix) {
+        const u8 value = recieve_buffer != nullptr && length > 1 ? recieve_buffer[1] : 0;
+        trace_->record(Trace_Event::Register_Read, command, status, value);
+    } else if (command < (NRF_regs::write_register_prefix << 1)) {
+        const u8 value = length > 1 ? transmit_buffer[1] : 0;
+        trace_->record(Trace_Event::Register_Write, command & ~NRF_regs::write_register_prefix, status, value);
+    } else {
+        trace_->record(Trace_Event::Command, command, status, length_byte);
+    }
+#else
+    (void)transmit_buffer; (void)recieve_buffer; (void)length; (void)ok;
+#endif
+}
+
 u8 NRF24::get_status(){
     constexpr u8 command_size = 1;
     u8 nop_command[command_size] = {0xFF};
@@ -704,11 +2096,11 @@ u8 NRF24::get_status(){
 
     bool ok = write_spi_command(nop_command, status_response, command_size);
     if (!ok) {
-        printf("[NRF24::get_status] SPI transaction failed\n");
+        NRF_LOGE("[NRF24::get_status] SPI transaction failed\n");
         return 0xFF; // invalid status
     }
 
-    printf("[NRF24::get_status] STATUS = 0x%02X\n", status_response[0]);
+    NRF_LOGD("[NRF24::get_status] STATUS = 0x%02X\n", status_response[0]);
     return status_response[0];
 }
 
@@ -754,7 +2146,7 @@ void NRF24::dump_all_registers() {
     printf("(First byte is STATUS; following are the actual register bytes.)\n\n");
 
     for (const auto& r : regs) {
-        u8* buf = read_register(r.addr, r.len);
+        const spi_frame_T buf = read_register(r.addr, r.len);
         if (!buf) {
             printf("%-12s (0x%02X): <ERR>\n", r.name, r.addr);
             continue;
@@ -766,11 +2158,242 @@ void NRF24::dump_all_registers() {
             printf(" 0x%02X", buf[1 + i]);
         }
         printf("\n");
-    
-        free(buf);
     }
     printf("=================================\n");
     printf("=================================\n");
     printf("=================================\n");
     return;
 }
+
+
+
+void IRAM_ATTR NRF24::irq_isr_handler(void* arg){
+    NRF24* radio = static_cast<NRF24*>(arg);
+    TaskHandle_t task = radio->irq_task_.load();
+    if (task == nullptr) {
+        return;
+    }
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(task, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+
+void NRF24::irq_task(void* arg){
+    NRF24* radio = static_cast<NRF24*>(arg);
+
+    while (radio->irq_running_) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!radio->irq_running_) {
+            break;
+        }
+        radio->service_irq();
+    }
+
+    radio->irq_task_ = nullptr;
+    vTaskDelete(nullptr);
+}
+
+
+bool NRF24::start_irq_rx(rx_callback_T callback, void* context, UBaseType_t task_priority){
+    if ((callback == nullptr && rx_ring_push_ == nullptr && !has_pipe_routes()) || pins_layout.IRQ == GPIO_NUM_NC) {
+        NRF_LOGE("[NRF24::start_irq_rx] Needs a callback or ring and a wired IRQ pin\n");
+        return false;
+    }
+    if (irq_task_ != nullptr) {
+        NRF_LOGE("[NRF24::start_irq_rx] IRQ receive mode already running\n");
+        return false;
+    }
+
+    rx_callback_ = callback;
+    rx_callback_context_ = context;
+
+    // only RX_DR drives the pin, otherwise an unread TX_DS would hold IRQ low and hide every later edge
+    irq_mask_ = NRF_regs::config_mask_tx_ds | NRF_regs::config_mask_max_rt;
+    if (!change_antenna_mode(mode_)) {
+        NRF_LOGE("[NRF24::start_irq_rx] Failed masking TX interrupts\n");
+        irq_mask_ = 0;
+        return false;
+    }
+
+    gpio_config_t irq_config = {};
+    irq_config.pin_bit_mask = 1ULL << pins_layout.IRQ;
+    irq_config.mode = GPIO_MODE_INPUT;
+    irq_config.pull_up_en = GPIO_PULLUP_ENABLE;
+    irq_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    irq_config.intr_type = GPIO_INTR_NEGEDGE; // IRQ is active low
+    gpio_config(&irq_config);
+
+    esp_err_t isr_service_result = gpio_install_isr_service(0);
+    if (isr_service_result != ESP_OK && isr_service_result != ESP_ERR_INVALID_STATE) { // already installed is fine
+        NRF_LOGE("[NRF24::start_irq_rx] gpio_install_isr_service failed: 0x%x\n", isr_service_result);
+        irq_mask_ = 0;
+        change_antenna_mode(mode_);
+        return false;
+    }
+
+    irq_running_ = true;
+    TaskHandle_t task = nullptr;
+    if (xTaskCreate(irq_task, "nrf24_irq", 4096, this, task_priority, &task) != pdPASS) {
+        NRF_LOGE("[NRF24::start_irq_rx] Failed creating the radio task\n");
+        irq_running_ = false;
+        irq_mask_ = 0;
+        change_antenna_mode(mode_);
+        return false;
+    }
+    irq_task_ = task;
+
+    gpio_isr_handler_add(pins_layout.IRQ, irq_isr_handler, this);
+    switch_to_recieve();
+
+    // a packet that landed before the handler was attached never produces an edge, drain it now
+    xTaskNotifyGive(task);
+    return true;
+}
+
+
+void NRF24::stop_irq_rx(){
+    TaskHandle_t task = irq_task_.load();
+    if (task == nullptr) {
+        return;
+    }
+
+    gpio_isr_handler_remove(pins_layout.IRQ);
+    irq_running_ = false;
+    xTaskNotifyGive(task);
+    while (irq_task_ != nullptr) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    irq_mask_ = 0;
+    change_antenna_mode(mode_);
+    rx_callback_ = nullptr;
+    rx_callback_context_ = nullptr;
+}
+
+
+void NRF24::detach_rx_ring(){
+    rx_ring_push_ = nullptr;
+    rx_ring_ = nullptr;
+}
+
+
+u8 NRF24::service_irq(){
+    // the whole drain is a burst of short commands, hold the bus instead of arbitrating per transfer
+    spi_burst burst(*spi_);
+
+    // clear RX_DR before draining, a packet landing mid-drain then raises a fresh falling edge
+    const u8 clear_command[2] = {
+        nrf_map::status::write,
+        NRF_regs::status_rx_dr
+    };
+    u8 clear_response[sizeof(clear_command)] = {};
+    if (!write_spi_command(clear_command, clear_response, sizeof(clear_command))) {
+        NRF_LOGE("[NRF24::service_irq] Failed clearing RX_DR\n");
+        return 0;
+    }
+    u8 status = clear_response[0];
+
+    constexpr u8 payload_command_size = sizeof(commands::read_rx_buffer_command) + fifo_max_size;
+    u8 payload_command[payload_command_size] = { commands::read_rx_buffer_command };
+    u8 payload_response[payload_command_size] = {};
+
+    // the payload read clocks out STATUS from before the pop, the command queued behind it gives the updated RX_P_NO.
+    // With any dynamic pipe that command is R_RX_PL_WID, which also reports the width of the next packet.
+    const bool dynamic = dynamic_pipes_ != 0;
+    const u8 follow_command[2] = { dynamic ? commands::get_rx_size_command : commands::nop_command, commands::nop_command };
+    u8 follow_response[sizeof(follow_command)] = {};
+    const size_t follow_size = dynamic ? sizeof(follow_command) : sizeof(commands::nop_command);
+
+    u8 reported_width = 0;
+    if (dynamic && (status & NRF_regs::status_rx_p_no_mask) != NRF_regs::status_rx_fifo_empty) {
+        if (!write_spi_command(follow_command, follow_response, sizeof(follow_command))) {
+            NRF_LOGE("[NRF24::service_irq] Failed reading RX payload width\n");
+            return 0;
+        }
+        status = follow_response[0];
+        reported_width = follow_response[1];
+    }
+
+    u8 packets = 0;
+    // bounded so a stuck bus cannot spin the task forever
+    while ((status & NRF_regs::status_rx_p_no_mask) != NRF_regs::status_rx_fifo_empty
+           && packets < NRF_regs::rx_fifo_depth * 2) {
+
+        const u8 pipe = nrf_map::status::rx_p_no::decode(status);
+        const u8 width = payload_width(status, reported_width);
+        if (width == fifo_empty_size || width > fifo_max_size) {
+            NRF_LOGE("[NRF24::service_irq] Corrupt payload width %d, flushing RX FIFO\n", width);
+            flush_rx_buffer();
+            break;
+        }
+
+        const spi_transfer_T drain_transfers[] = {
+            { static_cast<size_t>(sizeof(commands::read_rx_buffer_command) + width), payload_command, payload_response },
+            { follow_size, follow_command, follow_response },
+        };
+        if (!write_spi_batch(drain_transfers, sizeof(drain_transfers) / sizeof(drain_transfers[0]))) {
+            NRF_LOGE("[NRF24::service_irq] Failed reading RX payload\n");
+            break;
+        }
+        packets++;
+        deliver_packet(pipe, payload_response + 1, width);
+
+        status = follow_response[0];
+        reported_width = dynamic ? follow_response[1] : 0;
+    }
+    trace(Trace_Event::Rx_Drain, 0, status, packets);
+    return packets;
+}
+
+
+void NRF24::deliver_packet(u8 pipe, const u8* data, u8 length){
+    if (pipe < pipe_routes_.size()) {
+        const pipe_route_T& route = pipe_routes_[pipe];
+        if (route.handler != nullptr || route.ring_push != nullptr) {
+            if (route.ring_push != nullptr) {
+                route.ring_push(route.ring, data, length, pipe, esp_timer_get_time());
+            }
+            if (route.handler != nullptr) {
+                route.handler(data, length, route.context);
+            }
+            return;
+        }
+    }
+
+    if (rx_ring_push_ != nullptr) {
+        rx_ring_push_(rx_ring_, data, length, pipe, esp_timer_get_time());
+    }
+    if (rx_callback_ != nullptr) {
+        rx_callback_(data, length, rx_callback_context_);
+    }
+}
+
+
+bool NRF24::has_pipe_routes() const{
+    for (const pipe_route_T& route : pipe_routes_) {
+        if (route.handler != nullptr || route.ring_push != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void NRF24::set_pipe_handler(u8 pipe, rx_callback_T handler, void* context){
+    if (pipe >= pipe_routes_.size()) {
+        NRF_LOGE("[NRF24::set_pipe_handler] Pipe %d does not exist\n", pipe);
+        return;
+    }
+    pipe_routes_[pipe].handler = handler;
+    pipe_routes_[pipe].context = context;
+}
+
+
+void NRF24::detach_pipe_ring(u8 pipe){
+    if (pipe >= pipe_routes_.size()) {
+        return;
+    }
+    pipe_routes_[pipe].ring_push = nullptr;
+    pipe_routes_[pipe].ring = nullptr;
+}
@@ -4,23 +4,158 @@
 
 
 #include "spi_object.hpp"
+#include "packet_ring.hpp"
+#include "nrf_log.hpp"
+#include "nrf_trace.hpp"
+#include "radio_timing.hpp"
+#include "radio_state.hpp"
+#include "nrf_registers.hpp"
+#include "radio_profile.hpp"
+
+#include <array>
+#include <atomic>
 
 extern "C" {
     #include <stdlib.h>
     #include <stdint.h>
     #include <stdio.h>
     #include <string.h>
+    #include "freertos/FreeRTOS.h"
+    #include "freertos/task.h"
     #include "driver/gpio.h"
+    #include "esp_attr.h"
     #include "esp_timer.h"
+    #include "esp_random.h"
     #include <rom/ets_sys.h>
 
 }
 
 using u8 = uint8_t;
 
-enum class Antenna_Mode :u8{
-    Transmit,
-    Recieve
+/**
+ * @brief counts for the shadow register cache, writes_skipped + reads_served is the number of SPI transactions saved
+ */
+struct register_cache_stats_T{
+    uint32_t writes_skipped;
+    uint32_t writes;
+    uint32_t reads_served;
+    uint32_t reads;
+};
+
+/**
+ * @brief data rate, power and auto-retransmit settings of a link, see NRF24::apply_rf_settings
+ */
+struct rf_settings_T{
+    Data_Rate data_rate;
+    PA_Level pa_level;
+    uint16_t retransmit_delay_us;   // ARD, 250 - 4000 in steps of 250, counted from the end of one attempt to the next
+    u8 retransmit_count;            // ARC, 0 - 15, 0 disables retransmits
+};
+
+/**
+ * @brief what NRF24::sweep_link measured for one rf_settings_T
+ */
+struct link_sweep_result_T{
+    rf_settings_T settings;
+    bool applied;                   // false if either end rejected the settings, nothing was sent
+    uint32_t sent;
+    uint32_t delivered;             // TX_DS
+    uint32_t retransmits;           // OBSERVE_TX ARC_CNT summed over the delivered packets
+    uint32_t latency_p50_us;        // packet load to TX_DS, delivered packets only
+    uint32_t latency_p90_us;
+    uint32_t latency_p99_us;
+    uint32_t latency_max_us;
+    uint32_t goodput_bps;           // delivered payload bits per second of the whole run
+};
+
+/**
+ * @brief OBSERVE_TX and RPD read together, see NRF24::read_link_quality
+ */
+struct link_quality_T{
+    u8 retransmits;     // ARC_CNT, retransmits of the last packet
+    u8 lost_packets;    // PLOS_CNT, packets that hit MAX_RT since RF_CH was last written, saturates at 15
+    bool strong_signal; // RPD, the last reception (an ACK on a transmitter) was above -64 dBm
+};
+
+/**
+ * @brief occupancy histogram built by NRF24::scan_channels
+ */
+struct channel_scan_T{
+    std::array<uint16_t, 126> busy;     // per RF_CH 0 - 125, sweeps in which RPD saw a carrier above -64 dBm
+    uint16_t sweeps;
+    uint16_t dwell_us;                  // time spent listening on each channel per sweep
+    int64_t elapsed_us;                 // whole scan, SPI included
+};
+
+/**
+ * @brief listen-before-talk settings of transmit_data, see NRF24::set_csma
+ */
+struct csma_config_T{
+    bool enabled = false;
+    uint16_t listen_us = 320;               // RX time per carrier check, RX settling plus the 130 µs gap between back to back packets and 40 µs for RPD
+    uint16_t backoff_slot_us = 250;
+    u8 max_backoff_exponent = 5;            // backoff is 1 - 2^n slots, n grows by one per busy listen up to this
+    u8 max_attempts = 6;                    // listens before giving up on the packet
+    bool transmit_when_exhausted = false;   // send anyway after max_attempts busy listens instead of failing
+};
+
+/**
+ * @brief running totals of the listen-before-talk mode
+ */
+struct csma_stats_T{
+    uint32_t clear_first;           // packets that found the channel clear on the first listen
+    uint32_t deferrals;             // busy listens, each one followed by a random backoff
+    uint32_t collisions_avoided;    // packets sent after deferring at least once, blind they would have hit a busy channel
+    uint32_t access_failures;       // packets that never found the channel clear
+    uint64_t backoff_us;            // time spent backing off
+};
+
+/**
+ * @brief Fixed capacity result of one register transaction, lives on the caller's stack so the
+ * register path never touches the heap.
+ * bytes[0] is the STATUS clocked out with the command, bytes[1..length-1] the register data.
+ */
+struct spi_frame_T{
+    static constexpr u8 capacity = 1 + 32;
+
+    std::array<u8, capacity> bytes = {};
+    u8 length = 0;
+    bool ok = false;
+
+    u8 status() const { return bytes[0]; }
+    const u8* data() const { return bytes.data() + 1; }
+    u8 operator[](size_t index) const { return bytes[index]; }
+    explicit operator bool() const { return ok; }
+};
+
+/**
+ * @brief one packet of a transmit stream, data must stay valid until transmit_stream returns
+ */
+struct tx_packet_T{
+    const u8* data;
+    u8 length;
+    bool no_ack;    // sent with W_TX_PAYLOAD_NOACK, the receiver sends no ACK and the radio never retransmits it
+};
+
+/**
+ * @brief outcome of the last transmit_stream call
+ */
+struct tx_stream_stats_T{
+    uint32_t delivered;     // TX_DS, or sent without auto-ack
+    uint32_t failed;        // MAX_RT, timed out or never loaded
+    uint32_t polls;         // STATUS/FIFO_STATUS reads while streaming
+    int64_t elapsed_us;
+};
+
+/**
+ * @brief settings for one RX pipe, see NRF24::configure_pipe
+ */
+struct pipe_config_T{
+    bool enabled = true;
+    std::array<u8, 5> address = {};     // pipes 0 and 1: full address, LSByte first. Pipes 2-5: only address[0], the rest is pipe 1's
+    u8 payload_width = 32;              // static payload width, ignored when dynamic_payload is set
+    bool dynamic_payload = false;
+    bool auto_ack = false;
 };
 
 struct Pins_T{
@@ -30,25 +165,34 @@ struct Pins_T{
     const gpio_num_t MISO;
     const gpio_num_t MOSI;
     const gpio_num_t IRQ;
-}
+};
 
 
 
 class NRF24{
 
     private:
-        const spi_object spi_;
+        spi_object* const spi_;
 
         const Pins_T pins_layout;
 
         const u8 buffer_size_;
 
+        // CE and CONFIG writes come from const methods too, the timestamps are bookkeeping, not radio state
+        mutable radio_timing timing_;
+
+        // the constructor powers the radio up, whatever it was doing before the MCU reset
+        Radio_State state_ = Radio_State::PowerDown;
+        Antenna_Mode mode_ = Antenna_Mode::Recieve;    // PRIM_RX in CONFIG, the direction standby-I leaves in
+        int64_t state_since_us_ = 0;
+        radio_state_stats_T state_stats_ = {};
+
 
         /**
          * @brief maximun size the fifo buffer can be with the nrf24l01, used commonly when dynamic payloads is disabled
          */
-        inline constexpr size_t max_buffer_size = 32;
-        inline constexpr u8 fifo_empty_size = 0;
+        static constexpr size_t max_buffer_size = 32;
+        static constexpr u8 fifo_empty_size = 0;
 
 
         /** 
@@ -85,9 +229,10 @@ class NRF24{
 
 
         /**
-         * @brief gets the size of the current data inside the rx fifo
+         * @brief gets the size of the payload at the head of the rx fifo with R_RX_PL_WID, only meaningful with dynamic payloads
          * 
-         * @return const int - size of data in rx buffer
+         * @return const u8 - size of data in rx buffer, 0 if the fifo is empty or the read failed. A width above 32 is
+         * corrupt and flushes the rx fifo as the datasheet requires.
          */
 
         const u8 get_rx_size()const ;
@@ -108,9 +253,60 @@ class NRF24{
         bool change_antenna_mode(const Antenna_Mode& rx_mode);
 
         /**
+         * @brief writes CONFIG through the shadow cache: PWR_UP, PRIM_RX and the interrupt mask
+         *
+         * @param direction PRIM_RX, kept in mode_
+         * @param powered PWR_UP
+         *
+         * @return bool - false if the SPI write failed
+         */
+        bool write_config(Antenna_Mode direction, bool powered);
+
+        /**
+         * @brief Moves the radio to target one legal step at a time (radio_transitions::next_step), each step doing
+         * only what differs: no CONFIG write when the shadow copy already matches, no CE edge when CE is already
+         * at the level. A request for the current state costs nothing.
+         *
+         * @return bool - false if a CONFIG write failed, the radio stays in the last state reached
+         */
+        bool enter_state(Radio_State target);
+
+        /**
+         * @brief one legal transition out of state_, counted in state_stats_
+         */
+        bool step_state(Radio_State next);
+
+        /**
+         * @brief drives CE to the level unless it is already there
+         */
+        void set_ce(bool high);
+
+        /**
+         * @brief books the step from state_ to next that started at started_us, then makes next current
+         */
+        void record_transition(Radio_State next, int64_t started_us, uint32_t started_spi_bytes);
+
+        /**
+         * @brief drops to standby-I for register writes that must not happen while RX or TX is active
+         *
+         * @return Radio_State - the state to hand to resume_active afterwards
+         */
+        Radio_State pause_active();
+
+        /**
+         * @brief re-enters RX or standby-II if pause_active left it, a pulsed TX is not restarted
+         */
+        bool resume_active(Radio_State previous);
+
+        /**
+         * @brief function which will use spi to read data from a given register address
          * 
+         * @param register_address which register to read
+         * @param expected_data_length number of register bytes to clock out
+         * 
+         * @return spi_frame_T - STATUS followed by the register bytes, ok is false if the transfer failed
          */
-        const u8* read_register(const u8& register_address, const u8& expected_data_length) const;
+        spi_frame_T read_register(const u8& register_address, const u8& expected_data_length) const;
 
         /**
          * @brief function which will use spi to write data to a given register address
@@ -119,11 +315,10 @@ class NRF24{
          * @param data_bytes_length length of data bytes to write
          * @param databytes data to write
          * 
-         * @retval unsigned int 8 bit pointer
-         * @return pointer to reponse from SPI
+         * @return spi_frame_T - reponse from SPI, ok is false if the transfer failed
          */
 
-        const u8* write_register(const u8& register_address, const u8& data_bytes_length, const u8* databytes) const ;
+        spi_frame_T write_register(const u8& register_address, const u8& data_bytes_length, const u8* databytes) const ;
 
 
         /**
@@ -140,6 +335,104 @@ class NRF24{
         const bool spi_command_wrapper(const u8& register_address, const u8& data_bytes_length, const u8* databytes)const;
 
 
+        /**
+         * @brief size of the register map covered by the shadow cache, 0x00 - FEATURE
+         */
+        static constexpr u8 register_file_size = 0x1E;
+        static constexpr u8 max_address_width = 5;
+
+        /**
+         * @brief shadow copy of the configuration registers, only the driver changes these so the chip never
+         * needs to be asked. shadow_length_ holds how many bytes of each register are known, 0 if not cached.
+         */
+        std::array<u8, register_file_size> shadow_registers_ = {};
+        std::array<std::array<u8, max_address_width>, 3> shadow_addresses_ = {}; // RX_ADDR_P0, RX_ADDR_P1, TX_ADDR
+        std::array<u8, register_file_size> shadow_length_ = {};
+        register_cache_stats_T cache_stats_ = {};
+
+        /**
+         * @brief cached register writes collected so a block of them goes out as one queued SPI batch
+         */
+        struct register_batch_T{
+            static constexpr u8 max_writes = spi_object::max_queued_transfers;
+
+            std::array<std::array<u8, 1 + max_address_width>, max_writes> commands;
+            std::array<u8, max_writes> lengths; // data bytes, without the command byte
+            u8 count;
+        };
+
+        /**
+         * @brief stores written register bytes in the shadow cache
+         */
+        void update_shadow(const u8& register_address, const u8& data_bytes_length, const u8* databytes);
+
+        /**
+         * @brief storage for a register in the shadow cache
+         * 
+         * @return u8* - nullptr if the register is a status register that is never cached
+         */
+        u8* shadow_slot(const u8& register_address);
+
+        /**
+         * @return u8 - bytes the register holds, max_address_width for RX_ADDR_P0/P1 and TX_ADDR, 1 otherwise
+         */
+        static u8 shadow_slot_size(const u8& register_address);
+
+        /**
+         * @brief write through the shadow cache, skips the SPI transaction when the register already holds the data
+         * 
+         * @param register_address which register to write data to
+         * @param data_bytes_length length of data bytes to write
+         * @param databytes data to write
+         * 
+         * @return bool
+         * @retval true if the register holds the data afterwards
+         * @retval false if the SPI write failed, the cached copy is dropped
+         */
+        bool write_register_cached(const u8& register_address, const u8& data_bytes_length, const u8* databytes);
+
+        /**
+         * @brief reads a register from the shadow cache, falling back to SPI (and filling the cache) on a miss
+         * 
+         * @param register_address which register to read
+         * @param data_bytes_length number of bytes wanted
+         * @param databuffer destination for the register bytes
+         * 
+         * @return bool
+         * @retval true if databuffer holds the register
+         * @retval false if the SPI read failed
+         */
+        bool read_register_cached(const u8& register_address, const u8& data_bytes_length, u8* databuffer);
+
+        /**
+         * @brief adds a write to the batch unless the shadow cache shows the register already holds the data.
+         * A full batch is flushed first, registers that are not cached are written straight away.
+         * 
+         * @return bool
+         * @retval true if the write was queued, skipped or performed
+         * @retval false if flushing or the direct write failed
+         */
+        bool queue_register_write(register_batch_T& batch, const u8& register_address, const u8& data_bytes_length, const u8* databytes);
+
+        /**
+         * @brief clocks every queued write out back to back with spi_object::send_batch and updates the shadow cache
+         * 
+         * @return bool
+         * @retval true if the batch was empty or written
+         * @retval false on SPI failure, the cached copies of the batch's registers are dropped
+         */
+        bool flush_register_batch(register_batch_T& batch);
+
+        /**
+         * @brief queues every register the image sets except CONFIG, in address order, through queue_register_write
+         * so registers the shadow cache shows already hold the value cost nothing
+         * 
+         * @return bool
+         * @retval false if a flush or direct write on the way failed
+         */
+        bool queue_image(register_batch_T& batch, const nrf_map::register_image& image);
+
+
 
         /**
          * @brief Configures and initilaises the default registers
@@ -165,12 +458,13 @@ class NRF24{
         bool switch_to_transmit();
 
         /**
-         * @brief Pulses the CE pin voltage high and then brings it back down
+         * @brief Pulses the CE pin voltage high and then brings it back down, standby-I to TxActive. The radio drops
+         * back to standby-I on its own once the packet is done, enter_state(StandbyI) then only books it.
          *  
          * @return void
          */
 
-        void pulse_ce() const;
+        void pulse_ce();
        
         /** 
          * @brief Flushes data from the component's tx buffer
@@ -187,60 +481,793 @@ class NRF24{
         void flush_rx_buffer() const;
 
 
-        bool write_spi_command(u8* transmit_buffer, u8* recieve_buffer, u8 buffer_length);
+        bool write_spi_command(const u8* transmit_buffer, u8* recieve_buffer, u8 buffer_length) const;
+
+        /**
+         * @brief clocks a batch of commands out back to back through the SPI queue
+         * 
+         * @return bool
+         * @retval true if every transfer completed
+         * @retval false on failure
+         */
+        bool write_spi_batch(const spi_transfer_T* transfers, size_t count) const;
+
+        trace_ring* trace_ = nullptr;
+
+        /**
+         * @brief records one event into the attached trace ring, compiles to nothing without NRF_TRACE_ENABLED
+         */
+        void trace(Trace_Event event, u8 reg, u8 status, u8 value) const{
+#if NRF_TRACE_ENABLED
+            if (trace_ != nullptr) {
+                trace_->record(event, reg, status, value);
+            }
+#else
+            (void)event; (void)reg; (void)status; (void)value;
+#endif
+        }
+
+        /**
+         * @brief records one SPI command as a register read, register write or command, by its first byte
+         */
+        void trace_spi(const u8* transmit_buffer, const u8* recieve_buffer, size_t length, bool ok) const;
+
+        /**
+         * @brief pipes whose payloads carry their own length (DYNPD, 0 while FEATURE.EN_DPL is clear) and the static
+         * RX_PW of the others, mirrored here so the receive path sizes reads without touching the cache
+         */
+        u8 dynamic_pipes_ = 0;
+        std::array<u8, 6> pipe_widths_ = {};
+
+        /**
+         * @brief mirrors FEATURE.EN_DYN_ACK, which W_TX_PAYLOAD_NOACK needs
+         */
+        bool dynamic_ack_ = false;
+
+        /**
+         * @brief sets FEATURE.EN_DYN_ACK the first time a no-ack packet is sent, in standby-I and back to the
+         * state the radio was in, free afterwards. Called before a transmit touches the state machine.
+         * 
+         * @return bool
+         * @retval true if W_TX_PAYLOAD_NOACK can be used
+         * @retval false on SPI failure
+         */
+        bool enable_dynamic_ack();
+
+        /**
+         * @brief transmits go out on pipe 0, so its DYNPD bit decides the TX payload format
+         */
+        bool tx_dynamic_payloads() const { return dynamic_pipes_ & 0x01; }
+
+        /**
+         * @brief size of the payload at the head of the RX FIFO for the pipe named in status
+         * 
+         * @param status STATUS clocked out before the payload is read
+         * @param reported_width width from R_RX_PL_WID, used for dynamic pipes
+         * 
+         * @return u8 - payload length, 0 if the FIFO is empty
+         */
+        u8 payload_width(u8 status, u8 reported_width) const;
+
+        tx_stream_stats_T stream_stats_ = {};
+
+        csma_config_T csma_ = {};
+        csma_stats_T csma_stats_ = {};
+
+        /**
+         * @brief Listens on the channel with a fresh RX entry for csma_.listen_us and reads RPD, backing off a random
+         * number of slots from a window that doubles after every busy listen. Leaves the radio in receive mode with CE low.
+         * 
+         * @return bool
+         * @retval true if the channel was found clear, or transmit_when_exhausted is set
+         * @retval false if every listen was busy or on SPI failure
+         */
+        bool listen_before_talk();
+        channel_scan_T channel_scan_ = {};
+
+        /**
+         * @brief busy count of a channel plus its neighbours, a 2 Mbps signal spreads over 2 MHz
+         */
+        uint32_t channel_score(u8 channel) const;
+
+        /**
+         * @brief mirrors RF_SETUP and SETUP_RETR as last written, plus the ACK payload length ARD was checked against
+         */
+        rf_settings_T rf_settings_ = {};
+        u8 ack_payload_length_ = 0;
+
+        const radio_profile_T* profile_ = nullptr;
+        profile_stats_T profile_stats_ = {};
+
+        /**
+         * @brief reloads rf_settings_, dynamic_pipes_, dynamic_ack_ and pipe_widths_ from the registers an image
+         * set, through the shadow cache
+         */
+        bool refresh_mirrors(const nrf_map::register_image& image, u8 ack_payload_length);
+
+        /**
+         * @brief longest a packet can take to reach TX_DS or MAX_RT with the current ARD and ARC, every attempt
+         * costs ARD plus the worst case airtime and settling
+         * 
+         * @param floor_us lower bound, returned when the retransmit budget is shorter
+         */
+        int64_t tx_completion_timeout_us(int64_t floor_us) const;
+
+        /**
+         * @brief on-air time of one packet with the current address width, CRC and data rate: preamble, address,
+         * the 9 bit packet control field, payload and CRC
+         * 
+         * @param payload_bytes bytes clocked out of the TX FIFO, 32 for static payloads
+         */
+        uint32_t packet_airtime_us(u8 payload_bytes) const;
+
+        /**
+         * @brief first and longest pause between STATUS polls while a packet is in flight, the pause doubles per poll
+         */
+        static constexpr uint32_t tx_poll_min_us = 20;
+        static constexpr uint32_t tx_poll_max_us = 160;
+
+        /**
+         * @brief Waits for TX_DS or MAX_RT of a packet CE has already started. Sleeps through the packet's airtime
+         * on the driver's clock first, since neither flag can rise earlier, then polls STATUS with a growing pause
+         * in between so the bus and CPU are left alone while ACKs and retransmits play out.
+         * 
+         * @param payload_bytes bytes the packet carries on air
+         * @param timeout_us give up once this long has passed since the call
+         * @param status STATUS of the last poll, without TX_DS and MAX_RT on timeout
+         * 
+         * @return bool
+         * @retval true if STATUS was polled until an outcome or the timeout
+         * @retval false on SPI failure
+         */
+        bool poll_tx_outcome(u8 payload_bytes, int64_t timeout_us, u8& status);
+
+        /**
+         * @brief writes a set of bit patterns into TX_ADDR and reads each one back at the current SPI clock
+         * 
+         * @return bool
+         * @retval true if every pattern read back unchanged
+         * @retval false on a mismatch or SPI failure, TX_ADDR holds a test pattern afterwards
+         */
+        bool spi_link_passes() const;
+
+
+        /**
+         * @brief CONFIG interrupt mask bits ORed into every CONFIG write, set while the IRQ receive mode runs
+         */
+        u8 irq_mask_ = 0;
+
+        std::atomic<TaskHandle_t> irq_task_{nullptr};
+        std::atomic<bool> irq_running_{false};
+        void (*rx_callback_)(const u8* data, u8 length, void* context) = nullptr;
+        void* rx_callback_context_ = nullptr;
+
+        /**
+         * @brief type erased packet_ring<N>::push of the attached ring
+         */
+        using rx_ring_push_T = bool (*)(void* ring, const u8* data, u8 length, u8 pipe, int64_t timestamp_us);
+        rx_ring_push_T rx_ring_push_ = nullptr;
+        void* rx_ring_ = nullptr;
+
+        /**
+         * @brief per pipe route, a pipe with neither a handler nor a ring falls back to the callback/ring above
+         */
+        struct pipe_route_T{
+            void (*handler)(const u8* data, u8 length, void* context);
+            void* context;
+            rx_ring_push_T ring_push;
+            void* ring;
+        };
+        std::array<pipe_route_T, 6> pipe_routes_ = {};
+
+        bool has_pipe_routes() const;
+
+        /**
+         * @brief hands one drained packet to its pipe's route, or the shared callback and ring
+         */
+        void deliver_packet(u8 pipe, const u8* data, u8 length);
+
+        /**
+         * @brief falling edge handler for Pins_T::IRQ, only wakes the radio task
+         */
+        static void irq_isr_handler(void* arg);
+
+        /**
+         * @brief radio task body, sleeps until notified by the ISR then calls service_irq
+         */
+        static void irq_task(void* arg);
+
     public: 
 
         static constexpr u8 fifo_max_size = 32;
 
-        void rx_process(u8* rx_buffer);
+        /**
+         * @brief reads one packet from the rx fifo into rx_buffer and clears the fifo and flags
+         * 
+         * @param rx_buffer destination, must hold fifo_max_size bytes
+         * 
+         * @return u8 - bytes received, fifo_max_size with static payloads, the packet's own length with dynamic payloads, 0 if none
+         */
+        u8 rx_process(u8* rx_buffer);
         void dump_all_registers();
 
     
         bool switch_to_recieve();
-        Antenna_Mode mode_;
+
+        /**
+         * @brief direction CONFIG is set for, also while in standby
+         */
+        Antenna_Mode mode() const { return mode_; }
+
+        /**
+         * @brief state the driver last moved the radio to. After a pulsed TX this reads TxActive until the driver saw
+         * TX_DS or MAX_RT.
+         */
+        Radio_State state() const { return state_; }
+
+        /**
+         * @brief clears PWR_UP, the radio draws about 900 nA and keeps its registers. Any RX/TX call powers it up
+         * again and waits out Tpd2stby (1.5 ms).
+         *
+         * @return bool - false if the CONFIG write failed
+         */
+        bool power_down();
+
+        /**
+         * @brief transitions taken and the time and SPI bytes spent in and between states, see radio_state_stats_T
+         */
+        const radio_state_stats_T& state_stats() const { return state_stats_; }
+        void reset_state_stats();
+
+        /**
+         * @brief prints state_stats as a transition table plus the time spent in each state
+         */
+        void dump_state_stats() const;
 
         u8 get_status();
 
         void clear_rx();
+
+        /**
+         * @brief reloads the shadow cache from the chip, needed after the radio was reset or reconfigured behind the driver's back
+         * 
+         * @return bool
+         * @retval true if every cached register was read
+         * @retval false if an SPI read failed, that register stays uncached
+         */
+        bool resync();
+
+        /**
+         * @brief reads every cached register back from the chip and compares it to the shadow copy
+         * 
+         * @return bool
+         * @retval true if the chip matches the cache
+         * @retval false on a mismatch or SPI failure, mismatches are printed
+         */
+        bool verify();
+
+        /**
+         * @brief SPI clock ceiling of the nRF24L01+ and the rates calibrate_spi_clock steps down through by default
+         */
+        static constexpr int max_spi_clock_hz = 10 * 1000 * 1000;
+        static constexpr std::array<int, 6> default_spi_clock_steps = {
+            10 * 1000 * 1000, 8 * 1000 * 1000, 5 * 1000 * 1000, 4 * 1000 * 1000, 2 * 1000 * 1000, 1 * 1000 * 1000
+        };
+
+        /**
+         * @brief Steps the SPI clock down through candidate rates and keeps the fastest one at which test patterns
+         * written to TX_ADDR read back intact, so each board runs at the rate its wiring reliably carries.
+         * TX_ADDR is restored afterwards and the shadow cache is checked against the chip.
+         * Call with CE low, before traffic starts. spi_config_T::calibrate_clock has the constructor run it with
+         * the default steps right after setup.
+         * 
+         * @param candidate_hz clock rates to try, fastest first
+         * @param count number of rates in candidate_hz
+         * 
+         * @return int - the clock rate kept, 0 if none passed and the previous rate was restored
+         */
+        int calibrate_spi_clock(const int* candidate_hz = default_spi_clock_steps.data(), size_t count = default_spi_clock_steps.size());
+
+        /**
+         * @brief Turns dynamic payload length on or off (FEATURE.EN_DPL and DYNPD). With it on, transmit_data
+         * clocks out and puts on air only the bytes it is given and receives read the length reported by
+         * R_RX_PL_WID instead of a fixed 32 bytes. The radio only runs DPL on pipes with auto-ack, so DYNPD is
+         * set for the pipes EN_AA has on, turn auto-ack on with configure_pipe first. Both ends of the link must
+         * use the same setting. Leaves RX or standby-II for the writes and returns to it.
+         * 
+         * @param enabled true for dynamic payloads, false for fixed fifo_max_size payloads
+         * 
+         * @return bool
+         * @retval true if the registers were written
+         * @retval false if no pipe has auto-ack or on SPI failure
+         */
+        bool set_dynamic_payloads(bool enabled);
+        bool dynamic_payloads() const { return tx_dynamic_payloads(); }
+
+        /**
+         * @brief Programs one of the six RX pipes: its address, static width or dynamic payloads, auto-ack and
+         * whether it is enabled. Pipes 2-5 only own their address LSByte and share the rest with pipe 1, so set
+         * pipe 1 first. Transmits use pipe 0 as the auto-ack return address, keep it equal to TX_ADDR when
+         * auto-ack is used. Dynamic payloads need auto-ack on the pipe, and the last dynamic pipe cannot be made
+         * static while ACK payloads are on, call set_ack_payloads(false) first. Only registers that change are
+         * written, as one queued batch.
+         * 
+         * @param pipe 0 - 5
+         * @param config settings for the pipe
+         * 
+         * @return bool
+         * @retval true if the pipe is configured
+         * @retval false on an invalid pipe, width or feature combination, or SPI failure
+         */
+        bool configure_pipe(u8 pipe, const pipe_config_T& config);
+
+        /**
+         * @brief Shortest ARD the datasheet allows for a data rate: the transmitter must still be listening when
+         * an ACK carrying ack_payload_length bytes has finished arriving. 250 kbps needs 500 µs even without
+         * ACK payloads.
+         * 
+         * @param rate air data rate
+         * @param ack_payload_length longest ACK payload the receiver sends, 0 without ACK payloads
+         * 
+         * @return uint16_t - minimum retransmit delay in µs
+         */
+        static constexpr uint16_t min_retransmit_delay_us(Data_Rate rate, u8 ack_payload_length){
+            if (rate == Data_Rate::Rate_250kbps) {
+                if (ack_payload_length == 0) return 500;
+                if (ack_payload_length <= 8) return 750;
+                if (ack_payload_length <= 16) return 1000;
+                if (ack_payload_length <= 24) return 1250;
+                return 1500;
+            }
+            const u8 fits_in_250us = rate == Data_Rate::Rate_1Mbps ? 5 : 15;
+            return ack_payload_length <= fits_in_250us ? 250 : 500;
+        }
+
+        /**
+         * @brief Writes data rate, PA level, ARD and ARC in one batch, only the registers that change go out.
+         * Rejected without touching the radio when ARD is off the 250 µs grid, ARC is above 15 or ARD is below
+         * min_retransmit_delay_us for the rate. When something changes the radio leaves RX or standby-II for the
+         * writes and returns to it afterwards.
+         * 
+         * @param settings settings to apply
+         * @param ack_payload_length longest ACK payload the peer sends, ARD is checked against it and later single
+         * setting changes keep checking against it
+         * 
+         * @return bool
+         * @retval true if the radio runs with the settings
+         * @retval false if rejected or on SPI failure
+         */
+        bool apply_rf_settings(const rf_settings_T& settings, u8 ack_payload_length = 0);
+        bool set_data_rate(Data_Rate rate);
+        bool set_pa_level(PA_Level level);
+        bool set_retransmit(uint16_t delay_us, u8 count, u8 ack_payload_length = 0);
+        const rf_settings_T& rf_settings() const { return rf_settings_; }
+        u8 ack_payload_length() const { return ack_payload_length_; }
+
+        /**
+         * @brief Switches the radio to a profile. Only the registers the shadow cache does not show holding the
+         * profile's value are written, back to back while the bus is held, and the radio returns to RX or
+         * standby-II if it was there. The driver's mirrors (rf_settings, payload widths, DPL, dynamic ACK) follow
+         * the registers. Rejected without touching the radio when the profile has a problem(), which only a profile
+         * built at run time can have, or when ARD is below min_retransmit_delay_us for its rate and ACK payload length.
+         * 
+         * @param profile profile to run, kept by pointer for profile(), so it must outlive its use (constexpr ones do)
+         * 
+         * @return bool
+         * @retval true if the radio runs with the profile
+         * @retval false if rejected or on SPI failure, registers written before the failure keep their new values
+         */
+        bool apply_profile(const radio_profile_T& profile);
+
+        /**
+         * @brief the registers setup_config writes, to switch back to the power-on configuration
+         */
+        static const radio_profile_T& setup_profile();
+
+        /**
+         * @return const radio_profile_T* - profile applied last, nullptr before the first. set_channel,
+         * configure_pipe and the other single setters may have changed registers since.
+         */
+        const radio_profile_T* profile() const { return profile_; }
+        const profile_stats_T& profile_stats() const { return profile_stats_; }
+        void reset_profile_stats() { profile_stats_ = {}; }
+
+        /**
+         * @brief reads OBSERVE_TX and RPD in one queued batch, after a transmit they describe that packet and its ACK
+         * 
+         * @param quality filled on success
+         * 
+         * @return bool
+         * @retval true if both registers were read
+         * @retval false on SPI failure
+         */
+        bool read_link_quality(link_quality_T& quality) const;
+
+        /**
+         * @brief applies settings on the far end of the link during sweep_link, e.g. on a second radio on the
+         * same board. Only the data rate has to match, PA level, ARD and ARC are transmitter side settings.
+         * 
+         * @return bool - false skips the settings
+         */
+        using sweep_peer_hook_T = bool (*)(const rf_settings_T& settings, void* context);
+
+        /**
+         * @brief most packets sweep_link sends per setting, their latencies are kept on the stack
+         */
+        static constexpr uint16_t sweep_max_packets = 128;
+
+        /**
+         * @brief Benchmark mode. For each entry of settings the settings are applied here and through peer_hook,
+         * then packets_per_setting packets go out one at a time with transmit_request and each one's latency and
+         * ARC_CNT are recorded. Results carry goodput, latency percentiles and retransmit counts so link settings
+         * can be picked from data, each setting is also printed as one line. Needs auto-ack on pipe 0 on both
+         * ends (set_ack_payloads or configure_pipe). The original settings are restored on both ends afterwards
+         * and the radio returns to receive mode.
+         * 
+         * @param settings combinations to measure
+         * @param count number of combinations, results must hold as many
+         * @param results one entry per combination, in order
+         * @param packets_per_setting 1 - sweep_max_packets
+         * @param payload_length 1 - fifo_max_size
+         * @param peer_hook optional, applies each combination to the receiver first
+         * @param context passed through to peer_hook
+         * 
+         * @return size_t - combinations measured, the others have applied == false
+         */
+        size_t sweep_link(const rf_settings_T* settings, size_t count, link_sweep_result_T* results, uint16_t packets_per_setting,
+                          u8 payload_length, sweep_peer_hook_T peer_hook = nullptr, void* context = nullptr);
+
+        /**
+         * @brief Moves the radio to RF_CH channel (2400 + channel MHz). Both ends of a link must use the same channel.
+         * Channels above 83 are outside the 2.4 GHz ISM band in most regions.
+         * 
+         * @param channel 0 - 125
+         * 
+         * @return bool
+         * @retval true if the radio is on the channel
+         * @retval false on an invalid channel or SPI failure
+         */
+        bool set_channel(u8 channel);
+        u8 channel() const;
+
+        /**
+         * @brief RX settling plus the 40 µs the carrier must be present for RPD to latch, the shortest useful dwell
+         */
+        static constexpr uint16_t rpd_min_dwell_us = 130 + 40;
+        static constexpr uint16_t default_scan_sweeps = 10;
+
+        /**
+         * @brief Spectrum scan. Steps RF_CH through all 126 channels, listening dwell_us on each and sampling RPD,
+         * sweeps times over, and counts per channel how many sweeps saw a carrier. Each step is a single queued
+         * batch (read RPD of the channel just left, write the next RF_CH) between CE pulses, so a sweep costs about
+         * 126 x (dwell_us + 20 µs): the defaults finish in roughly a quarter of a second. RF_CH is restored and the
+         * radio left receiving afterwards, packets that matched an address during the scan are flushed.
+         * Must not be called while the IRQ receive mode is running.
+         * 
+         * @param sweeps passes over the band, more sweeps catch bursty traffic such as Wi-Fi beacons
+         * @param dwell_us listening time per channel, raised to rpd_min_dwell_us
+         * 
+         * @return bool
+         * @retval true if the scan completed, the histogram is in last_channel_scan
+         * @retval false on invalid arguments, SPI failure or while the IRQ receive mode runs
+         */
+        bool scan_channels(uint16_t sweeps = default_scan_sweeps, uint16_t dwell_us = rpd_min_dwell_us);
+        const channel_scan_T& last_channel_scan() const { return channel_scan_; }
+
+        /**
+         * @brief prints the last scan as a histogram, one line per 16 channels
+         */
+        void dump_channel_scan() const;
+
+        /**
+         * @brief quietest channel of the last scan, counting half of each neighbour's activity
+         * 
+         * @param first lowest channel allowed, e.g. to stay inside the local ISM band
+         * @param last highest channel allowed
+         * 
+         * @return u8 - the channel, the current one when nothing was scanned yet or the range is empty
+         */
+        u8 quietest_channel(u8 first = 0, u8 last = 125) const;
+
+        /**
+         * @brief quietest set of channels of the last scan, at least min_spacing apart, e.g. for a hopping sequence
+         * 
+         * @param channels destination, quietest first
+         * @param count channels wanted
+         * @param min_spacing smallest distance between two picked channels, 2 keeps 2 Mbps signals from overlapping
+         * @param first lowest channel allowed
+         * @param last highest channel allowed
+         * 
+         * @return size_t - channels written, fewer than count if the range cannot hold them
+         */
+        size_t quietest_channels(u8* channels, size_t count, u8 min_spacing = 2, u8 first = 0, u8 last = 125) const;
+
+        const register_cache_stats_T& cache_stats() const { return cache_stats_; }
+        void reset_cache_stats() { cache_stats_ = {}; }
         
 
      
 
         
         
-        NRF24(const spi_object& spi, const Pins_T& pins, u8 buffer_size);
+        /**
+         * @brief configures the radio and leaves it listening, taking about Tpd2stby (1.5 ms) plus the register writes
+         *
+         * @param clock time source for every datasheet wait, swap it to record or simulate the delays
+         */
+        NRF24(spi_object& spi, const Pins_T& pins, u8 buffer_size, const radio_clock_T& clock = radio_clock_T::system());
 
-        bool transmit_data(u8* databuffer, u8 data_bytes_length);
+        /**
+         * @brief when the radio powered up and CE last rose, and the waits spent on the datasheet intervals
+         */
+        const radio_timing& timing() const { return timing_; }
+        void reset_timing_stats() { timing_.reset_stats(); }
+        ~NRF24();
 
+        /**
+         * @brief sends one packet and returns to receive mode
+         * 
+         * @param databuffer payload bytes
+         * @param data_bytes_length payload length, at most fifo_max_size
+         * @param no_ack send with W_TX_PAYLOAD_NOACK, no ACK wait and no retransmits for this packet even with
+         * auto-ack on, for broadcast telemetry. Turns FEATURE.EN_DYN_ACK on the first time it is used.
+         * 
+         * @return bool
+         * @retval true on TX_DS: acknowledged with auto-ack, sent without it
+         * @retval false on invalid arguments, SPI failure, MAX_RT, no TX_DS or MAX_RT within the timeout or, in
+         * listen-before-talk mode, a channel that stayed busy. The packet is flushed from the TX FIFO.
+         */
+        bool transmit_data(u8* databuffer, u8 data_bytes_length, bool no_ack = false);
 
+        /**
+         * @brief Sets the listen-before-talk mode of transmit_data. While enabled each packet is preceded by a carrier
+         * check in RX on the current channel and, while RPD shows the channel busy, randomised exponential backoff,
+         * so nodes sharing a channel stop transmitting into each other. Costs at least listen_us plus a mode switch per
+         * packet. transmit_stream and transmit_request never listen.
+         */
+        void set_csma(const csma_config_T& config) { csma_ = config; }
+        const csma_config_T& csma() const { return csma_; }
+        const csma_stats_T& csma_stats() const { return csma_stats_; }
+        void reset_csma_stats() { csma_stats_ = {}; }
+
+        /**
+         * @brief called by transmit_stream once per packet, in order
+         * 
+         * @param index position of the packet in the array passed to transmit_stream
+         * @param delivered true on TX_DS, false on MAX_RT or timeout
+         */
+        using tx_complete_callback_T = void (*)(size_t index, bool delivered, void* context);
 
+        /**
+         * @brief gives up on a stream when no packet completes for this long
+         */
+        static constexpr int64_t tx_stream_timeout_us = 50 * 1000;
 
+        /**
+         * @brief Streams packets back to back. CE stays high in TX mode and two packets are kept in the TX FIFO, one
+         * on air and one waiting, so the radio never idles between packets. Completions are counted from the TX FIFO
+         * occupancy read with FIFO_STATUS, a TX_DS seen since the last poll tells one queued packet from two, so
+         * several completions between two polls are not merged. MAX_RT belongs to the packet at the head of the
+         * FIFO, it is dropped and the one queued behind it is reloaded. Returns to receive mode afterwards. Must not
+         * be called while the IRQ receive mode is running.
+         * 
+         * @param packets packets to send, each at most fifo_max_size bytes, padded to it without dynamic payloads
+         * @param count number of packets
+         * @param on_complete optional per packet completion report
+         * @param context passed through to on_complete
+         * 
+         * @return size_t - packets delivered, details in last_stream_stats
+         */
+        size_t transmit_stream(const tx_packet_T* packets, size_t count, tx_complete_callback_T on_complete = nullptr, void* context = nullptr);
 
-};
+        const tx_stream_stats_T& last_stream_stats() const { return stream_stats_; }
 
+        /**
+         * @brief gives up on a request when neither TX_DS nor MAX_RT shows up for this long
+         */
+        static constexpr int64_t request_timeout_us = 20 * 1000;
 
+        /**
+         * @brief Turns auto-acknowledge with ACK payloads on for every enabled pipe and pipe 0 (FEATURE.EN_ACK_PAY,
+         * EN_DPL, DYNPD and EN_AA). A receiver then preloads replies with queue_ack_payload and a transmitter gets
+         * them back inside the ACK of transmit_request, so request/response needs no mode switch on either side.
+         * Disabling only clears EN_ACK_PAY, auto-ack and dynamic payloads stay on. Written in standby like
+         * apply_rf_settings.
+         * 
+         * @return bool
+         * @retval true if the registers were written
+         * @retval false on SPI failure
+         */
+        bool set_ack_payloads(bool enabled);
 
+        /**
+         * @brief Receiver side, loads a reply (W_ACK_PAYLOAD) that goes out with the ACK of the next packet received
+         * on pipe. Replies share the 3-deep TX FIFO.
+         * 
+         * @param pipe 0 - 5
+         * @param data reply bytes
+         * @param length 1 - fifo_max_size
+         * 
+         * @return bool
+         * @retval true if the reply was loaded
+         * @retval false on invalid arguments, a full TX FIFO or SPI failure
+         */
+        bool queue_ack_payload(u8 pipe, const u8* data, u8 length);
 
-namespace NRF_regs{
-    inline constexpr u8 config_register_address = 0x00;
-    inline constexpr u8 auto_acknowledge_config_address = 0x01;
-    inline constexpr u8 enable_rx_pipes_address = 0x02;
-    inline constexpr u8 address_width_address = 0x03;
-    inline constexpr u8 retransmit_details_address = 0x04;
+        /**
+         * @brief Transmitter side, one request/response exchange: loads the packet, pulses CE and waits for the ACK.
+         * A reply the receiver preloaded comes back in that ACK and is copied into reply. The radio stays in
+         * transmit mode (standby-I) afterwards so back to back requests cost no mode switch, call switch_to_recieve
+         * to listen again. Needs set_ack_payloads on both ends and TX_ADDR equal to RX_ADDR_P0.
+         * 
+         * @param data request bytes, 1 - fifo_max_size
+         * @param length request length
+         * @param reply destination for the reply, must hold fifo_max_size bytes
+         * @param reply_length set to the reply length, 0 if the ACK carried none
+         * 
+         * @return bool
+         * @retval true on TX_DS, the request was acknowledged
+         * @retval false on MAX_RT, timeout or SPI failure, the request is flushed
+         */
+        bool transmit_request(const u8* data, u8 length, u8* reply, u8& reply_length);
 
-    inline constexpr u8 frequency_register_address = 0x05;
-    inline constexpr u8 rf_setup_address = 0x06;
-    inline constexpr u8 status_register_address = 0x07;
+        /**
+         * @brief reads one reply that arrived in an ACK, or any packet waiting in the RX FIFO, without touching CE
+         * 
+         * @param buffer destination, must hold fifo_max_size bytes
+         * 
+         * @return u8 - bytes read, 0 if the RX FIFO is empty
+         */
+        u8 read_ack_payload(u8* buffer);
 
-    inline constexpr u8 rx_pipe_zero_address = 0x0A;
-    inline constexpr u8 tx_pipe_zero_address = 0x10;   
-    inline constexpr u8 rx_width_Address = 0x11;
 
-    inline constexpr u8 dynamic_payload_address = 0x1C;
-    inline constexpr u8 features_address = 0x1D;
+        /**
+         * @brief callback for the interrupt driven receive mode, runs on the radio task once per packet
+         */
+        using rx_callback_T = void (*)(const u8* data, u8 length, void* context);
 
-    inline constexpr u8 fifo_status_address = 0x17;
-    
+        /**
+         * @brief Makes service_irq push every packet it drains into ring, stamped with its pipe and read time.
+         * Attach before start_irq_rx, the radio task is then the ring's only producer. The ring must outlive
+         * the attachment.
+         */
+        template <size_t Capacity>
+        void attach_rx_ring(packet_ring<Capacity>& ring){
+            rx_ring_ = &ring;
+            rx_ring_push_ = [](void* target, const u8* data, u8 length, u8 pipe, int64_t timestamp_us){
+                return static_cast<packet_ring<Capacity>*>(target)->push(data, length, pipe, timestamp_us);
+            };
+        }
+        void detach_rx_ring();
+
+        /**
+         * @brief Records SPI commands, CE edges, mode switches and TX/RX outcomes into ring. Only builds with
+         * NRF_TRACE_ENABLED record anything, see nrf_trace.hpp. The ring must outlive the attachment.
+         */
+        void attach_trace(trace_ring& ring) { trace_ = &ring; }
+        void detach_trace() { trace_ = nullptr; }
+
+        /**
+         * @brief Routes packets received on one pipe to their own handler, picked by RX_P_NO while draining.
+         * Pass nullptr to drop the route. Set before start_irq_rx.
+         */
+        void set_pipe_handler(u8 pipe, rx_callback_T handler, void* context);
+
+        /**
+         * @brief Routes packets received on one pipe into their own ring, the radio task is its only producer.
+         * Set before start_irq_rx, the ring must outlive the route.
+         */
+        template <size_t Capacity>
+        void attach_pipe_ring(u8 pipe, packet_ring<Capacity>& ring){
+            if (pipe >= pipe_routes_.size()) {
+                return;
+            }
+            pipe_routes_[pipe].ring = &ring;
+            pipe_routes_[pipe].ring_push = [](void* target, const u8* data, u8 length, u8 pipe_number, int64_t timestamp_us){
+                return static_cast<packet_ring<Capacity>*>(target)->push(data, length, pipe_number, timestamp_us);
+            };
+        }
+        void detach_pipe_ring(u8 pipe);
+
+        /**
+         * @brief Starts the interrupt driven receive mode. A falling edge on Pins_T::IRQ wakes a radio
+         * task which drains the RX FIFO into the callback and the attached ring, so nothing polls while the air is quiet.
+         * Only RX_DR is routed to the IRQ pin, transmit_data keeps polling TX_DS/MAX_RT itself.
+         * rx_process must not be called while this mode is running.
+         * 
+         * @param callback called for every received packet without a pipe route, may be nullptr when a ring or pipe route is set
+         * @param context passed through to the callback
+         * @param task_priority FreeRTOS priority of the radio task
+         * 
+         * @return bool
+         * @retval true if the ISR and task are running
+         * @retval false if IRQ is not wired, there is neither a callback nor a ring, the mode is already running or setup failed
+         */
+        bool start_irq_rx(rx_callback_T callback, void* context, UBaseType_t task_priority = 10);
+
+        /**
+         * @brief Detaches the ISR, stops the radio task and unmasks the TX interrupts again
+         * 
+         * @return void
+         */
+        void stop_irq_rx();
+
+        /**
+         * @brief Clears RX_DR and drains every packet in the RX FIFO into the attached ring and the callback.
+         * Called by the radio task after an IRQ, exposed so it can be driven by hand (polling into a ring).
+         * 
+         * @return u8 - number of packets read out of the RX FIFO
+         */
+        u8 service_irq();
+
+
+
+
+
+};
+
+
+
+
+// short names for the nrf_map registers and fields the driver uses most, nrf_registers.hpp is the source of truth
+namespace NRF_regs{
+    inline constexpr u8 config_register_address = nrf_map::config::address;
+    inline constexpr u8 auto_acknowledge_config_address = nrf_map::en_aa::address;
+    inline constexpr u8 enable_rx_pipes_address = nrf_map::en_rxaddr::address;
+    inline constexpr u8 address_width_address = nrf_map::setup_aw::address;
+    inline constexpr u8 retransmit_details_address = nrf_map::setup_retr::address;
+
+    inline constexpr u8 frequency_register_address = nrf_map::rf_ch::address;
+    inline constexpr u8 rf_setup_address = nrf_map::rf_setup::address;
+    inline constexpr u8 status_register_address = nrf_map::status::address;
+
+    inline constexpr u8 observe_tx_address = nrf_map::observe_tx::address;
+    inline constexpr u8 received_power_detector_address = nrf_map::rpd::address;
+
+    inline constexpr u8 rx_pipe_zero_address = nrf_map::rx_addr_p0::address;
+    inline constexpr u8 rx_pipe_one_address = nrf_map::rx_addr_p1::address;   // RX_ADDR_P2 - P5 follow at 0x0C - 0x0F
+    inline constexpr u8 tx_pipe_zero_address = nrf_map::tx_addr::address;
+    inline constexpr u8 rx_width_Address = nrf_map::rx_pw<0>::address;      // RX_PW_P0, RX_PW_P1 - P5 follow at 0x12 - 0x16
+
+    inline constexpr u8 dynamic_payload_address = nrf_map::dynpd::address;
+    inline constexpr u8 features_address = nrf_map::feature::address;
+
+    inline constexpr u8 fifo_status_address = nrf_map::fifo_status::address;
+
+    // FEATURE / DYNPD bits
+    inline constexpr u8 feature_en_dpl = nrf_map::feature::en_dpl::mask;
+    inline constexpr u8 feature_en_ack_pay = nrf_map::feature::en_ack_pay::mask;
+    inline constexpr u8 feature_en_dyn_ack = nrf_map::feature::en_dyn_ack::mask;
+    inline constexpr u8 dynamic_payload_all_pipes = nrf_map::dynpd::all_pipes;
+
+    inline constexpr u8 write_register_prefix = nrf_map::write_prefix;
+
+    // CONFIG interrupt masks, a set bit keeps that flag off the IRQ pin
+    inline constexpr u8 config_mask_rx_dr = nrf_map::config::mask_rx_dr::mask;
+    inline constexpr u8 config_mask_tx_ds = nrf_map::config::mask_tx_ds::mask;
+    inline constexpr u8 config_mask_max_rt = nrf_map::config::mask_max_rt::mask;
+
+    // STATUS bits
+    inline constexpr u8 status_rx_dr = nrf_map::status::rx_dr::mask;
+    inline constexpr u8 status_tx_ds = nrf_map::status::tx_ds::mask;
+    inline constexpr u8 status_max_rt = nrf_map::status::max_rt::mask;
+    inline constexpr u8 status_rx_p_no_mask = nrf_map::status::rx_p_no::mask;
+    inline constexpr u8 status_rx_fifo_empty = nrf_map::status::rx_p_no::encode(nrf_map::status::rx_fifo_empty);
+    inline constexpr u8 status_tx_full = nrf_map::status::tx_full::mask;
+
+    // SETUP_RETR / OBSERVE_TX fields
+    inline constexpr uint16_t retransmit_delay_step_us = nrf_map::setup_retr::ard_step_us;
+    inline constexpr u8 max_retransmit_count = nrf_map::setup_retr::arc::max;
+    inline constexpr u8 rpd_bit = nrf_map::rpd::detected::mask;
+
+    // FIFO_STATUS bits
+    inline constexpr u8 fifo_status_tx_full = nrf_map::fifo_status::tx_full::mask;
+    inline constexpr u8 fifo_status_tx_empty = nrf_map::fifo_status::tx_empty::mask;
+
+    inline constexpr u8 channel_count = 126;
+    inline constexpr u8 rx_pipe_count = 6;
+    inline constexpr u8 rx_fifo_depth = 3;
+    inline constexpr u8 tx_fifo_depth = 3;
 }
 
 namespace commands{
@@ -248,7 +1275,10 @@ namespace commands{
     inline constexpr u8 flush_tx_command =0xE1;
     inline constexpr u8 flush_rx_command =0xE2;
     inline constexpr u8 write_tx_command =0xA0;
+    inline constexpr u8 write_tx_no_ack_command = 0xB0;
     inline constexpr u8 get_rx_size_command = 0x60;
+    inline constexpr u8 write_ack_payload_command = 0xA8;  // ORed with the pipe number
+    inline constexpr u8 nop_command = 0xFF;
 }
 
-enum class voltage_flow :int{low = 0, high = 1};
\ No newline at end of file
+enum voltage_flow :int{low = 0, high = 1};
\ No newline at end of file
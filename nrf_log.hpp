@@ -0,0 +1,32 @@
+
+#pragma once
+
+#include <cstdio> // for printf
+
+
+/**
+ * Compile-time log levels for the driver. Every message sits behind NRF_LOGE ... NRF_LOGV, a message above
+ * NRF_LOG_LEVEL is discarded by if constexpr, so neither the printf call nor its format string reaches the binary.
+ * Arguments are still type checked at every level.
+ *
+ * Pick the level with a compiler flag, e.g. -DNRF_LOG_LEVEL=NRF_LOG_LEVEL_VERBOSE for the old per-register chatter,
+ * or -DNRF_LOG_LEVEL=NRF_LOG_LEVEL_NONE for a silent build. For diagnostics without the printf cost see nrf_trace.hpp.
+ */
+#define NRF_LOG_LEVEL_NONE      0
+#define NRF_LOG_LEVEL_ERROR     1   // a call failed: SPI errors, invalid arguments, rejected settings
+#define NRF_LOG_LEVEL_WARN      2   // a call gave up on the air: timeouts, busy channel, full FIFO
+#define NRF_LOG_LEVEL_INFO      3   // once per setup, calibration or benchmark step
+#define NRF_LOG_LEVEL_DEBUG     4   // once per driver call, e.g. mode switches and transmit outcomes
+#define NRF_LOG_LEVEL_VERBOSE   5   // every SPI command, payload hex dumps
+
+#ifndef NRF_LOG_LEVEL
+#define NRF_LOG_LEVEL NRF_LOG_LEVEL_INFO
+#endif
+
+#define NRF_LOG_AT(level, ...) do { if constexpr (NRF_LOG_LEVEL >= (level)) { printf(__VA_ARGS__); } } while (0)
+
+#define NRF_LOGE(...) NRF_LOG_AT(NRF_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define NRF_LOGW(...) NRF_LOG_AT(NRF_LOG_LEVEL_WARN, __VA_ARGS__)
+#define NRF_LOGI(...) NRF_LOG_AT(NRF_LOG_LEVEL_INFO, __VA_ARGS__)
+#define NRF_LOGD(...) NRF_LOG_AT(NRF_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define NRF_LOGV(...) NRF_LOG_AT(NRF_LOG_LEVEL_VERBOSE, __VA_ARGS__)
@@ -0,0 +1,401 @@
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+using u8 = uint8_t;
+
+
+/**
+ * Typed map of the nRF24L01+ register file (datasheet section 9). Every register is a type carrying its address,
+ * reset value and reserved bits, every field a type carrying its register, position, width, value type and largest
+ * legal value. Encoding a field is a shift and a precomputed mask, so a constexpr register value or register_image
+ * costs nothing at run time, and these are compile errors instead of silent bit garbage:
+ *
+ *   - a field put into a register it does not belong to, or a field over a reserved bit (e.g. en_aa::pipe<6>)
+ *   - writing a read-only field such as status::rx_p_no or fifo_status::tx_full
+ *   - the same field twice in one compose
+ *   - a constant out of range, e.g. rf_ch::channel(126) or rx_pw<0>::width(33) in a constant expression
+ *   - a register_image that breaks a datasheet rule, when checked with static_assert(image.valid())
+ */
+
+
+enum class Antenna_Mode :u8{
+    Transmit,       // PRIM_RX = 0
+    Recieve         // PRIM_RX = 1
+};
+
+/**
+ * @brief air data rate, RF_SETUP RF_DR_LOW / RF_DR_HIGH. Both ends of a link must use the same rate.
+ */
+enum class Data_Rate :u8{
+    Rate_250kbps,
+    Rate_1Mbps,
+    Rate_2Mbps
+};
+
+/**
+ * @brief transmit output power, the RF_SETUP RF_PWR field
+ */
+enum class PA_Level :u8{
+    Min_18dBm = 0,
+    Low_12dBm = 1,
+    High_6dBm = 2,
+    Max_0dBm = 3
+};
+
+/**
+ * @brief SETUP_AW, 00 is illegal so it has no enumerator
+ */
+enum class Address_Width :u8{
+    Bytes_3 = 1,
+    Bytes_4 = 2,
+    Bytes_5 = 3
+};
+
+
+namespace nrf_map {
+
+    inline constexpr u8 register_count = 0x1E;     // CONFIG - FEATURE
+    inline constexpr u8 read_prefix = 0x00;        // R_REGISTER 000A AAAA
+    inline constexpr u8 write_prefix = 0x20;       // W_REGISTER 001A AAAA
+    inline constexpr u8 address_mask = 0x1F;
+    inline constexpr u8 max_address_bytes = 5;
+
+    constexpr u8 read_command(u8 address) { return read_prefix | (address & address_mask); }
+    constexpr u8 write_command(u8 address) { return write_prefix | (address & address_mask); }
+
+    /**
+     * @brief Deliberately not constexpr: reaching it in a constant expression stops the compile. At run time it is
+     * a no-op and the value is masked to the field width.
+     */
+    inline void field_value_out_of_range() {}
+
+    /**
+     * @brief a register: address, reset value, bits the datasheet reserves and whether the driver may write it
+     */
+    template <u8 Address, u8 Reset, u8 Reserved = 0x00, bool Writable = true, u8 Bytes = 1>
+    struct register_T{
+        static_assert(Address < register_count, "not an nRF24L01+ register");
+        static constexpr u8 address = Address;
+        static constexpr u8 reset_value = Reset;
+        static constexpr u8 reserved_mask = Reserved;
+        static constexpr bool writable = Writable;
+        static constexpr u8 bytes = Bytes;
+        static constexpr u8 read = read_command(Address);
+        static constexpr u8 write = write_command(Address);
+    };
+
+    /**
+     * @brief Width bits at Shift of Register. An instance carries one value for compose and register_image::set;
+     * the static members do the encoding.
+     */
+    template <typename Register, u8 Shift, u8 Width, typename Value = u8, u8 Max = static_cast<u8>((1u << Width) - 1), bool Writable = true>
+    struct field_T{
+        static_assert(Width > 0 && Shift + Width <= 8, "a field lies inside one byte");
+        static_assert(Max <= (1u << Width) - 1, "largest value does not fit the width");
+
+        using register_type = Register;
+        using value_type = Value;
+        static constexpr u8 mask = static_cast<u8>(((1u << Width) - 1) << Shift);
+        static constexpr u8 max = Max;
+        static constexpr bool writable = Writable && Register::writable;
+        static_assert((mask & Register::reserved_mask) == 0, "field covers a reserved bit");
+
+        value_type value;
+        constexpr explicit field_T(value_type v) : value(v) {}
+
+        static constexpr u8 encode(value_type v){
+            const unsigned raw = static_cast<unsigned>(v);
+            if (raw > Max) {
+                field_value_out_of_range();
+            }
+            return static_cast<u8>((raw << Shift) & mask);
+        }
+        static constexpr value_type decode(u8 bits){
+            return static_cast<value_type>((bits & mask) >> Shift);
+        }
+        static constexpr bool test(u8 bits) { return (bits & mask) != 0; }
+        static constexpr u8 update(u8 bits, value_type v) { return static_cast<u8>((bits & ~mask) | encode(v)); }
+    };
+
+    template <typename Register, u8 Bit, bool Writable = true>
+    using flag_T = field_T<Register, Bit, 1, bool, 1, Writable>;
+
+
+    struct config : register_T<0x00, 0x08, 0x80>{
+        using mask_rx_dr = flag_T<config, 6>;
+        using mask_tx_ds = flag_T<config, 5>;
+        using mask_max_rt = flag_T<config, 4>;
+        using en_crc = flag_T<config, 3>;
+        using crco = flag_T<config, 2>;            // 0: 1 byte CRC, 1: 2 bytes
+        using pwr_up = flag_T<config, 1>;
+        using prim_rx = field_T<config, 0, 1, Antenna_Mode>;
+    };
+
+    /**
+     * @brief one bit per pipe, bits 7:6 reserved
+     */
+    template <typename Self, u8 Address, u8 Reset>
+    struct pipe_bits_T : register_T<Address, Reset, 0xC0>{
+        template <u8 Pipe>
+        using pipe = flag_T<Self, Pipe>;           // pipe<6> covers a reserved bit and does not compile
+        using pipes = field_T<Self, 0, 6>;
+        static constexpr u8 all_pipes = 0x3F;
+    };
+
+    struct en_aa : pipe_bits_T<en_aa, 0x01, 0x3F>{};
+    struct en_rxaddr : pipe_bits_T<en_rxaddr, 0x02, 0x03>{};
+
+    struct setup_aw : register_T<0x03, 0x03, 0xFC>{
+        using aw = field_T<setup_aw, 0, 2, Address_Width>;
+    };
+
+    struct setup_retr : register_T<0x04, 0x03>{
+        using ard = field_T<setup_retr, 4, 4>;     // (ard + 1) * 250 us
+        using arc = field_T<setup_retr, 0, 4>;
+
+        static constexpr uint16_t ard_step_us = 250;
+        /**
+         * @brief ARD steps for a delay, a delay off the 250 us grid or outside 250 - 4000 us is out of range
+         */
+        static constexpr u8 ard_for_us(uint16_t delay_us){
+            if (delay_us < ard_step_us || delay_us > 16 * ard_step_us || delay_us % ard_step_us != 0) {
+                field_value_out_of_range();
+                return 0;
+            }
+            return static_cast<u8>(delay_us / ard_step_us - 1);
+        }
+    };
+
+    struct rf_ch : register_T<0x05, 0x02, 0x80>{
+        using channel = field_T<rf_ch, 0, 7, u8, 125>;
+    };
+
+    struct rf_setup : register_T<0x06, 0x0E, 0x40>{
+        using cont_wave = flag_T<rf_setup, 7>;
+        using pll_lock = flag_T<rf_setup, 4>;
+        using rf_pwr = field_T<rf_setup, 1, 2, PA_Level>;
+
+        /**
+         * @brief RF_DR_LOW (bit 5) and RF_DR_HIGH (bit 3) as one field, the reserved 11 combination cannot be made
+         */
+        struct rf_dr{
+            using register_type = rf_setup;
+            using value_type = Data_Rate;
+            static constexpr u8 low_bit = 1 << 5;
+            static constexpr u8 high_bit = 1 << 3;
+            static constexpr u8 mask = low_bit | high_bit;
+            static constexpr bool writable = true;
+
+            value_type value;
+            constexpr explicit rf_dr(value_type v) : value(v) {}
+
+            static constexpr u8 encode(value_type v){
+                switch (v) {
+                    case Data_Rate::Rate_250kbps: return low_bit;
+                    case Data_Rate::Rate_1Mbps: return 0;
+                    case Data_Rate::Rate_2Mbps: return high_bit;
+                }
+                field_value_out_of_range();
+                return 0;
+            }
+            static constexpr value_type decode(u8 bits){
+                return (bits & low_bit) ? Data_Rate::Rate_250kbps : (bits & high_bit) ? Data_Rate::Rate_2Mbps : Data_Rate::Rate_1Mbps;
+            }
+            static constexpr u8 update(u8 bits, value_type v) { return static_cast<u8>((bits & ~mask) | encode(v)); }
+        };
+    };
+
+    struct status : register_T<0x07, 0x0E, 0x80>{
+        using rx_dr = flag_T<status, 6>;           // write 1 to clear
+        using tx_ds = flag_T<status, 5>;
+        using max_rt = flag_T<status, 4>;
+        using rx_p_no = field_T<status, 1, 3, u8, 7, false>;  // 7: RX FIFO empty, 6 unused
+        using tx_full = flag_T<status, 0, false>;
+
+        static constexpr u8 rx_fifo_empty = 7;
+    };
+    inline constexpr u8 status_irq_flags = status::rx_dr::mask | status::tx_ds::mask | status::max_rt::mask;
+
+    struct observe_tx : register_T<0x08, 0x00, 0x00, false>{
+        using plos_cnt = field_T<observe_tx, 4, 4>;
+        using arc_cnt = field_T<observe_tx, 0, 4>;
+    };
+
+    struct rpd : register_T<0x09, 0x00, 0xFE, false>{
+        using detected = flag_T<rpd, 0>;
+    };
+
+    // P0, P1 and TX_ADDR take the SETUP_AW width, P2 - P5 only replace the LSByte of P1
+    struct rx_addr_p0 : register_T<0x0A, 0xE7, 0x00, true, max_address_bytes>{};
+    struct rx_addr_p1 : register_T<0x0B, 0xC2, 0x00, true, max_address_bytes>{};
+    template <u8 Pipe>
+    struct rx_addr_lsb : register_T<0x0A + Pipe, 0xC1 + Pipe>{
+        static_assert(Pipe >= 2 && Pipe <= 5, "only pipes 2 - 5 have a 1 byte address");
+    };
+    struct tx_addr : register_T<0x10, 0xE7, 0x00, true, max_address_bytes>{};
+
+    template <u8 Pipe>
+    struct rx_pw : register_T<0x11 + Pipe, 0x00, 0xC0>{
+        static_assert(Pipe < 6, "the radio has six pipes");
+        using width = field_T<rx_pw, 0, 6, u8, 32>;   // 0: pipe not used
+    };
+
+    struct fifo_status : register_T<0x17, 0x11, 0x8C, false>{
+        using tx_reuse = flag_T<fifo_status, 6>;
+        using tx_full = flag_T<fifo_status, 5>;
+        using tx_empty = flag_T<fifo_status, 4>;
+        using rx_full = flag_T<fifo_status, 1>;
+        using rx_empty = flag_T<fifo_status, 0>;
+    };
+
+    struct dynpd : pipe_bits_T<dynpd, 0x1C, 0x00>{};
+
+    struct feature : register_T<0x1D, 0x00, 0xF8>{
+        using en_dpl = flag_T<feature, 2>;
+        using en_ack_pay = flag_T<feature, 1>;
+        using en_dyn_ack = flag_T<feature, 0>;
+    };
+
+
+    /**
+     * @brief a register value built from fields, e.g. compose<config>(config::pwr_up(true), config::prim_rx(...))
+     */
+    template <typename Register, typename... Fields>
+    constexpr u8 compose(const Fields&... fields){
+        static_assert((std::is_same_v<typename Fields::register_type, Register> && ...), "field belongs to another register");
+        static_assert((Fields::writable && ...), "read-only field");
+        static_assert((0u + ... + Fields::mask) == (0u | ... | Fields::mask), "a field is set twice");
+        return static_cast<u8>((0u | ... | Fields::encode(fields.value)));
+    }
+
+
+    /**
+     * @brief Contents of the writable configuration registers (CONFIG - FEATURE, without STATUS and the read-only
+     * ones), with a note of which registers the image sets. Built with constexpr set calls; registers an image does
+     * not set are left alone when it is applied.
+     */
+    class register_image{
+        public:
+            constexpr register_image() = default;
+
+            template <typename Field>
+            constexpr register_image& set(typename Field::value_type value){
+                using Register = typename Field::register_type;
+                static_assert(Field::writable, "read-only field");
+                static_assert(Register::bytes == 1, "address registers are set with set_address");
+                static_assert(Register::address != status::address, "STATUS is not configuration");
+                bytes_[Register::address] = Field::update(bytes_[Register::address], value);
+                defined_ |= 1u << Register::address;
+                return *this;
+            }
+
+            template <typename Field>
+            constexpr typename Field::value_type get() const{
+                return Field::decode(bytes_[Field::register_type::address]);
+            }
+
+            /**
+             * @brief a whole register at once, from a compose or a raw value without reserved bits
+             */
+            template <typename Register>
+            constexpr register_image& set_value(u8 value){
+                static_assert(Register::writable && Register::bytes == 1, "not a writable single byte register");
+                if (value & Register::reserved_mask) {
+                    field_value_out_of_range();
+                }
+                bytes_[Register::address] = value & ~Register::reserved_mask;
+                defined_ |= 1u << Register::address;
+                return *this;
+            }
+
+            /**
+             * @brief RX_ADDR_P0, RX_ADDR_P1 or TX_ADDR, LSByte first. Only the SETUP_AW width goes to the radio, so
+             * the image must set SETUP_AW too.
+             */
+            template <typename Register>
+            constexpr register_image& set_address(const std::array<u8, max_address_bytes>& address){
+                static_assert(Register::bytes == max_address_bytes, "pipes 2 - 5 take a 1 byte address, use set_value");
+                addresses_[address_slot(Register::address)] = address;
+                defined_ |= 1u << Register::address;
+                return *this;
+            }
+
+            constexpr bool defines(u8 address) const { return address < register_count && (defined_ >> address) & 1u; }
+            constexpr uint32_t defined() const { return defined_; }
+            constexpr u8 value(u8 address) const { return bytes_[address]; }
+
+            /**
+             * @brief bytes the image writes to a register, the SETUP_AW width for the 5 byte address registers. Only
+             * meaningful for a valid image, which sets SETUP_AW along with any address.
+             */
+            constexpr u8 length(u8 address) const{
+                return address_slot(address) < address_slots ? address_width() : 1;
+            }
+            constexpr const u8* data(u8 address) const{
+                const u8 slot = address_slot(address);
+                return slot < address_slots ? addresses_[slot].data() : &bytes_[address];
+            }
+
+            constexpr u8 address_width() const{
+                return static_cast<u8>(get<setup_aw::aw>()) + 2;
+            }
+
+            /**
+             * @brief first datasheet rule the image breaks, nullptr if none. Only registers the image sets are checked.
+             */
+            constexpr const char* problem() const{
+                if (defines(setup_aw::address) && (bytes_[setup_aw::address] & 0x03) == 0) {
+                    return "SETUP_AW 00 is illegal";
+                }
+                // length() of an address register is the image's SETUP_AW width, without one it would be garbage
+                if ((defines(rx_addr_p0::address) || defines(rx_addr_p1::address) || defines(tx_addr::address)) && !defines(setup_aw::address)) {
+                    return "an address register needs SETUP_AW";
+                }
+                if (defines(rf_ch::address) && get<rf_ch::channel>() > rf_ch::channel::max) {
+                    return "RF_CH above 125";
+                }
+                const u8 dynamic = defines(dynpd::address) ? bytes_[dynpd::address] : 0;
+                if (dynamic != 0 && !(defines(feature::address) && get<feature::en_dpl>())) {
+                    return "DYNPD needs FEATURE.EN_DPL";
+                }
+                if (dynamic != 0 && defines(en_aa::address) && (dynamic & ~bytes_[en_aa::address]) != 0) {
+                    return "DYNPD on a pipe without auto-ack";
+                }
+                if (defines(feature::address) && get<feature::en_ack_pay>() && !get<feature::en_dpl>()) {
+                    return "EN_ACK_PAY needs EN_DPL";
+                }
+                // only images that set CONFIG, radio_profile_T refuses those and leaves CONFIG to the driver
+                if (defines(en_aa::address) && defines(config::address) && bytes_[en_aa::address] != 0 && !get<config::en_crc>()) {
+                    return "auto-ack forces EN_CRC, set it";
+                }
+                if (defines(en_rxaddr::address)) {
+                    for (u8 pipe = 0; pipe < 6; ++pipe) {
+                        const u8 width_address = rx_pw<0>::address + pipe;
+                        const bool enabled = (bytes_[en_rxaddr::address] >> pipe) & 1u;
+                        const bool static_width = !((dynamic >> pipe) & 1u);
+                        if (enabled && static_width && defines(width_address) && (bytes_[width_address] == 0 || bytes_[width_address] > 32)) {
+                            return "enabled static pipe needs an RX_PW of 1 - 32";
+                        }
+                    }
+                }
+                return nullptr;
+            }
+            constexpr bool valid() const { return problem() == nullptr; }
+
+        private:
+            static constexpr u8 address_slots = 3;
+
+            static constexpr u8 address_slot(u8 address){
+                return address == rx_addr_p0::address ? 0 : address == rx_addr_p1::address ? 1 : address == tx_addr::address ? 2 : address_slots;
+            }
+
+            std::array<u8, register_count> bytes_ = {};
+            std::array<std::array<u8, max_address_bytes>, address_slots> addresses_ = {};
+            uint32_t defined_ = 0;
+    };
+}
@@ -0,0 +1,138 @@
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+extern "C" {
+    #include "esp_timer.h"
+}
+
+using u8 = uint8_t;
+
+
+/**
+ * Binary trace of what the driver did to the radio, for diagnostics in builds that log nothing. Each event is
+ * one 8 byte record, written without locks or formatting. The records are exported with trace_ring::dump and
+ * turned into text on the host by host/nrf_trace_decode.cpp.
+ *
+ * The driver only records with -DNRF_TRACE_ENABLED=1, otherwise every trace point compiles to nothing and an
+ * attached ring stays empty.
+ */
+#ifndef NRF_TRACE_ENABLED
+#define NRF_TRACE_ENABLED 0
+#endif
+
+#ifndef NRF_TRACE_CAPACITY
+#define NRF_TRACE_CAPACITY 512
+#endif
+
+
+enum class Trace_Event : u8 {
+    None = 0,
+    Register_Read,      // reg: address, value: first register byte
+    Register_Write,     // reg: address, value: first byte written
+    Command,            // reg: command byte (W_TX_PAYLOAD, FLUSH_TX, ...), value: bytes clocked
+    Spi_Error,          // reg: first command byte, value: bytes
+    Ce_High,
+    Ce_Low,
+    Ce_Pulse,
+    Mode_Rx,            // value: CONFIG written
+    Mode_Tx,            // value: CONFIG written
+    Tx_Sent,            // TX_DS, value: packet index within a stream
+    Tx_Failed,          // MAX_RT or timeout, value: packet index within a stream
+    Rx_Drain,           // value: packets service_irq drained
+    Count
+};
+
+/**
+ * @brief one trace event, the layout is the export format: little endian, 8 bytes, no padding
+ */
+struct trace_record_T{
+    uint32_t timestamp_us;  // low 32 bits of esp_timer_get_time(), wraps after about 71 minutes
+    u8 event;               // Trace_Event
+    u8 reg;
+    u8 status;              // STATUS clocked out with the event's SPI command, 0 when there was none
+    u8 value;
+};
+static_assert(sizeof(trace_record_T) == 8, "trace_record_T is the export format");
+
+inline const char* trace_event_name(u8 event){
+    static constexpr const char* names[] = {
+        "NONE", "REG_READ", "REG_WRITE", "COMMAND", "SPI_ERROR", "CE_HIGH", "CE_LOW", "CE_PULSE",
+        "MODE_RX", "MODE_TX", "TX_SENT", "TX_FAILED", "RX_DRAIN"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(Trace_Event::Count), "a Trace_Event has no name");
+    return event < static_cast<u8>(Trace_Event::Count) ? names[event] : "UNKNOWN";
+}
+
+
+/**
+ * @brief Flight recorder of trace records. Recording takes one atomic increment and an 8 byte store, from any task
+ * or ISR, and overwrites the oldest record once the ring is full. Read it with snapshot or dump while the driver is
+ * quiet, a record written during the copy may come out torn.
+ */
+class trace_ring{
+    static_assert(NRF_TRACE_CAPACITY >= 2 && (NRF_TRACE_CAPACITY & (NRF_TRACE_CAPACITY - 1)) == 0,
+                  "NRF_TRACE_CAPACITY must be a power of two");
+
+    private:
+        std::array<trace_record_T, NRF_TRACE_CAPACITY> records_ = {};
+        std::atomic<uint32_t> head_{0};     // free running, total records ever written
+
+    public:
+        static constexpr size_t capacity = NRF_TRACE_CAPACITY;
+
+        void record(Trace_Event event, u8 reg, u8 status, u8 value){
+            const uint32_t index = head_.fetch_add(1, std::memory_order_relaxed);
+            records_[index & (capacity - 1)] = {
+                static_cast<uint32_t>(esp_timer_get_time()), static_cast<u8>(event), reg, status, value
+            };
+        }
+
+        /**
+         * @brief total records written, including those already overwritten
+         */
+        uint32_t recorded() const { return head_.load(std::memory_order_acquire); }
+
+        void clear() { head_.store(0, std::memory_order_release); }
+
+        /**
+         * @brief copies the newest records, oldest first
+         *
+         * @param out destination
+         * @param max_records size of out
+         *
+         * @return size_t - records copied
+         */
+        size_t snapshot(trace_record_T* out, size_t max_records) const{
+            const uint32_t head = recorded();
+            size_t count = head < capacity ? head : capacity;
+            if (count > max_records) {
+                count = max_records;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = records_[(head - count + i) & (capacity - 1)];
+            }
+            return count;
+        }
+
+        /**
+         * @brief Prints the held records oldest first, one "NRFTRACE <hex>" line each, the 8 record bytes in
+         * export order. Capture the console and feed it to host/nrf_trace_decode.
+         */
+        void dump() const{
+            const uint32_t head = recorded();
+            const size_t count = head < capacity ? head : capacity;
+            printf("NRFTRACE begin %u of %u\n", static_cast<unsigned>(count), static_cast<unsigned>(head));
+            for (size_t i = 0; i < count; ++i) {
+                const u8* bytes = reinterpret_cast<const u8*>(&records_[(head - count + i) & (capacity - 1)]);
+                printf("NRFTRACE %02x%02x%02x%02x%02x%02x%02x%02x\n",
+                       bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5], bytes[6], bytes[7]);
+            }
+            printf("NRFTRACE end\n");
+        }
+};
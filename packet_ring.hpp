@@ -0,0 +1,126 @@
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+using u8 = uint8_t;
+
+
+/**
+ * @brief one received packet as it sits in a packet_ring slot
+ */
+struct rx_packet_T{
+    static constexpr u8 max_length = 32;
+
+    std::array<u8, max_length> data;
+    u8 length;
+    u8 pipe;                // RX_P_NO from STATUS
+    int64_t timestamp_us;   // esp_timer_get_time() when the packet was read out of the radio FIFO
+};
+
+
+/**
+ * @brief Fixed capacity lock-free single producer / single consumer ring of packet slots. The radio task is
+ * the only producer and never blocks, a full ring drops the packet and counts it in overflows(). One consumer
+ * task pops, singly or in batches. Nothing is allocated, the slots live inside the object.
+ *
+ * @tparam Capacity number of slots, a power of two
+ */
+template <size_t Capacity>
+class packet_ring{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "packet_ring capacity must be a power of two");
+
+    private:
+        std::array<rx_packet_T, Capacity> slots_ = {};
+
+        // free running indices, slot = index & (Capacity - 1). head_ is only written by the producer, tail_ by the consumer
+        std::atomic<size_t> head_{0};
+        std::atomic<size_t> tail_{0};
+
+        std::atomic<uint32_t> overflows_{0};
+        std::atomic<uint32_t> high_water_{0};
+
+    public:
+        static constexpr size_t capacity = Capacity;
+
+        /**
+         * @brief producer side, copies one packet into the next free slot
+         *
+         * @param data payload bytes, at most rx_packet_T::max_length
+         * @param length payload length
+         * @param pipe pipe the packet arrived on
+         * @param timestamp_us time the packet was read
+         *
+         * @return bool
+         * @retval true if stored
+         * @retval false if the ring was full or the length invalid, counted as an overflow
+         */
+        bool push(const u8* data, u8 length, u8 pipe, int64_t timestamp_us){
+            const size_t head = head_.load(std::memory_order_relaxed);
+            const size_t used = head - tail_.load(std::memory_order_acquire);
+            if (used >= Capacity || length > rx_packet_T::max_length) {
+                overflows_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            rx_packet_T& slot = slots_[head & (Capacity - 1)];
+            memcpy(slot.data.data(), data, length);
+            slot.length = length;
+            slot.pipe = pipe;
+            slot.timestamp_us = timestamp_us;
+            head_.store(head + 1, std::memory_order_release);
+
+            if (used + 1 > high_water_.load(std::memory_order_relaxed)) {
+                high_water_.store(static_cast<uint32_t>(used + 1), std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        /**
+         * @brief consumer side, copies up to max_packets of the oldest packets out and frees their slots
+         *
+         * @return size_t - packets copied into out, 0 if the ring is empty
+         */
+        size_t pop_batch(rx_packet_T* out, size_t max_packets){
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            const size_t available = head_.load(std::memory_order_acquire) - tail;
+            const size_t count = available < max_packets ? available : max_packets;
+
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = slots_[(tail + i) & (Capacity - 1)];
+            }
+            tail_.store(tail + count, std::memory_order_release);
+            return count;
+        }
+
+        bool pop(rx_packet_T& out){
+            return pop_batch(&out, 1) == 1;
+        }
+
+        /**
+         * @brief packets waiting, exact from either side, a snapshot from anywhere else
+         */
+        size_t size() const{
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+        }
+        bool empty() const { return size() == 0; }
+
+        /**
+         * @brief packets dropped because the ring was full, grow Capacity until this stays 0 under peak traffic
+         */
+        uint32_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief most packets ever waiting at once
+         */
+        uint32_t high_water() const { return high_water_.load(std::memory_order_relaxed); }
+
+        void reset_counters(){
+            overflows_.store(0, std::memory_order_relaxed);
+            high_water_.store(0, std::memory_order_relaxed);
+        }
+};
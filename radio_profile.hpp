@@ -0,0 +1,86 @@
+
+#pragma once
+
+#include "nrf_registers.hpp"
+
+
+namespace nrf_map {
+    /**
+     * @brief Deliberately not constexpr, like field_value_out_of_range: a constexpr radio_profile_T with a
+     * problem() stops the compile here.
+     */
+    inline void profile_image_rejected() {}
+}
+
+
+/**
+ * @brief A named operating profile: the registers the radio runs with (channel, rate, addresses, payload mode,
+ * pipes), compiled into a register_image. Declare profiles constexpr so the image is built and checked at compile
+ * time and lives in flash. Registers the image does not set keep whatever they hold when the profile is applied,
+ * so a profile must set the registers its settings depend on (see problem), the compile fails otherwise.
+ * CONFIG is left out, power and direction belong to the driver's state machine.
+ *
+ *   constexpr radio_profile_T sensors("sensors", nrf_map::register_image{}
+ *       .set<nrf_map::rf_ch::channel>(76)
+ *       .set<nrf_map::rf_setup::rf_dr>(Data_Rate::Rate_1Mbps)
+ *       ...);
+ */
+struct radio_profile_T{
+    const char* name;
+    nrf_map::register_image image;
+    u8 ack_payload_length;          // longest ACK payload the peer sends, ARD is checked against it
+
+    constexpr radio_profile_T(const char* profile_name, const nrf_map::register_image& profile_image, u8 ack_payload_bytes = 0)
+        : name(profile_name), image(profile_image), ack_payload_length(ack_payload_bytes){
+        if (problem() != nullptr) {
+            nrf_map::profile_image_rejected();
+        }
+    }
+
+    /**
+     * @brief first reason the profile cannot be applied, nullptr if none. On top of the image's datasheet rules a
+     * profile sets every register its own settings are read against, since a register it leaves out keeps
+     * whatever the previous profile wrote.
+     */
+    constexpr const char* problem() const{
+        using namespace nrf_map;
+        if (const char* image_problem = image.problem()) {
+            return image_problem;
+        }
+        if (image.defines(config::address)) {
+            return "CONFIG belongs to the driver's state machine";
+        }
+        if (ack_payload_length > 32) {
+            return "ACK payloads are 32 bytes at most";
+        }
+        if (image.defines(setup_retr::address) != image.defines(rf_setup::address)) {
+            return "ARD is checked against the data rate, set SETUP_RETR and RF_SETUP together";
+        }
+        const u8 dynamic = image.defines(dynpd::address) ? image.value(dynpd::address) : 0;
+        if (dynamic != 0 && !image.defines(en_aa::address)) {
+            return "DYNPD needs EN_AA in the profile";
+        }
+        if (image.defines(feature::address) && image.get<feature::en_dpl>() && !image.defines(dynpd::address)) {
+            return "EN_DPL needs DYNPD in the profile";
+        }
+        if (image.defines(en_rxaddr::address)) {
+            for (u8 pipe = 0; pipe < 6; ++pipe) {
+                const bool enabled = (image.value(en_rxaddr::address) >> pipe) & 1u;
+                if (enabled && !((dynamic >> pipe) & 1u) && !image.defines(rx_pw<0>::address + pipe)) {
+                    return "an enabled static pipe needs its RX_PW in the profile";
+                }
+            }
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * @brief what switching profiles cost since construction or reset_profile_stats
+ */
+struct profile_stats_T{
+    uint32_t switches;
+    uint32_t registers_written;     // registers that differed and went out in the switch bursts
+    uint32_t registers_skipped;     // registers the shadow cache showed already held the profile's value
+    uint64_t switch_us;             // time from leaving RX / TX to being back in it
+};
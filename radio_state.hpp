@@ -0,0 +1,100 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+using u8 = uint8_t;
+
+
+/**
+ * @brief operating states of the radio, datasheet figure 4. The driver only sees CE and CONFIG, so StandbyII and
+ * TxActive take the same actions (PRIM_RX=0, CE high) and differ only in whether the TX FIFO has something to send.
+ */
+enum class Radio_State :u8{
+    PowerDown,      // PWR_UP=0, registers kept, crystal off
+    StandbyI,       // PWR_UP=1, CE low
+    StandbyII,      // PWR_UP=1, PRIM_RX=0, CE high, TX FIFO empty
+    RxActive,       // PWR_UP=1, PRIM_RX=1, CE high
+    TxActive,       // PWR_UP=1, PRIM_RX=0, CE high or pulsed, a packet on air
+    Count
+};
+
+inline constexpr size_t radio_state_count = static_cast<size_t>(Radio_State::Count);
+
+inline const char* radio_state_name(Radio_State state){
+    static constexpr const char* names[] = { "PowerDown", "StandbyI", "StandbyII", "RxActive", "TxActive" };
+    static_assert(sizeof(names) / sizeof(names[0]) == radio_state_count, "a Radio_State has no name");
+    return state < Radio_State::Count ? names[static_cast<size_t>(state)] : "?";
+}
+
+
+namespace radio_transitions {
+    using state_table_T = bool[radio_state_count][radio_state_count];
+    using route_table_T = Radio_State[radio_state_count][radio_state_count];
+
+    constexpr Radio_State PD = Radio_State::PowerDown;
+    constexpr Radio_State S1 = Radio_State::StandbyI;
+    constexpr Radio_State S2 = Radio_State::StandbyII;
+    constexpr Radio_State RX = Radio_State::RxActive;
+    constexpr Radio_State TX = Radio_State::TxActive;
+
+    /**
+     * @brief single steps the radio can take, [from][to]. Clearing PWR_UP is allowed from anywhere, everything else
+     * goes through standby-I: CONFIG may only change direction with CE low.
+     */
+    inline constexpr state_table_T legal = {
+        //              PD     S1     S2     RX     TX
+        /* PD */      { false, true,  false, false, false },
+        /* S1 */      { true,  false, true,  true,  true  },
+        /* S2 */      { true,  true,  false, false, true  },    // a FIFO write starts TX
+        /* RX */      { true,  true,  false, false, false },
+        /* TX */      { true,  true,  true,  false, false },    // the FIFO ran empty with CE still high
+    };
+
+    /**
+     * @brief next step from [from] towards [to], the target itself when the step is legal
+     */
+    inline constexpr route_table_T next_step = {
+        //              PD  S1  S2  RX  TX
+        /* PD */      { PD, S1, S1, S1, S1 },
+        /* S1 */      { PD, S1, S2, RX, TX },
+        /* S2 */      { PD, S1, S2, S1, TX },
+        /* RX */      { PD, S1, S1, RX, S1 },
+        /* TX */      { PD, S1, S2, S1, TX },
+    };
+
+    constexpr bool route_is_legal(Radio_State from, Radio_State to){
+        const Radio_State step = next_step[static_cast<size_t>(from)][static_cast<size_t>(to)];
+        return from == to ? step == to : legal[static_cast<size_t>(from)][static_cast<size_t>(step)];
+    }
+
+    constexpr bool all_routes_legal(){
+        for (size_t from = 0; from < radio_state_count; ++from) {
+            for (size_t to = 0; to < radio_state_count; ++to) {
+                if (!route_is_legal(static_cast<Radio_State>(from), static_cast<Radio_State>(to))) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    static_assert(all_routes_legal(), "next_step takes a step the legal table forbids");
+}
+
+
+/**
+ * @brief Where the radio's time and the SPI traffic of its mode changes went, indexed [from][to] with Radio_State.
+ * Time in the current state is added when the radio leaves it. Every step of a routed request counts on its own,
+ * RxActive to TxActive shows up as RxActive to StandbyI plus StandbyI to TxActive. StandbyI to StandbyI is a
+ * PRIM_RX change while in standby.
+ */
+struct radio_state_stats_T{
+    uint32_t transitions[radio_state_count][radio_state_count];
+    uint64_t transition_us[radio_state_count][radio_state_count];           // CE/CONFIG SPI and datasheet waits of the step
+    uint32_t transition_spi_bytes[radio_state_count][radio_state_count];
+    uint64_t time_in_us[radio_state_count];
+    uint32_t config_writes;     // CONFIG writes the steps needed, a matching shadow copy skips the write
+    uint32_t ce_toggles;        // CE edges the steps needed, a TX pulse is two
+    uint32_t redundant;         // requests for the state the radio was already in, no SPI and no CE edge
+};
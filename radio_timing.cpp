@@ -0,0 +1,72 @@
+#include "radio_timing.hpp"
+
+extern "C" {
+    #include "freertos/FreeRTOS.h"
+    #include "freertos/task.h"
+    #include "esp_timer.h"
+    #include <rom/ets_sys.h>
+}
+
+
+radio_clock_T radio_clock_T::system() {
+    return {
+        [](void*) -> int64_t { return esp_timer_get_time(); },
+        [](uint32_t us, void*) {
+            const int64_t deadline_us = esp_timer_get_time() + us;
+            const uint32_t tick_us = 1000000 / configTICK_RATE_HZ;
+            if (us >= tick_us) {
+                vTaskDelay(us / tick_us);
+            }
+            // vTaskDelay counts tick interrupts and can return up to a tick early, the clock says what is left
+            const int64_t remaining_us = deadline_us - esp_timer_get_time();
+            if (remaining_us > 0) {
+                ets_delay_us(static_cast<uint32_t>(remaining_us));
+            }
+        },
+        nullptr
+    };
+}
+
+
+radio_timing::radio_timing(const radio_clock_T& clock) : clock_(clock) {
+}
+
+
+void radio_timing::delay_us(uint32_t us) {
+    if (us == 0) {
+        stats_.skipped++;
+        return;
+    }
+    stats_.waits++;
+    stats_.waited_us += us;
+    clock_.delay_us(us, clock_.context);
+}
+
+
+void radio_timing::wait_until(int64_t deadline_us) {
+    const int64_t remaining_us = deadline_us - now_us();
+    delay_us(remaining_us > 0 ? static_cast<uint32_t>(remaining_us) : 0);
+}
+
+
+void radio_timing::powered_up() {
+    if (!powered_) {
+        powered_ = true;
+        powered_up_us_ = now_us();
+    }
+}
+
+
+void radio_timing::wait_standby() {
+    if (powered_) {
+        wait_until(powered_up_us_ + nrf_timing::power_down_to_standby_us);
+    }
+}
+
+
+void radio_timing::ce_raised() {
+    if (!ce_high_) {
+        ce_high_ = true;
+        ce_raised_us_ = now_us();
+    }
+}
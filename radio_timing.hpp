@@ -0,0 +1,112 @@
+
+#pragma once
+
+#include <cstdint>
+
+
+/**
+ * @brief nRF24L01+ state transition times from the datasheet (table 16 and the power on reset note)
+ */
+namespace nrf_timing {
+    inline constexpr int64_t power_on_reset_us = 100 * 1000;     // Tpor, VDD up to the first SPI access, counted from boot
+    inline constexpr uint32_t power_down_to_standby_us = 1500;  // Tpd2stby, PWR_UP set to standby-I with the crystal running
+    inline constexpr uint32_t standby_to_active_us = 130;       // Tstby2a, CE high to RX listening or the TX packet on air
+    inline constexpr uint32_t ce_high_min_us = 10;              // Thce, shortest CE pulse that starts a TX
+}
+
+
+/**
+ * @brief Time source of the driver. Every wait goes through delay_us and every timestamp through now_us, so a
+ * test can swap in a clock that records the requested delays or runs on simulated time.
+ */
+struct radio_clock_T{
+    int64_t (*now_us)(void* context);
+    void (*delay_us)(uint32_t us, void* context);
+    void* context;
+
+    /**
+     * @brief esp_timer_get_time, waits of whole FreeRTOS ticks are slept so other tasks run, then the rest up to
+     * the deadline busy waits, so a wait never ends early
+     */
+    static radio_clock_T system();
+};
+
+/**
+ * @brief waits spent by a radio_timing since construction or reset_stats
+ */
+struct radio_timing_stats_T{
+    uint32_t waits;             // waits that actually delayed
+    uint32_t skipped;           // waits whose interval had already passed
+    uint64_t waited_us;
+};
+
+
+/**
+ * @brief Remembers when the radio last powered up and when CE last went high, and makes the next transition
+ * wait only for whatever is left of the datasheet interval. Time spent on SPI traffic or the caller's own
+ * work in between is not waited for again.
+ */
+class radio_timing{
+    public:
+        explicit radio_timing(const radio_clock_T& clock = radio_clock_T::system());
+
+        int64_t now_us() const { return clock_.now_us(clock_.context); }
+
+        /**
+         * @brief waits a fixed interval through the clock
+         */
+        void delay_us(uint32_t us);
+
+        /**
+         * @brief waits until the clock reads deadline_us, returns at once if it already passed
+         */
+        void wait_until(int64_t deadline_us);
+
+        /**
+         * @brief PWR_UP was just written, standby-I is reached Tpd2stby later
+         */
+        void powered_up();
+        void powered_down() { powered_ = false; }
+        bool powered() const { return powered_; }
+
+        /**
+         * @brief before the first SPI access, waits out what is left of Tpor since boot
+         */
+        void wait_power_on_reset() { wait_until(nrf_timing::power_on_reset_us); }
+
+        /**
+         * @brief before raising CE, waits out what is left of Tpd2stby
+         */
+        void wait_standby();
+
+        /**
+         * @brief CE was driven high, the radio is active Tstby2a after the rising edge. Raising an already high CE
+         * keeps the earlier edge.
+         */
+        void ce_raised();
+        void ce_dropped() { ce_high_ = false; }
+        bool ce_high() const { return ce_high_; }
+
+        /**
+         * @brief waits out what is left of Tstby2a since CE went high, e.g. before sampling RPD
+         */
+        void wait_active() { wait_until(ce_raised_us_ + nrf_timing::standby_to_active_us); }
+
+        /**
+         * @brief before dropping CE at the end of a TX pulse, waits out what is left of Thce
+         */
+        void wait_ce_pulse() { wait_until(ce_raised_us_ + nrf_timing::ce_high_min_us); }
+
+        const radio_clock_T& clock() const { return clock_; }
+        const radio_timing_stats_T& stats() const { return stats_; }
+        void reset_stats() { stats_ = {}; }
+
+    private:
+        radio_clock_T clock_;
+        radio_timing_stats_T stats_ = {};
+
+        bool powered_ = false;
+        int64_t powered_up_us_ = 0;
+        bool ce_high_ = false;
+        int64_t ce_raised_us_ = 0;
+};
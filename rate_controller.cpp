@@ -0,0 +1,200 @@
+#include "rate_controller.hpp"
+#include "nrf_log.hpp"
+
+
+rate_controller::rate_controller(const rate_controller_config_T& config) : config_(config) {
+    if (config_.window_packets == 0) {
+        config_.window_packets = 1;
+    }
+}
+
+
+void rate_controller::reset() {
+    rates_ = {};
+    stats_ = {};
+    window_ = {};
+    last_loss_ = 0.0f;
+    hold_ = 0;
+    healthy_windows_ = 0;
+    probe_backoff_ = 0;
+    probing_ = false;
+}
+
+
+bool rate_controller::record(bool delivered, u8 retransmits, bool strong_signal) {
+    window_.sent++;
+    window_.retransmits += retransmits;
+    stats_.packets++;
+    stats_.retransmits += retransmits;
+    if (delivered) {
+        window_.delivered++;
+        stats_.delivered++;
+    }
+    if (strong_signal) {
+        window_.strong_signal++;
+    }
+    return window_.sent >= config_.window_packets;
+}
+
+
+float rate_controller::expected_goodput(Data_Rate rate) const {
+    static constexpr float air_rate_bps[rate_count] = { 250e3f, 1e6f, 2e6f };
+    const rate_stats_T& measured = rates_[static_cast<size_t>(rate)];
+    return air_rate_bps[static_cast<size_t>(rate)] * measured.success / (1.0f + measured.retransmits);
+}
+
+
+void rate_controller::set_rate(rf_settings_T& next, Data_Rate rate, u8 ack_payload_length) {
+    next.data_rate = rate;
+    const uint16_t min_delay_us = NRF24::min_retransmit_delay_us(rate, ack_payload_length);
+    if (next.retransmit_delay_us < min_delay_us) {
+        next.retransmit_delay_us = min_delay_us;
+    }
+}
+
+
+bool rate_controller::decide(const rf_settings_T& current, u8 ack_payload_length, bool can_change_rate, rf_settings_T& next) {
+    next = current;
+    if (window_.sent == 0) {
+        return false;
+    }
+
+    // fold the window into the averages of the rate it was sent at
+    const float success = static_cast<float>(window_.delivered) / window_.sent;
+    const float retransmits = window_.delivered > 0
+        ? static_cast<float>(window_.retransmits) / window_.delivered
+        : static_cast<float>(NRF_regs::max_retransmit_count);
+    const bool mostly_strong = window_.strong_signal * 2 > window_.sent;
+    window_ = {};
+    last_loss_ = 1.0f - success;
+
+    rate_stats_T& measured = rates_[static_cast<size_t>(current.data_rate)];
+    if (measured.windows == 0) {
+        measured.success = success;
+        measured.retransmits = retransmits;
+    } else {
+        measured.success += config_.ewma_weight * (success - measured.success);
+        measured.retransmits += config_.ewma_weight * (retransmits - measured.retransmits);
+    }
+    measured.windows++;
+
+    const bool rate_allowed = can_change_rate && config_.adapt_data_rate;
+    const bool within_target = last_loss_ <= config_.loss_target;
+
+    if (probing_) {
+        // one window at the faster rate decides, a miss goes straight back without raising power first
+        probing_ = false;
+        if (!within_target && rate_allowed) {
+            stats_.failed_probes++;
+            if (probe_backoff_ < max_probe_backoff) {
+                probe_backoff_++; // a rate that keeps failing is tried less and less often
+            }
+            set_rate(next, probe_return_rate_, ack_payload_length);
+            hold_ = config_.hold_windows;
+            return true;
+        }
+        if (within_target) {
+            stats_.rate_ups++;
+            probe_backoff_ = 0;
+        }
+    }
+
+    if (hold_ > 0) {
+        hold_--;
+        return false;
+    }
+
+    if (!within_target) {
+        healthy_windows_ = 0;
+        if (config_.adapt_pa_level && current.pa_level != PA_Level::Max_0dBm) {
+            next.pa_level = static_cast<PA_Level>(static_cast<u8>(current.pa_level) + 1);
+            stats_.pa_ups++;
+        } else if (rate_allowed && current.data_rate != Data_Rate::Rate_250kbps) {
+            set_rate(next, static_cast<Data_Rate>(static_cast<u8>(current.data_rate) - 1), ack_payload_length);
+            stats_.rate_downs++;
+        } else {
+            return false;
+        }
+        hold_ = config_.hold_windows;
+        return true;
+    }
+
+    if (rate_allowed) {
+        // a rate already measured to do clearly better, typically a slower one that loses less
+        Data_Rate best = current.data_rate;
+        for (size_t rate = 0; rate < rate_count; ++rate) {
+            const rate_stats_T& candidate = rates_[rate];
+            if (candidate.windows == 0 || 1.0f - candidate.success > config_.loss_target) {
+                continue;
+            }
+            if (expected_goodput(static_cast<Data_Rate>(rate)) > expected_goodput(best) * (1.0f + config_.switch_margin)) {
+                best = static_cast<Data_Rate>(rate);
+            }
+        }
+        if (best != current.data_rate) {
+            if (best > current.data_rate) {
+                stats_.rate_ups++;
+            } else {
+                stats_.rate_downs++;
+            }
+            set_rate(next, best, ack_payload_length);
+            healthy_windows_ = 0;
+            hold_ = config_.hold_windows;
+            return true;
+        }
+
+        if (current.data_rate != Data_Rate::Rate_2Mbps && ++healthy_windows_ >= (config_.probe_interval_windows << probe_backoff_)) {
+            healthy_windows_ = 0;
+            probing_ = true;
+            probe_return_rate_ = current.data_rate;
+            set_rate(next, static_cast<Data_Rate>(static_cast<u8>(current.data_rate) + 1), ack_payload_length);
+            stats_.probes++;
+            return true;
+        }
+    }
+
+    // ACKs arriving hot with loss well under the target, spend less power
+    if (config_.adapt_pa_level && mostly_strong && last_loss_ * 2 <= config_.loss_target && current.pa_level != PA_Level::Min_18dBm) {
+        next.pa_level = static_cast<PA_Level>(static_cast<u8>(current.pa_level) - 1);
+        stats_.pa_downs++;
+        hold_ = config_.hold_windows;
+        return true;
+    }
+    return false;
+}
+
+
+bool rate_controller::on_transmit(NRF24& radio, bool delivered, peer_hook_T peer_hook, void* context) {
+    link_quality_T quality = {};
+    if (!radio.read_link_quality(quality)) {
+        return false;
+    }
+    if (!record(delivered, quality.retransmits, quality.strong_signal)) {
+        return false;
+    }
+
+    const rf_settings_T current = radio.rf_settings();
+    rf_settings_T next = {};
+    if (!decide(current, radio.ack_payload_length(), peer_hook != nullptr, next)) {
+        return false;
+    }
+
+    if (next.data_rate != current.data_rate && !peer_hook(next, context)) {
+        NRF_LOGW("[RATE_CONTROLLER::on_transmit] Peer did not switch data rate, keeping %d\n", static_cast<int>(current.data_rate));
+        probing_ = false;
+        return false;
+    }
+    if (!radio.apply_rf_settings(next, radio.ack_payload_length())) {
+        NRF_LOGE("[RATE_CONTROLLER::on_transmit] Radio rejected the new settings\n");
+        if (next.data_rate != current.data_rate) {
+            peer_hook(current, context); // keep both ends on the same rate
+        }
+        probing_ = false;
+        return false;
+    }
+
+    NRF_LOGI("[RATE_CONTROLLER::on_transmit] loss %.2f: rate %d -> %d, pa %d -> %d\n", last_loss_,
+           static_cast<int>(current.data_rate), static_cast<int>(next.data_rate),
+           static_cast<int>(current.pa_level), static_cast<int>(next.pa_level));
+    return true;
+}
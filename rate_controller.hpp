@@ -0,0 +1,154 @@
+
+#pragma once
+
+#include "nRF24L01P.hpp"
+
+#include <array>
+
+
+/**
+ * @brief tuning of a rate_controller, the defaults suit links that send at least a few dozen packets a second
+ */
+struct rate_controller_config_T{
+    float loss_target = 0.10f;          // window loss at or below this is acceptable
+    uint16_t window_packets = 32;       // transmit outcomes per decision
+    float ewma_weight = 0.25f;          // weight of the newest window in the per rate averages
+    float switch_margin = 0.15f;        // another measured rate must promise this much more goodput to be picked
+    u8 hold_windows = 2;                // windows a new setting is kept before it can be left again
+    u8 probe_interval_windows = 10;     // healthy windows between tries of the next faster rate
+    bool adapt_data_rate = true;        // only with a peer hook, both ends have to switch together
+    bool adapt_pa_level = true;
+};
+
+/**
+ * @brief what a rate_controller has learned about one data rate
+ */
+struct rate_stats_T{
+    float success;          // EWMA of delivered / sent
+    float retransmits;      // EWMA of ARC_CNT per delivered packet
+    uint32_t windows;       // windows measured at this rate, 0 while the rate is unknown
+};
+
+/**
+ * @brief running totals of a rate_controller
+ */
+struct rate_controller_stats_T{
+    uint32_t packets;
+    uint32_t delivered;
+    uint32_t retransmits;
+    uint32_t rate_ups;
+    uint32_t rate_downs;
+    uint32_t pa_ups;
+    uint32_t pa_downs;
+    uint32_t probes;            // windows spent trying a faster rate
+    uint32_t failed_probes;     // probes that missed the loss target and were rolled back
+};
+
+
+/**
+ * @brief Minstrel style rate and power control for one link. Every transmit outcome is recorded together with
+ * OBSERVE_TX ARC_CNT and RPD. At the end of each window of window_packets outcomes the controller:
+ *  - raises PA level, then lowers the data rate, while the window loss is above loss_target
+ *  - moves to a measured rate whose expected goodput (rate x success / (1 + retransmits)) beats the current one by switch_margin
+ *  - every probe_interval_windows healthy windows tries the next faster rate for one window and rolls back if it misses
+ *    the target, each failed probe doubles the interval
+ *  - lowers PA level when most ACKs came back above the RPD threshold and loss is under half the target
+ * A new setting is held for hold_windows windows, and the gap between the up and down thresholds keeps it from flapping.
+ *
+ * The decision core (record / decide) never touches the radio, so it can be driven by a simulated lossy channel.
+ * on_transmit wires it to an NRF24.
+ */
+class rate_controller{
+    public:
+        /**
+         * @brief applies a new data rate on the far end of the link before this end switches, false keeps the old rate
+         */
+        using peer_hook_T = NRF24::sweep_peer_hook_T;
+
+        explicit rate_controller(const rate_controller_config_T& config = {});
+
+        /**
+         * @brief adds one transmit outcome to the current window
+         *
+         * @param delivered TX_DS
+         * @param retransmits ARC_CNT of the packet
+         * @param strong_signal RPD after the exchange
+         *
+         * @return bool - true when the window is complete and decide should be called
+         */
+        bool record(bool delivered, u8 retransmits, bool strong_signal);
+
+        /**
+         * @brief closes the current window and picks the settings for the next one
+         *
+         * @param current settings the window was measured with
+         * @param ack_payload_length longest ACK payload, ARD is raised to the minimum of a new rate
+         * @param can_change_rate false keeps the data rate, e.g. when the peer cannot follow
+         * @param next set to the new settings, equal to current when nothing changes
+         *
+         * @return bool - true if next differs from current
+         */
+        bool decide(const rf_settings_T& current, u8 ack_payload_length, bool can_change_rate, rf_settings_T& next);
+
+        /**
+         * @brief Call after every acknowledged transmit (transmit_request, or transmit_data with auto-ack). Reads
+         * OBSERVE_TX and RPD, records the outcome and at the end of a window applies the decision: a rate change
+         * goes to peer_hook first, then to the radio with apply_rf_settings. Without a peer hook only the PA level adapts.
+         *
+         * @param radio radio that made the transmit
+         * @param delivered what the transmit returned
+         * @param peer_hook optional, switches the receiver's data rate
+         * @param context passed through to peer_hook
+         *
+         * @return bool - true if the radio settings changed
+         */
+        bool on_transmit(NRF24& radio, bool delivered, peer_hook_T peer_hook = nullptr, void* context = nullptr);
+
+        /**
+         * @brief loss of the last completed window
+         */
+        float loss() const { return last_loss_; }
+
+        const rate_stats_T& rate_stats(Data_Rate rate) const { return rates_[static_cast<size_t>(rate)]; }
+        const rate_controller_stats_T& stats() const { return stats_; }
+        const rate_controller_config_T& config() const { return config_; }
+
+        /**
+         * @brief forgets everything learned, e.g. after the link moved to another channel
+         */
+        void reset();
+
+    private:
+        static constexpr size_t rate_count = 3;
+
+        struct window_T{
+            uint16_t sent;
+            uint16_t delivered;
+            uint32_t retransmits;
+            uint16_t strong_signal;
+        };
+
+        rate_controller_config_T config_;
+        std::array<rate_stats_T, rate_count> rates_ = {};
+        rate_controller_stats_T stats_ = {};
+        window_T window_ = {};
+        float last_loss_ = 0.0f;
+
+        static constexpr u8 max_probe_backoff = 4;
+
+        u8 hold_ = 0;
+        uint16_t healthy_windows_ = 0;
+        u8 probe_backoff_ = 0;      // each failed probe doubles the probe interval, up to 16x
+        bool probing_ = false;
+        Data_Rate probe_return_rate_ = Data_Rate::Rate_250kbps;
+
+        /**
+         * @brief expected goodput of a measured rate in bits per second of air rate
+         */
+        float expected_goodput(Data_Rate rate) const;
+
+        /**
+         * @brief switches next to rate, raising ARD to what the rate needs for the ACK payload length
+         */
+        static void set_rate(rf_settings_T& next, Data_Rate rate, u8 ack_payload_length);
+};
@@ -0,0 +1,366 @@
+#include "reliable_transport.hpp"
+#include "nrf_log.hpp"
+#include <cstring>
+
+
+namespace {
+    constexpr uint32_t ack_poll_interval_us = 100;
+
+    uint32_t bit(size_t index) { return static_cast<uint32_t>(1) << index; }
+
+    uint32_t shift_down(uint32_t bits, size_t count) { return count >= 32 ? 0 : bits >> count; }
+}
+
+
+transport_sender::transport_sender(NRF24& radio, const transport_config_T& config) : radio_(radio), config_(config) {
+    if (config_.window == 0) {
+        config_.window = 1;
+    }
+    if (config_.window > max_window) {
+        config_.window = max_window;
+    }
+    timeout_us_ = config_.initial_timeout_us;
+    transfer_id_ = static_cast<u8>(esp_random()); // a sender that rebooted must not reuse the id a receiver still holds
+}
+
+
+bool transport_sender::begin(const u8* data, size_t length) {
+    if (state_ == Transfer_State::Sending || state_ == Transfer_State::Waiting) {
+        NRF_LOGE("[TRANSPORT_SENDER::begin] A transfer is still in progress\n");
+        return false;
+    }
+    if (data == nullptr || length == 0 || length > transport_frame::max_transfer_size) {
+        NRF_LOGE("[TRANSPORT_SENDER::begin] Invalid transfer of %zu bytes\n", length);
+        return false;
+    }
+
+    data_ = data;
+    length_ = length;
+    fragment_count_ = (length + transport_frame::data_payload_size - 1) / transport_frame::data_payload_size;
+    transfer_id_++; // a receiver still holding the previous transfer tells them apart by this
+    base_ = 0;
+    acked_ = 0;
+    sent_ = 0;
+    consecutive_timeouts_ = 0;
+    started_us_ = radio_.timing().now_us();
+    state_ = Transfer_State::Sending;
+    return true;
+}
+
+
+void transport_sender::cancel() {
+    if (state_ == Transfer_State::Sending || state_ == Transfer_State::Waiting) {
+        state_ = Transfer_State::Idle;
+    }
+}
+
+
+size_t transport_sender::acknowledged_bytes() const {
+    const size_t bytes = base_ * transport_frame::data_payload_size;
+    return bytes < length_ ? bytes : length_;
+}
+
+
+void transport_sender::finish(Transfer_State state) {
+    state_ = state;
+    stats_.elapsed_us = radio_.timing().now_us() - started_us_;
+    if (state == Transfer_State::Complete) {
+        base_ = fragment_count_;
+        stats_.bytes_delivered += length_;
+    } else {
+        NRF_LOGW("[TRANSPORT_SENDER::pump] Transfer %d failed after %d timeouts, %zu of %zu bytes acknowledged\n",
+               transfer_id_, consecutive_timeouts_, acknowledged_bytes(), length_);
+    }
+}
+
+
+void transport_sender::send_burst() {
+    size_t count = 0;
+    burst_retransmitted_ = false;
+
+    for (size_t i = 0; i < config_.window && base_ + i < fragment_count_; ++i) {
+        if (acked_ & bit(i)) {
+            continue;
+        }
+        const size_t sequence = base_ + i;
+        const size_t offset = sequence * transport_frame::data_payload_size;
+        const size_t remaining = length_ - offset;
+        const u8 payload_length = static_cast<u8>(remaining < transport_frame::data_payload_size ? remaining : transport_frame::data_payload_size);
+        const bool last = sequence + 1 == fragment_count_;
+
+        std::array<u8, NRF24::fifo_max_size>& frame = frames_[count];
+        frame[0] = static_cast<u8>(transport_frame::type_data | (last ? transport_frame::flag_last : 0));
+        frame[1] = transfer_id_;
+        frame[2] = static_cast<u8>(sequence);
+        frame[3] = static_cast<u8>(sequence >> 8);
+        frame[4] = payload_length;
+        memcpy(frame.data() + transport_frame::header_size, data_ + offset, payload_length);
+        burst_[count] = { frame.data(), static_cast<u8>(transport_frame::header_size + payload_length), false };
+
+        if (sent_ & bit(i)) {
+            stats_.retransmitted_frames++;
+            burst_retransmitted_ = true;
+        }
+        sent_ |= bit(i);
+        count++;
+    }
+
+    if (count > 0) {
+        frames_[count - 1][0] |= transport_frame::flag_ack_request;
+        radio_.transmit_stream(burst_.data(), count); // losses are found through the transport ACK
+        stats_.frames_sent += count;
+        stats_.bursts++;
+    }
+    burst_done_us_ = radio_.timing().now_us();
+    state_ = Transfer_State::Waiting;
+}
+
+
+void transport_sender::apply_ack(size_t cumulative, uint32_t selective, bool complete) {
+    if (complete) {
+        base_ = fragment_count_;
+        return;
+    }
+    if (cumulative > fragment_count_) {
+        return;
+    }
+    if (cumulative >= base_) {
+        const size_t advance = cumulative - base_;
+        acked_ = shift_down(acked_, advance) | selective;
+        sent_ = shift_down(sent_, advance);
+        base_ = cumulative;
+    } else {
+        acked_ |= shift_down(selective, base_ - cumulative); // an older ACK overtaken by a newer one
+    }
+    while (base_ < fragment_count_ && (acked_ & 1)) {
+        acked_ >>= 1;
+        sent_ >>= 1;
+        base_++;
+    }
+}
+
+
+void transport_sender::update_timeout(int64_t rtt_us) {
+    // Jacobson/Karels, as TCP does. Without a sample the backed off timer just drops back to the estimate
+    if (rtt_us < 0) {
+        if (srtt_us_ == 0) {
+            return;
+        }
+    } else if (srtt_us_ == 0) {
+        srtt_us_ = rtt_us;
+        rttvar_us_ = rtt_us / 2;
+    } else {
+        const int64_t error = rtt_us - srtt_us_;
+        rttvar_us_ += ((error < 0 ? -error : error) - rttvar_us_) / 4;
+        srtt_us_ += error / 8;
+    }
+    int64_t timeout = srtt_us_ + 4 * rttvar_us_;
+    if (timeout < config_.min_timeout_us) {
+        timeout = config_.min_timeout_us;
+    }
+    if (timeout > config_.max_timeout_us) {
+        timeout = config_.max_timeout_us;
+    }
+    timeout_us_ = static_cast<uint32_t>(timeout);
+}
+
+
+bool transport_sender::poll_ack() {
+    u8 frame[NRF24::fifo_max_size];
+    bool applied = false;
+    while (u8 length = radio_.read_ack_payload(frame)) {
+        if (length < transport_frame::ack_size || (frame[0] & transport_frame::type_mask) != transport_frame::type_ack
+            || frame[1] != transfer_id_) {
+            continue; // stale ACK of an earlier transfer, or not transport traffic
+        }
+        const size_t cumulative = frame[2] | (frame[3] << 8);
+        const uint32_t selective = frame[4] | (frame[5] << 8) | (frame[6] << 16) | (static_cast<uint32_t>(frame[7]) << 24);
+        apply_ack(cumulative, selective, frame[0] & transport_frame::flag_complete);
+        stats_.acks++;
+        applied = true;
+    }
+    return applied;
+}
+
+
+Transfer_State transport_sender::pump() {
+    switch (state_) {
+        case Transfer_State::Sending:
+            send_burst();
+            break;
+
+        case Transfer_State::Waiting: {
+            if (poll_ack()) {
+                // Karn: a retransmitted burst gives no sample, its ACK may belong to the earlier copy
+                update_timeout(burst_retransmitted_ ? -1 : radio_.timing().now_us() - burst_done_us_);
+                consecutive_timeouts_ = 0;
+                if (base_ >= fragment_count_) {
+                    finish(Transfer_State::Complete);
+                } else {
+                    state_ = Transfer_State::Sending;
+                }
+                break;
+            }
+            if (radio_.timing().now_us() - burst_done_us_ < static_cast<int64_t>(timeout_us_)) {
+                break;
+            }
+            stats_.timeouts++;
+            if (++consecutive_timeouts_ > config_.max_timeouts) {
+                finish(Transfer_State::Failed);
+                break;
+            }
+            const uint32_t doubled = timeout_us_ * 2;
+            timeout_us_ = doubled < config_.max_timeout_us ? doubled : config_.max_timeout_us;
+            state_ = Transfer_State::Sending;
+            break;
+        }
+
+        default:
+            break;
+    }
+    return state_;
+}
+
+
+bool transport_sender::send(const u8* data, size_t length) {
+    if (!begin(data, length)) {
+        return false;
+    }
+    Transfer_State state = state_;
+    while (state != Transfer_State::Complete && state != Transfer_State::Failed) {
+        state = pump();
+        if (state == Transfer_State::Waiting) {
+            const radio_clock_T& clock = radio_.timing().clock();
+            clock.delay_us(ack_poll_interval_us, clock.context);
+        }
+    }
+    return state == Transfer_State::Complete;
+}
+
+
+transport_receiver::transport_receiver(NRF24& radio, u8* buffer, size_t capacity, uint32_t ack_delay_us) :
+    radio_(radio), buffer_(buffer), capacity_(buffer != nullptr ? capacity : 0), ack_delay_us_(ack_delay_us)
+{
+}
+
+
+void transport_receiver::start_transfer(u8 transfer_id) {
+    active_ = true;
+    finished_ = false;
+    transfer_id_ = transfer_id;
+    cumulative_ = 0;
+    received_ = 0;
+    fragment_count_ = 0;
+    length_ = 0;
+}
+
+
+bool transport_receiver::fits_transfer(size_t sequence, u8 flags) const {
+    const bool last = flags & transport_frame::flag_last;
+    if (fragment_count_ != 0) {
+        return sequence < fragment_count_ && last == (sequence + 1 == fragment_count_);
+    }
+    if (!last) {
+        return true;
+    }
+    // the last fragment cannot lie below a fragment that already arrived
+    return sequence >= cumulative_ && (sequence - cumulative_ >= 32 || shift_down(received_, sequence - cumulative_ + 1) == 0);
+}
+
+
+void transport_receiver::release() {
+    complete_ = false; // finished_ stays, so late duplicates of the released transfer are still acknowledged
+}
+
+
+bool transport_receiver::on_frame(const u8* frame, u8 length) {
+    if (frame == nullptr || length < transport_frame::header_size || (frame[0] & transport_frame::type_mask) != transport_frame::type_data) {
+        return false;
+    }
+    const u8 flags = frame[0];
+    const u8 transfer_id = frame[1];
+    const size_t sequence = frame[2] | (frame[3] << 8);
+    const u8 payload_length = frame[4];
+    if (payload_length > transport_frame::data_payload_size || transport_frame::header_size + payload_length > length) {
+        return false;
+    }
+
+    stats_.frames++;
+    const bool same_transfer = active_ && transfer_id == transfer_id_ && fits_transfer(sequence, flags);
+    if (finished_ && same_transfer) {
+        stats_.duplicates++; // the sender missed the final ACK, send it again
+        ack_pending_ = true;
+        return true;
+    }
+    if (complete_) {
+        return true; // the previous transfer is still held, the sender keeps retrying until release
+    }
+    if (!same_transfer) {
+        start_transfer(transfer_id);
+    }
+
+    last_frame_us_ = radio_.timing().now_us();
+    unacked_frames_ = true;
+    if (flags & transport_frame::flag_ack_request) {
+        ack_pending_ = true;
+    }
+
+    if (sequence < cumulative_ || (sequence - cumulative_ < 32 && (received_ & bit(sequence - cumulative_)))) {
+        stats_.duplicates++;
+        return true;
+    }
+    const size_t offset = sequence * transport_frame::data_payload_size;
+    if (sequence - cumulative_ >= 32 || offset + payload_length > capacity_) {
+        stats_.out_of_window++;
+        return true;
+    }
+
+    memcpy(buffer_ + offset, frame + transport_frame::header_size, payload_length);
+    if (flags & transport_frame::flag_last) {
+        fragment_count_ = sequence + 1;
+        length_ = offset + payload_length;
+    }
+    received_ |= bit(sequence - cumulative_);
+    while (received_ & 1) {
+        received_ >>= 1;
+        cumulative_++;
+    }
+
+    if (fragment_count_ != 0 && cumulative_ >= fragment_count_) {
+        finished_ = true;
+        complete_ = true;
+        ack_pending_ = true;
+        stats_.transfers++;
+    }
+    return true;
+}
+
+
+void transport_receiver::send_ack() {
+    ack_[0] = static_cast<u8>(transport_frame::type_ack | (finished_ ? transport_frame::flag_complete : 0));
+    ack_[1] = transfer_id_;
+    ack_[2] = static_cast<u8>(cumulative_);
+    ack_[3] = static_cast<u8>(cumulative_ >> 8);
+    ack_[4] = static_cast<u8>(received_);
+    ack_[5] = static_cast<u8>(received_ >> 8);
+    ack_[6] = static_cast<u8>(received_ >> 16);
+    ack_[7] = static_cast<u8>(received_ >> 24);
+
+    ack_pending_ = false;
+    unacked_frames_ = false;
+    if (!radio_.transmit_data(ack_.data(), static_cast<u8>(ack_.size()))) {
+        NRF_LOGW("[TRANSPORT_RECEIVER::poll] Failed sending ACK, the sender's timer will retry\n");
+        return;
+    }
+    stats_.acks_sent++;
+}
+
+
+void transport_receiver::poll() {
+    if (!active_) {
+        return;
+    }
+    if (ack_pending_ || (unacked_frames_ && radio_.timing().now_us() - last_frame_us_ >= static_cast<int64_t>(ack_delay_us_))) {
+        send_ack();
+    }
+}
@@ -0,0 +1,276 @@
+
+#pragma once
+
+#include "nRF24L01P.hpp"
+
+#include <array>
+
+
+/**
+ * @brief Frame layout shared by transport_sender and transport_receiver. Every frame starts with
+ *  [0] type | flags  [1] transfer id  [2..3] fragment sequence number, LSByte first
+ * Data frames follow with [4] payload length and up to data_payload_size bytes. ACK frames follow with
+ * [4..7] the selective ACK bitmap, bit i set when fragment (sequence + i) arrived, sequence being the cumulative
+ * ACK, the first fragment still missing.
+ */
+namespace transport_frame {
+    inline constexpr u8 header_size = 5;
+    inline constexpr u8 data_payload_size = NRF24::fifo_max_size - header_size;
+    inline constexpr u8 ack_size = 8;
+
+    inline constexpr u8 type_mask = 0x0F;
+    inline constexpr u8 type_data = 0x01;
+    inline constexpr u8 type_ack = 0x02;
+
+    inline constexpr u8 flag_last = 0x10;           // data: last fragment of the transfer
+    inline constexpr u8 flag_ack_request = 0x20;    // data: last frame of a burst, answer right away
+    inline constexpr u8 flag_complete = 0x40;       // ack: the whole transfer arrived
+
+    inline constexpr size_t max_fragments = 0xFFFF;
+    inline constexpr size_t max_transfer_size = max_fragments * data_payload_size;
+}
+
+
+/**
+ * @brief tuning of a transport_sender
+ */
+struct transport_config_T{
+    u8 window = 16;                         // fragments in flight, 1 - transport_sender::max_window
+    uint32_t initial_timeout_us = 20000;    // retransmit timer before the first round trip was measured
+    uint32_t min_timeout_us = 2000;
+    uint32_t max_timeout_us = 200000;       // exponential backoff stops here
+    u8 max_timeouts = 8;                    // consecutive timer expiries before the transfer fails
+};
+
+/**
+ * @brief running totals of a transport_sender
+ */
+struct transport_stats_T{
+    uint32_t frames_sent;
+    uint32_t retransmitted_frames;  // frames sent more than once
+    uint32_t bursts;                // transmit_stream calls
+    uint32_t acks;                  // transport ACK frames received
+    uint32_t timeouts;              // retransmit timer expiries
+    uint32_t bytes_delivered;
+    int64_t elapsed_us;             // begin to completion of the last transfer
+};
+
+/**
+ * @brief running totals of a transport_receiver
+ */
+struct transport_receiver_stats_T{
+    uint32_t frames;
+    uint32_t duplicates;            // fragments that had already arrived
+    uint32_t out_of_window;         // fragments too far ahead of the cumulative ACK, or past the buffer
+    uint32_t acks_sent;
+    uint32_t transfers;             // completed transfers
+};
+
+enum class Transfer_State {
+    Idle,
+    Sending,        // the next pump streams a burst
+    Waiting,        // a burst went out, waiting for its ACK or the retransmit timer
+    Complete,
+    Failed
+};
+
+
+/**
+ * @brief Sending half of a sliding window transport. begin splits a buffer into fragments of
+ * transport_frame::data_payload_size bytes, pump then streams every unacknowledged fragment of the window
+ * in one transmit_stream burst, so the TX FIFO stays full for the whole window, and waits for the receiver's
+ * ACK. The cumulative ACK slides the window, the selective ACK bitmap keeps fragments that arrived past a
+ * hole from being sent again. A burst that gets no ACK before the retransmit timer is sent again with the
+ * timer doubled. The timer follows the measured round trip (srtt + 4 rttvar, Karn's rule for retransmitted bursts).
+ *
+ * Transfer ids start from esp_random, so a sender that rebooted does not reuse the id of a transfer a receiver
+ * still holds.
+ *
+ * Works with auto-ack on or off, transport ACKs are what count. The radio must be free for the sender between
+ * pumps, transmit_stream cannot run alongside the IRQ receive mode.
+ */
+class transport_sender{
+    public:
+        static constexpr u8 max_window = 32;    // width of the selective ACK bitmap
+
+        transport_sender(NRF24& radio, const transport_config_T& config = {});
+
+        /**
+         * @brief starts a transfer, data must stay valid until it completes or fails
+         *
+         * @param data bytes to send
+         * @param length 1 - transport_frame::max_transfer_size
+         *
+         * @return bool - false on invalid arguments or while a transfer is in progress
+         */
+        bool begin(const u8* data, size_t length);
+
+        /**
+         * @brief advances the transfer by one step without blocking on the air for longer than a burst:
+         * streams a burst, or checks for an ACK and the retransmit timer. Call in a loop until Complete or Failed.
+         *
+         * @return Transfer_State - state after the step
+         */
+        Transfer_State pump();
+
+        /**
+         * @brief begin, then pump until the transfer completes or fails
+         *
+         * @return bool - true if the receiver acknowledged every byte
+         */
+        bool send(const u8* data, size_t length);
+
+        /**
+         * @brief abandons the current transfer, the receiver starts over on the next one
+         */
+        void cancel();
+
+        Transfer_State state() const { return state_; }
+        size_t acknowledged_bytes() const;
+        uint32_t timeout_us() const { return timeout_us_; }
+        const transport_stats_T& stats() const { return stats_; }
+        void reset_stats() { stats_ = {}; }
+
+    private:
+        NRF24& radio_;
+        transport_config_T config_;
+        transport_stats_T stats_ = {};
+        Transfer_State state_ = Transfer_State::Idle;
+
+        const u8* data_ = nullptr;
+        size_t length_ = 0;
+        size_t fragment_count_ = 0;
+        u8 transfer_id_ = 0;
+
+        size_t base_ = 0;                   // cumulative ACK, oldest fragment not acknowledged
+        uint32_t acked_ = 0;                // bit i: fragment base_ + i acknowledged selectively
+        uint32_t sent_ = 0;                 // bit i: fragment base_ + i has been sent before
+
+        int64_t started_us_ = 0;
+        int64_t burst_done_us_ = 0;
+        bool burst_retransmitted_ = false;
+        u8 consecutive_timeouts_ = 0;
+
+        uint32_t timeout_us_ = 0;
+        int64_t srtt_us_ = 0;               // 0 until the first sample
+        int64_t rttvar_us_ = 0;
+
+        std::array<std::array<u8, NRF24::fifo_max_size>, max_window> frames_ = {};
+        std::array<tx_packet_T, max_window> burst_ = {};
+
+        /**
+         * @brief builds and streams every unacknowledged fragment of the window
+         */
+        void send_burst();
+
+        /**
+         * @brief drains the RX FIFO for an ACK of this transfer
+         *
+         * @return bool - true if one was applied
+         */
+        bool poll_ack();
+
+        void apply_ack(size_t cumulative, uint32_t selective, bool complete);
+
+        /**
+         * @brief folds a round trip sample into the retransmit timer, a negative sample only undoes the backoff
+         */
+        void update_timeout(int64_t rtt_us);
+
+        void finish(Transfer_State state);
+};
+
+
+/**
+ * @brief Receiving half of the transport. Fragments are written straight to their offset in the caller's buffer,
+ * so they may arrive in any order within max_window of the cumulative ACK. An ACK frame goes back with
+ * transmit_data when a burst's last frame asks for one, or after ack_delay_us without frames when that frame was lost.
+ *
+ * Feed every received frame to on_frame and call poll regularly, both from one task, typically the consumer of the
+ * packet_ring the radio task drains into (start_irq_rx), so the 3-deep RX FIFO never overflows during a burst.
+ * A completed transfer is held until release, frames of the next one go unacknowledged until then.
+ */
+class transport_receiver{
+    public:
+        static constexpr uint32_t default_ack_delay_us = 3000;
+
+        transport_receiver(NRF24& radio, u8* buffer, size_t capacity, uint32_t ack_delay_us = default_ack_delay_us);
+
+        /**
+         * @brief handles one received frame, frames that are not transport data are ignored
+         *
+         * @return bool - true if the frame was transport data
+         */
+        bool on_frame(const u8* frame, u8 length);
+
+        /**
+         * @brief sends a pending or delayed ACK
+         */
+        void poll();
+
+        /**
+         * @brief pops and handles every frame waiting in ring, then polls
+         *
+         * @return size_t - frames popped
+         */
+        template <size_t Capacity>
+        size_t poll(packet_ring<Capacity>& ring){
+            rx_packet_T packets[8];
+            size_t total = 0;
+            size_t popped = 0;
+            while ((popped = ring.pop_batch(packets, sizeof(packets) / sizeof(packets[0]))) > 0) {
+                for (size_t i = 0; i < popped; ++i) {
+                    on_frame(packets[i].data.data(), packets[i].length);
+                }
+                total += popped;
+            }
+            poll();
+            return total;
+        }
+
+        bool complete() const { return complete_; }
+
+        /**
+         * @brief bytes of the completed transfer, 0 before completion
+         */
+        size_t length() const { return complete_ ? length_ : 0; }
+
+        /**
+         * @brief hands the buffer back for the next transfer
+         */
+        void release();
+
+        const transport_receiver_stats_T& stats() const { return stats_; }
+
+    private:
+        NRF24& radio_;
+        u8* buffer_;
+        const size_t capacity_;
+        const uint32_t ack_delay_us_;
+        transport_receiver_stats_T stats_ = {};
+
+        bool active_ = false;               // a transfer id has been seen
+        bool finished_ = false;             // every fragment of transfer_id_ arrived
+        bool complete_ = false;             // finished and not released yet
+        u8 transfer_id_ = 0;
+        size_t cumulative_ = 0;             // first fragment still missing
+        uint32_t received_ = 0;             // bit i: fragment cumulative_ + i arrived
+        size_t fragment_count_ = 0;         // 0 until the last fragment arrived
+        size_t length_ = 0;
+
+        bool ack_pending_ = false;          // a burst asked for an ACK
+        bool unacked_frames_ = false;       // frames arrived since the last ACK
+        int64_t last_frame_us_ = 0;
+
+        std::array<u8, transport_frame::ack_size> ack_ = {};
+
+        void start_transfer(u8 transfer_id);
+
+        /**
+         * @brief whether a fragment agrees with the fragment count seen so far of transfer_id_. A sender that
+         * restarted can come back with the id of the transfer held here, its fragments then start a new transfer.
+         */
+        bool fits_transfer(size_t sequence, u8 flags) const;
+
+        void send_ack();
+};
@@ -1,63 +1,143 @@
 #include "spi_object.hpp"
-#include <cstdio> // for printf
-
-spi_object::spi_object(){
-    printf("[SPI_OBJECT] Initializing SPI bus config\n");
-    spi_bus_config_t config = {};
-    config.mosi_io_num = 13;
-    config.miso_io_num = 12;
-    config.sclk_io_num = 14; 
+#include "nrf_log.hpp"
+
+extern "C" {
+    #include "esp_timer.h"
+}
+
+spi_bus::spi_bus(const spi_config_T& settings) : host_(settings.host) {
+    NRF_LOGD("[SPI_BUS] Initializing SPI bus config\n");
+    config = {};
+    config.mosi_io_num = settings.mosi_pin;
+    config.miso_io_num = settings.miso_pin;
+    config.sclk_io_num = settings.sclk_pin;
     config.quadwp_io_num = -1;
     config.quadhd_io_num = -1;
     config.data_io_default_level = false;
-    config.max_transfer_sz = 60; 
+    config.max_transfer_sz = settings.max_transfer_size;
     config.isr_cpu_id = ESP_INTR_CPU_AFFINITY_AUTO;
 
-    printf("[SPI_OBJECT] Calling spi_bus_initialize...\n");
-    esp_err_t bus_init_result = spi_bus_initialize(SPI2_HOST, &config, SPI_DMA_CH_AUTO);
+    NRF_LOGD("[SPI_BUS] Calling spi_bus_initialize on host %d...\n", host_);
+    esp_err_t bus_init_result = spi_bus_initialize(host_, &config, SPI_DMA_CH_AUTO);
     if (bus_init_result != ESP_OK) {
-        printf("❌ spi_bus_initialize failed with error: %d\n", bus_init_result);
+        NRF_LOGE("❌ spi_bus_initialize failed with error: %d\n", bus_init_result);
     } else {
-        printf("✅ spi_bus_initialize successful\n");
+        NRF_LOGD("✅ spi_bus_initialize successful\n");
+        initialized_ = true;
+    }
+}
+
+spi_bus::~spi_bus() {
+    if (initialized_) {
+        esp_err_t free_result = spi_bus_free(host_);
+        if (free_result != ESP_OK) {
+            NRF_LOGE("❌ spi_bus_free failed with error: %d, devices still attached?\n", free_result);
+        }
     }
+}
+
+
+spi_object::spi_object(const spi_config_T& settings) :
+    owned_bus_(new spi_bus(settings)), bus_(owned_bus_.get()), settings_(settings)
+{
+    add_device();
+}
 
-    printf("[SPI_OBJECT] Configuring SPI device interface\n");
-    spi_device_interface_config_t device_config = {};
+spi_object::spi_object(spi_bus& bus, const spi_config_T& settings) :
+    bus_(&bus), settings_(settings)
+{
+    settings_.host = bus.host();
+    add_device();
+}
+
+void spi_object::add_device() {
+    NRF_LOGD("[SPI_OBJECT] Configuring SPI device interface\n");
+    spi_device_interface_config_t& device_config = device_config_;
     device_config.command_bits = 0;
     device_config.address_bits = 0;
     device_config.dummy_bits = 0;
-    device_config.mode = 1;
+    device_config.mode = settings_.mode;
     device_config.clock_source = SPI_CLK_SRC_DEFAULT;
     device_config.duty_cycle_pos = 0;
-    device_config.clock_speed_hz = 1 * 1000 * 1000;
+    device_config.clock_speed_hz = settings_.clock_speed_hz;
     device_config.input_delay_ns = 0;
-    device_config.spics_io_num = 5;
-    device_config.queue_size = 10;
+    device_config.spics_io_num = settings_.csn_pin;
+    device_config.queue_size = max_queued_transfers;
     device_config.pre_cb = nullptr;
     device_config.post_cb = nullptr;
     device_config.flags = SPI_DEVICE_NO_DUMMY;
 
     // TODO: Annotate
-    spi_mutex_ = xSemaphoreCreateMutex();
+    // recursive so a task holding the bus for a burst can keep calling send_data
+    spi_mutex_ = xSemaphoreCreateRecursiveMutex();
     configASSERT(spi_mutex_); // crash early if creation failed
 
     device_handle_ = nullptr;
+    if (!bus_->initialized()) {
+        NRF_LOGE("❌ SPI bus on host %d is not initialized, device on CSN %d not added\n", settings_.host, settings_.csn_pin);
+        return;
+    }
 
-    printf("[SPI_OBJECT] Adding SPI device...\n");
-    esp_err_t add_device_result = spi_bus_add_device(SPI2_HOST, &device_config, &device_handle_);
+    NRF_LOGD("[SPI_OBJECT] Adding SPI device...\n");
+    esp_err_t add_device_result = spi_bus_add_device(settings_.host, &device_config, &device_handle_);
     if (add_device_result != ESP_OK) {
-        printf("❌ spi_bus_add_device failed with error: %d\n", add_device_result);
+        NRF_LOGE("❌ spi_bus_add_device failed with error: %d\n", add_device_result);
+        device_handle_ = nullptr;
     } else {
-        printf("✅ spi_bus_add_device successful, device handle acquired\n");
+        NRF_LOGD("✅ spi_bus_add_device successful, device handle acquired (CSN %d, %d Hz, mode %d)\n", settings_.csn_pin, settings_.clock_speed_hz, settings_.mode);
     }
 }
 
 spi_object::~spi_object() {
+    if (device_handle_) {
+        spi_bus_remove_device(device_handle_); // before an owned bus is freed
+        device_handle_ = nullptr;
+    }
     if (spi_mutex_) {
         vSemaphoreDelete(spi_mutex_);
         spi_mutex_ = nullptr;
     }
-    // cleanup spi handle if needed
+}
+
+
+esp_err_t spi_object::set_clock_speed(int clock_speed_hz) {
+    configASSERT(spi_mutex_ != nullptr);
+    configASSERT(!xPortInIsrContext());
+
+    if (clock_speed_hz <= 0) return ESP_ERR_INVALID_ARG;
+
+    if (xSemaphoreTakeRecursive(spi_mutex_, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        NRF_LOGE("timeout taking SPI mutex\n");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_err_t result = ESP_OK;
+    do {
+        if (!device_handle_) { result = ESP_ERR_INVALID_STATE; break; }
+        if (in_flight_ > 0 || bus_acquire_depth_ > 0) { result = ESP_ERR_INVALID_STATE; break; }
+        if (clock_speed_hz == settings_.clock_speed_hz) break;
+
+        result = spi_bus_remove_device(device_handle_);
+        if (result != ESP_OK) break;
+        device_handle_ = nullptr;
+
+        const int previous_hz = settings_.clock_speed_hz;
+        device_config_.clock_speed_hz = clock_speed_hz;
+        result = spi_bus_add_device(settings_.host, &device_config_, &device_handle_);
+        if (result == ESP_OK) {
+            settings_.clock_speed_hz = clock_speed_hz;
+            break;
+        }
+
+        NRF_LOGE("❌ spi_bus_add_device at %d Hz failed: 0x%x\n", clock_speed_hz, result);
+        device_config_.clock_speed_hz = previous_hz;
+        if (spi_bus_add_device(settings_.host, &device_config_, &device_handle_) != ESP_OK) {
+            device_handle_ = nullptr;
+        }
+    } while (0);
+
+    xSemaphoreGiveRecursive(spi_mutex_);
+    return result;
 }
 
 
@@ -68,8 +148,8 @@ esp_err_t spi_object::send_data(size_t data_size, const uint8_t* tx_data, uint8_
     if (data_size == 0) return ESP_ERR_INVALID_SIZE;
 
     // Take mutex (1s timeout)
-    if (xSemaphoreTake(spi_mutex_, pdMS_TO_TICKS(1000)) != pdTRUE) {
-        printf("timeout taking SPI mutex\n");
+    if (xSemaphoreTakeRecursive(spi_mutex_, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        NRF_LOGE("timeout taking SPI mutex\n");
         return ESP_ERR_TIMEOUT;
     }
 
@@ -83,13 +163,131 @@ esp_err_t spi_object::send_data(size_t data_size, const uint8_t* tx_data, uint8_
         t.rx_buffer = rx_data;         // may be nullptr
         // no manual CS toggling; driver will assert/deassert CS
 
-        result = spi_device_transmit(device_handle_, &t);
+        const bool poll = low_latency_ && data_size <= polling_size_limit_;
+        const int64_t started_us = esp_timer_get_time();
+        result = poll ? spi_device_polling_transmit(device_handle_, &t)
+                      : spi_device_transmit(device_handle_, &t);
+        if (result == ESP_OK) {
+            stats_.transactions++;
+            stats_.bytes += data_size;
+            stats_.busy_us += esp_timer_get_time() - started_us;
+            if (poll) stats_.polled_transactions++;
+        }
     } while (0);
 
-    xSemaphoreGive(spi_mutex_);
+    xSemaphoreGiveRecursive(spi_mutex_);
+
+    if (result != ESP_OK) {
+        NRF_LOGE("❌ spi_device_transmit failed: 0x%x\n", result);
+    }
+    return result;
+}
+
+
+esp_err_t spi_object::queue_data(const spi_transfer_T* transfers, size_t count) {
+    configASSERT(spi_mutex_ != nullptr);
+    configASSERT(!xPortInIsrContext());
+
+    if (transfers == nullptr || count == 0 || count > max_queued_transfers) return ESP_ERR_INVALID_SIZE;
+
+    if (xSemaphoreTakeRecursive(spi_mutex_, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        NRF_LOGE("timeout taking SPI mutex\n");
+        return ESP_ERR_TIMEOUT;
+    }
+    if (!device_handle_) {
+        xSemaphoreGiveRecursive(spi_mutex_);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t result = ESP_OK;
+    in_flight_ = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (transfers[i].data_size == 0) { result = ESP_ERR_INVALID_SIZE; break; }
+
+        spi_transaction_t& t = queued_[i];
+        t = {};
+        t.length    = transfers[i].data_size * 8;   // bits
+        t.tx_buffer = transfers[i].tx_data;
+        t.rx_buffer = transfers[i].rx_data;
+
+        result = spi_device_queue_trans(device_handle_, &t, portMAX_DELAY);
+        if (result != ESP_OK) break;
+
+        in_flight_++;
+        stats_.transactions++;
+        stats_.bytes += transfers[i].data_size;
+    }
 
     if (result != ESP_OK) {
-        printf("❌ spi_device_transmit failed: 0x%x\n", result);
+        NRF_LOGE("❌ spi_device_queue_trans failed: 0x%x\n", result);
+        collect_results(); // drain what made it into the queue before the buffers go out of scope
     }
     return result;
 }
+
+
+esp_err_t spi_object::collect_results() {
+    esp_err_t result = ESP_OK;
+    while (in_flight_ > 0) {
+        spi_transaction_t* completed = nullptr;
+        result = spi_device_get_trans_result(device_handle_, &completed, pdMS_TO_TICKS(1000));
+        if (result != ESP_OK) {
+            NRF_LOGE("❌ spi_device_get_trans_result failed: 0x%x\n", result);
+            break;
+        }
+        in_flight_--;
+    }
+
+    xSemaphoreGiveRecursive(spi_mutex_);
+    return result;
+}
+
+
+esp_err_t spi_object::send_batch(const spi_transfer_T* transfers, size_t count) {
+    esp_err_t result = queue_data(transfers, count);
+    if (result != ESP_OK) return result;
+    return collect_results();
+}
+
+
+void spi_object::set_low_latency(bool enabled, size_t polling_size_limit) {
+    low_latency_ = enabled;
+    polling_size_limit_ = polling_size_limit;
+}
+
+
+esp_err_t spi_object::acquire_bus() {
+    configASSERT(spi_mutex_ != nullptr);
+    configASSERT(!xPortInIsrContext());
+
+    if (xSemaphoreTakeRecursive(spi_mutex_, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        NRF_LOGE("timeout taking SPI mutex\n");
+        return ESP_ERR_TIMEOUT;
+    }
+    if (!device_handle_) {
+        xSemaphoreGiveRecursive(spi_mutex_);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (bus_acquire_depth_ == 0) {
+        esp_err_t result = spi_device_acquire_bus(device_handle_, portMAX_DELAY);
+        if (result != ESP_OK) {
+            NRF_LOGE("❌ spi_device_acquire_bus failed: 0x%x\n", result);
+            xSemaphoreGiveRecursive(spi_mutex_);
+            return result;
+        }
+    }
+    bus_acquire_depth_++;
+    return ESP_OK; // mutex stays held until release_bus
+}
+
+
+void spi_object::release_bus() {
+    if (bus_acquire_depth_ == 0) return;
+
+    bus_acquire_depth_--;
+    if (bus_acquire_depth_ == 0) {
+        spi_device_release_bus(device_handle_);
+    }
+    xSemaphoreGiveRecursive(spi_mutex_);
+}
@@ -1,9 +1,12 @@
 
 #pragma once
 
+#include <memory>
 
 extern "C" {
     #include <stdint.h>
+    #include "freertos/FreeRTOS.h"
+    #include "freertos/semphr.h"
     #include "driver/spi_master.h"
     #include "driver/gpio.h"
 
@@ -11,20 +14,204 @@ extern "C" {
 using u8 = uint8_t;
 
 
-class spi_object{
+/**
+ * @brief bus and device settings for spi_object, the defaults are the original wiring at 1 MHz.
+ * When the device is added to a shared spi_bus only csn_pin, clock_speed_hz, mode and calibrate_clock are used.
+ */
+struct spi_config_T{
+    spi_host_device_t host = SPI2_HOST;
+    int mosi_pin = 13;
+    int miso_pin = 12;
+    int sclk_pin = 14;
+    int csn_pin = 5;
+    int clock_speed_hz = 1 * 1000 * 1000;
+    u8 mode = 1;
+    int max_transfer_size = 64;     // longest single transfer, a payload command is 33 bytes
+    bool calibrate_clock = false;   // NRF24 runs calibrate_spi_clock with the default steps right after its setup
+};
+
+
+/**
+ * @brief running totals of what has been put on the wire, snapshot before and after a driver call to cost it
+ */
+struct spi_stats_T{
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t polled_transactions;   // issued with spi_device_polling_transmit
+    uint64_t busy_us;               // time spent inside send_data transfers, divide by transactions for per-command latency
+};
+
+
+/**
+ * @brief one transfer inside a queued batch, buffers must stay valid until the batch is collected
+ */
+struct spi_transfer_T{
+    size_t data_size;
+    const u8* tx_data;
+    u8* rx_data;
+};
+
+
+/**
+ * @brief Owns one SPI host (SPI2_HOST or SPI3_HOST) and its MOSI/MISO/SCLK pins. Any number of spi_objects,
+ * each with its own CSN, can be added to it. ESP-IDF arbitrates the bus per transaction, so one radio's
+ * transfers go out while another radio is on air. Must outlive every spi_object added to it.
+ */
+class spi_bus{
     private:
-    SemaphoreHandle_t spi_mutex_;   // guard for all SPI access
+    spi_host_device_t host_;
+    bool initialized_ = false;
 
     public:
     spi_bus_config_t config;
+
+    /**
+     * @param settings host, data pins and max_transfer_size are used, the device fields are ignored
+     */
+    explicit spi_bus(const spi_config_T& settings = {});
+    ~spi_bus();
+
+    spi_bus(const spi_bus&) = delete;
+    spi_bus& operator=(const spi_bus&) = delete;
+
+    spi_host_device_t host() const { return host_; }
+    bool initialized() const { return initialized_; }
+};
+
+
+class spi_object{
+    public:
+    /**
+     * @brief most transfers that can be in flight at once, matches the device queue_size
+     */
+    static constexpr size_t max_queued_transfers = 10;
+
+    private:
+    std::unique_ptr<spi_bus> owned_bus_;    // only set when this object created its own bus
+    spi_bus* bus_;
+
+    SemaphoreHandle_t spi_mutex_;   // guard for all SPI access to this device
+    spi_config_T settings_;
+    spi_device_interface_config_t device_config_ = {};
+    spi_stats_T stats_ = {};
+
+    spi_transaction_t queued_[max_queued_transfers] = {};  // descriptors must outlive the queue
+    size_t in_flight_ = 0;
+
+    bool low_latency_ = false;
+    size_t polling_size_limit_ = 32;
+    u8 bus_acquire_depth_ = 0;
+
+    /**
+     * @brief adds the device described by settings_ to bus_
+     */
+    void add_device();
+
+    public:
     spi_device_handle_t device_handle_;
 
 
-    spi_object();
+    /**
+     * @brief Creates a bus from settings and adds a single device to it, the original one radio setup.
+     * A second spi_object on the same host must use the spi_bus constructor instead.
+     */
+    explicit spi_object(const spi_config_T& settings = {});
+
+    /**
+     * @brief Adds a device to a bus shared with other radios
+     * 
+     * @param bus initialised bus, must outlive this object
+     * @param settings csn_pin, clock_speed_hz and mode of this device
+     */
+    spi_object(spi_bus& bus, const spi_config_T& settings);
     ~spi_object();
 
+    spi_object(const spi_object&) = delete;
+    spi_object& operator=(const spi_object&) = delete;
+
+    spi_bus& bus() const { return *bus_; }
+
+    const spi_config_T& settings() const { return settings_; }
+    int clock_speed_hz() const { return settings_.clock_speed_hz; }
+
+    /**
+     * @brief Re-adds the device at a new SCLK rate, ESP-IDF fixes the clock when the device is added.
+     * Must not be called while a batch is in flight or the bus is held.
+     * 
+     * @param clock_speed_hz new SCLK rate
+     * 
+     * @return esp_err_t - ESP_OK if the device runs at the new rate, on failure the previous rate is restored
+     */
+    esp_err_t set_clock_speed(int clock_speed_hz);
+
 
     esp_err_t send_data(size_t data_size, const u8* tx_data, u8* rx_data = nullptr);
 
+    /**
+     * @brief Queues a batch of transfers with spi_device_queue_trans and returns without waiting, so the
+     * caller can prepare the next packet while DMA runs. The SPI mutex stays held until collect_results,
+     * which must be called from the same task.
+     * 
+     * @param transfers transfers to clock out back to back, in order
+     * @param count number of transfers, at most max_queued_transfers
+     * 
+     * @return esp_err_t - ESP_OK if every transfer was queued, on failure nothing is left in flight and the mutex is released
+     */
+    esp_err_t queue_data(const spi_transfer_T* transfers, size_t count);
+
+    /**
+     * @brief Waits for every transfer queued by queue_data and releases the SPI mutex
+     * 
+     * @return esp_err_t - ESP_OK once all rx buffers are filled
+     */
+    esp_err_t collect_results();
+
+    /**
+     * @brief queue_data followed by collect_results, for blocks of commands with no work to overlap
+     */
+    esp_err_t send_batch(const spi_transfer_T* transfers, size_t count);
+
+    /**
+     * @brief Low latency mode sends short transfers with spi_device_polling_transmit, skipping the interrupt
+     * and DMA setup that costs more than a 1-6 byte command. Longer transfers keep using the interrupt path.
+     * 
+     * @param enabled true to poll short transfers
+     * @param polling_size_limit largest transfer in bytes that is polled, the default leaves 33-byte payload transfers on DMA
+     */
+    void set_low_latency(bool enabled, size_t polling_size_limit = 32);
+    bool low_latency() const { return low_latency_; }
+
+    /**
+     * @brief Takes the SPI mutex and holds the bus with spi_device_acquire_bus so a burst of commands from
+     * this task goes out without re-arbitrating the bus. Nests, every call needs a matching release_bus.
+     * Other devices on the bus wait while it is held, keep bursts short.
+     * 
+     * @return esp_err_t - ESP_OK if the bus is held
+     */
+    esp_err_t acquire_bus();
+    void release_bus();
+
+    const spi_stats_T& stats() const { return stats_; }
+    void reset_stats() { stats_ = {}; }
+
+
+};
+
+
+/**
+ * @brief holds the bus of an spi_object for the lifetime of the object, for bursts of short commands
+ */
+class spi_burst{
+    private:
+    spi_object& spi_;
+    const bool acquired_;
+
+    public:
+    explicit spi_burst(spi_object& spi) : spi_(spi), acquired_(spi.acquire_bus() == ESP_OK) {}
+    ~spi_burst() { if (acquired_) spi_.release_bus(); }
+
+    spi_burst(const spi_burst&) = delete;
+    spi_burst& operator=(const spi_burst&) = delete;
 
-};
\ No newline at end of file
+    bool acquired() const { return acquired_; }
+};
@@ -0,0 +1,54 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+/**
+ * Spectrum scan with a raw radio jamming one channel: the histogram counts the jammer on its channel only, the channel
+ * pickers steer clear of it and its neighbours, and the radio is back on its working channel, with the shadow cache
+ * agreeing with RF_CH.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio jammer(medium, -1, -1);
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    NRF_CHECK(radio.channel() == 2);
+
+    constexpr u8 jammed = 40;
+    constexpr uint16_t sweeps = NRF24::default_scan_sweeps;
+    start_jammer(jammer, jammed);
+    NRF_CHECK(radio.scan_channels());
+
+    const channel_scan_T& scan = radio.last_channel_scan();
+    radio.dump_channel_scan();
+    NRF_CHECK(scan.sweeps == sweeps);
+    NRF_CHECK(scan.busy[jammed] == sweeps);
+    for (u8 channel = 0; channel < 126; ++channel) {
+        NRF_CHECK(channel == jammed || scan.busy[channel] == 0);
+    }
+    NRF_CHECK(scan.elapsed_us > 0 && scan.elapsed_us < 1000 * 1000);
+
+    // inside a range around the jammer only the channels two away score zero
+    const u8 quiet = radio.quietest_channel(jammed - 2, jammed + 2);
+    NRF_CHECK(quiet == jammed - 2 || quiet == jammed + 2);
+    u8 picked[8] = {};
+    const size_t count = radio.quietest_channels(picked, 8, 2, jammed - 10, jammed + 10);
+    NRF_CHECK(count == 8);
+    for (size_t i = 0; i < count; ++i) {
+        NRF_CHECK(picked[i] < jammed - 1 || picked[i] > jammed + 1);
+    }
+    NRF_CHECK(radio.quietest_channel(jammed, jammed) == jammed); // nothing better in range, still answers
+
+    // the scan wrote RF_CH around the shadow cache, both agree on the working channel
+    NRF_CHECK(radio.channel() == 2 && dut.reg(0x05) == 2);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+    NRF_CHECK(radio.verify());
+    NRF_CHECK(radio.set_channel(quiet));
+    NRF_CHECK(radio.channel() == quiet && dut.reg(0x05) == quiet);
+    NRF_CHECK(radio.verify());
+
+    std::puts("test_channel_scan passed");
+    return 0;
+}
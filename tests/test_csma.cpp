@@ -0,0 +1,45 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+/**
+ * Listen-before-talk against a jammed and a clear channel: a packet that never finds the channel free fails without
+ * leaving the node deaf, and a clear channel costs one listen.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer(medium, 99, 17, 18);
+    nrf_emu::radio jammer(medium, -1, -1);
+    configure_peer(peer, true);
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    csma_config_T csma;
+    csma.enabled = true; // transmit_when_exhausted stays off, a busy channel fails the packet
+    radio.set_csma(csma);
+
+    u8 message[32] = { 7, 8, 9 };
+
+    // every listen hears the jammer, the packet is dropped and the radio goes back to listening
+    start_jammer(jammer, 2);
+    NRF_CHECK(!radio.transmit_data(message, 3));
+    NRF_CHECK(radio.csma_stats().access_failures == 1);
+    NRF_CHECK(radio.csma_stats().deferrals == csma.max_attempts);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+    NRF_CHECK(dut.state() == nrf_emu::radio_state::Rx || dut.state() == nrf_emu::radio_state::RxSettling);
+    NRF_CHECK(dut.counters().frames_sent == 0);
+    NRF_CHECK(dut.tx_fifo_count() == 0);
+
+    // the jammer stops, the first listen finds the channel clear
+    set_ce(jammer, false);
+    esp_host::advance_us(2000);
+    NRF_CHECK(radio.transmit_data(message, 3));
+    NRF_CHECK(radio.csma_stats().clear_first == 1);
+    NRF_CHECK(peer.rx_fifo_count() == 1 && peer_receive(peer)[0] == 7);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+
+    NRF_CHECK(radio.verify());
+    std::puts("test_csma passed");
+    return 0;
+}
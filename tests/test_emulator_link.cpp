@@ -0,0 +1,89 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+/**
+ * The driver against one raw emulated peer: transmit_data and rx_process end to end, the SPI cost of a
+ * transmit as both spi_object and the emulator count it, frames lost on the air and transmits that fail.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer(medium, 99, 17, 18);
+    configure_peer(peer, true);
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+
+    // driver -> peer
+    u8 message[32] = {1, 2, 3, 4, 5};
+    spi.reset_stats();
+    dut.reset_counters();
+    NRF_CHECK(radio.transmit_data(message, 5));
+    NRF_CHECK(peer.rx_fifo_count() == 1);
+    const std::vector<u8> received = peer_receive(peer);
+    NRF_CHECK(received[0] == 1 && received[4] == 5);
+
+    // both ends of the wire agree on the cost, and the breakdown shows the payload went out once
+    NRF_CHECK(spi.stats().transactions == dut.spi_counters().transactions);
+    NRF_CHECK(spi.stats().bytes == dut.spi_counters().bytes);
+    const size_t payload_command = static_cast<size_t>(nrf_emu::command_kind::W_TX_PAYLOAD);
+    NRF_CHECK(dut.spi_counters().transactions_by_command[payload_command] == 1);
+    NRF_CHECK(dut.spi_counters().bytes_by_command[payload_command] == 33);
+    NRF_CHECK(dut.counters().frames_sent == 1);
+
+    // peer -> driver
+    set_ce(peer, false);
+    command(peer, {0x20, 0x02});
+    peer_send(peer, {9, 8, 7, 6, 5, 4, 3, 2, 1});
+    u8 buffer[32] = {};
+    NRF_CHECK(radio.rx_process(buffer) == 32);
+    NRF_CHECK(buffer[0] == 9 && buffer[8] == 1);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+
+    // nothing survives a lossy air at probability 1
+    medium.set_config({ 1.0, 0, 7 });
+    peer_send(peer, {42});
+    NRF_CHECK(dut.rx_fifo_count() == 0);
+    NRF_CHECK(medium.counters().losses >= 1);
+    medium.set_config({});
+
+    // an oversized payload is turned down before the radio leaves RX
+    spi.reset_stats();
+    NRF_CHECK(!radio.transmit_data(message, 33));
+    NRF_CHECK(spi.stats().transactions == 0);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+
+    // the first no-ack packet sets EN_DYN_ACK before the transmit starts, the radio still ends up back in RX
+    command(peer, {0x20, 0x03});
+    set_ce(peer, true);
+    esp_host::advance_us(200);
+    NRF_CHECK((dut.reg(0x1D) & 0x01) == 0);
+    NRF_CHECK(radio.transmit_data(message, 5, true));
+    NRF_CHECK((dut.reg(0x1D) & 0x01) == 0x01);
+    NRF_CHECK(peer_receive(peer)[0] == 1);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+
+    // with auto-ack and nobody answering the packet ends in MAX_RT, which is a failure and leaves no payload behind
+    pipe_config_T pipe;
+    pipe.address = { 0x03, 0x03, 0x03 };
+    pipe.auto_ack = true;
+    NRF_CHECK(radio.configure_pipe(0, pipe));
+    medium.set_config({ 1.0, 0, 7 });
+    dut.reset_counters();
+    NRF_CHECK(!radio.transmit_data(message, 5));
+    NRF_CHECK(dut.counters().max_rt_events == 1);
+    NRF_CHECK(dut.tx_fifo_count() == 0);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+    medium.set_config({});
+
+    // a switch to the mode the radio is already in costs no SPI
+    spi.reset_stats();
+    NRF_CHECK(radio.switch_to_recieve());
+    NRF_CHECK(spi.stats().transactions == 0);
+
+    NRF_CHECK(radio.verify());
+    std::puts("test_emulator_link passed");
+    return 0;
+}
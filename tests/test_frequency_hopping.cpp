@@ -0,0 +1,126 @@
+#include "test_support.hpp"
+#include "virtual_scheduler.hpp"
+#include "frequency_hopper.hpp"
+
+#include <atomic>
+#include <set>
+
+using namespace nrf_test;
+
+namespace {
+    constexpr size_t packet_count = 150;
+    constexpr int rx_csn = 15;
+    constexpr int rx_ce = 25;
+    constexpr int rx_irq = 17;
+    constexpr u8 hop_channels[] = { 10, 20, 30, 40, 50, 60 };
+
+    struct link_result_T{
+        std::set<size_t> delivered;     // packets the transmitter saw acknowledged
+        std::set<size_t> received;      // packets the receiver read
+    };
+
+    /**
+     * @brief transmitter and receiver each on their own thread, both running a frequency_hopper over hop_channels,
+     * or both parked on fixed_channel when it is not 0
+     */
+    link_result_T run_link(NRF24& transmitter, NRF24& receiver, virtual_scheduler& scheduler, frequency_hopper& tx_hopper,
+                           frequency_hopper& rx_hopper, u8 fixed_channel, size_t packets){
+        link_result_T result;
+        std::atomic<bool> finished{false};
+        if (fixed_channel != 0) {
+            NRF_CHECK(transmitter.set_channel(fixed_channel) && receiver.set_channel(fixed_channel));
+        } else {
+            NRF_CHECK(tx_hopper.start() && rx_hopper.start());
+        }
+        NRF_CHECK(receiver.switch_to_recieve());
+
+        auto transmit_task = [&]{
+            u8 payload[32] = {};
+            u8 reply[32] = {};
+            u8 reply_length = 0;
+            for (size_t i = 0; i < packets; ++i) {
+                payload[0] = static_cast<u8>(i);
+                const bool acknowledged = fixed_channel != 0
+                    ? transmitter.transmit_request(payload, sizeof(payload), reply, reply_length)
+                    : tx_hopper.transmit(payload, sizeof(payload));
+                if (acknowledged) {
+                    result.delivered.insert(i);
+                }
+            }
+            finished = true;
+        };
+        auto receive_task = [&]{
+            const radio_clock_T clock = receiver.timing().clock();
+            u8 buffer[32] = {};
+            while (!finished) {
+                if (receiver.rx_process(buffer) != 0) {
+                    result.received.insert(buffer[0]);
+                    if (fixed_channel == 0) rx_hopper.on_packet();
+                } else if (fixed_channel == 0) {
+                    rx_hopper.poll();
+                }
+                clock.delay_us(50, clock.context);
+            }
+        };
+        scheduler.run({ transmit_task, receive_task });
+        return result;
+    }
+}
+
+/**
+ * Two drivers hopping together over six channels while a raw radio jams one of them. The hoppers lose each other
+ * on the jammed channel and find each other again, so the link keeps delivering, where a link parked on that
+ * channel delivers nothing.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio tx_radio(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio rx_radio(medium, rx_csn, rx_ce, rx_irq);
+    nrf_emu::radio jammer(medium, -1, -1);
+
+    virtual_scheduler scheduler;
+    spi_bus bus;
+    spi_config_T tx_device;
+    spi_config_T rx_device;
+    rx_device.csn_pin = rx_csn;
+    spi_object tx_spi(bus, tx_device);
+    spi_object rx_spi(bus, rx_device);
+    NRF24 transmitter(tx_spi, dut_pins(), 32, scheduler.clock());
+    NRF24 receiver(rx_spi, { static_cast<gpio_num_t>(rx_ce), static_cast<gpio_num_t>(rx_csn), GPIO_NUM_14, GPIO_NUM_12,
+        GPIO_NUM_13, static_cast<gpio_num_t>(rx_irq) }, 32, scheduler.clock());
+    NRF_CHECK(transmitter.set_ack_payloads(true) && receiver.set_ack_payloads(true));
+
+    hop_config_T config;
+    config.channels = hop_channels;
+    config.channel_count = sizeof(hop_channels);
+    config.packets_per_hop = 5;
+    hop_timing_T timing;
+    timing.silence_us = 20 * 1000;
+    frequency_hopper tx_hopper(transmitter, config, timing);
+    frequency_hopper rx_hopper(receiver, config, timing);
+
+    // the third channel of the shared sequence is jammed, the link meets it every sixth hop
+    const u8 jammed = tx_hopper.sequence()[2];
+    start_jammer(jammer, jammed);
+
+    // parked on the jammed channel nothing gets through
+    const link_result_T parked = run_link(transmitter, receiver, scheduler, tx_hopper, rx_hopper, jammed, 20);
+    NRF_CHECK(parked.delivered.size() <= 2);
+
+    // hopping, every visit to the jammed channel costs a resync but the link keeps going
+    const link_result_T hopping = run_link(transmitter, receiver, scheduler, tx_hopper, rx_hopper, 0, packet_count);
+    std::printf("hopping: %zu/%zu delivered, %u hops, %u sync losses, %u resyncs, %u receiver silence hops, %u failed\n",
+        hopping.delivered.size(), packet_count, tx_hopper.stats().hops, tx_hopper.stats().sync_losses,
+        tx_hopper.stats().resyncs, rx_hopper.stats().silence_hops, tx_hopper.stats().failed);
+    NRF_CHECK(hopping.delivered.size() >= packet_count * 9 / 10);
+    for (size_t index : hopping.delivered) {
+        NRF_CHECK(hopping.received.count(index) == 1);
+    }
+    NRF_CHECK(tx_hopper.stats().sync_losses >= 2);
+    NRF_CHECK(tx_hopper.stats().resyncs >= 2);
+    NRF_CHECK(rx_hopper.stats().silence_hops >= 2);
+    NRF_CHECK(tx_hopper.stats().hops >= packet_count / config.packets_per_hop / 2);
+
+    std::puts("test_frequency_hopping passed");
+    return 0;
+}
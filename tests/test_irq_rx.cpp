@@ -0,0 +1,72 @@
+#include "test_support.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace nrf_test;
+
+namespace {
+    std::atomic<int> delivered{0};
+    std::atomic<int> last_first_byte{0};
+
+    void on_packet(const u8* data, u8 length, void*){
+        if (length == 32) {
+            last_first_byte = data[0];
+            delivered++;
+        }
+    }
+
+    // the radio task runs on a real thread, give it wall time to drain
+    bool wait_for(int count){
+        for (int i = 0; i < 500 && delivered.load() < count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return delivered.load() >= count;
+    }
+}
+
+/**
+ * start_irq_rx on the emulator's simulated IRQ line: every frame pulls the line low, the ISR wakes the radio task,
+ * the task drains the FIFO into the callback and releases the line. With the air quiet the driver issues no SPI.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer(medium, 99, 17, 18);
+    configure_peer(peer, false);
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    NRF_CHECK(radio.start_irq_rx(on_packet, nullptr));
+    NRF_CHECK(!dut.irq_asserted());
+
+    // start_irq_rx drains once for packets that beat the handler, after that a quiet air costs no SPI
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    spi.reset_stats();
+    esp_host::advance_us(50000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    NRF_CHECK(spi.stats().transactions == 0);
+
+    dut.reset_counters();
+    constexpr int packets = 5;
+    for (int i = 1; i <= packets; ++i) {
+        peer_send(peer, {static_cast<u8>(i)});
+        NRF_CHECK(wait_for(i));
+        NRF_CHECK(last_first_byte.load() == i);
+    }
+    NRF_CHECK(dut.counters().irq_edges == packets);
+    {
+        std::lock_guard<std::recursive_mutex> lock(esp_host::backend_lock());
+        NRF_CHECK(!dut.irq_asserted());
+        NRF_CHECK(dut.rx_fifo_count() == 0);
+    }
+
+    radio.stop_irq_rx();
+    peer_send(peer, {99});
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    NRF_CHECK(delivered.load() == packets);
+
+    std::puts("test_irq_rx passed");
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "test_support.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <new>
+
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+    void __libc_free(void* pointer);
+}
+
+namespace {
+    std::atomic<bool> counting{false};
+    std::atomic<uint32_t> allocations{0};
+
+    void note_allocation(){
+        if (counting.load(std::memory_order_relaxed)) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// every heap allocation in the process goes through these while the test counts
+extern "C" void* malloc(size_t size) { note_allocation(); return __libc_malloc(size); }
+extern "C" void* calloc(size_t count, size_t size) { note_allocation(); return __libc_calloc(count, size); }
+extern "C" void* realloc(void* pointer, size_t size) { note_allocation(); return __libc_realloc(pointer, size); }
+extern "C" void free(void* pointer) { __libc_free(pointer); }
+
+void* operator new(size_t size) { note_allocation(); void* p = __libc_malloc(size ? size : 1); if (!p) throw std::bad_alloc(); return p; }
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* pointer) noexcept { __libc_free(pointer); }
+void operator delete[](void* pointer) noexcept { __libc_free(pointer); }
+void operator delete(void* pointer, size_t) noexcept { __libc_free(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { __libc_free(pointer); }
+
+
+namespace {
+    /**
+     * @brief a register file behind the SPI shim that never allocates, so only the driver's own allocations count.
+     * STATUS always reads TX_DS with the RX FIFO empty, a transmit completes on its first poll.
+     */
+    class register_file_backend : public esp_host::backend_T{
+        public:
+            void on_spi_transfer(int, const uint8_t* tx, uint8_t* rx, size_t length) override{
+                constexpr uint8_t status = 0x2E;
+                if (rx != nullptr && length > 0) {
+                    std::memset(rx, 0, length);
+                    rx[0] = status;
+                }
+                if (length == 0) {
+                    return;
+                }
+                const uint8_t command = tx[0];
+                const uint8_t address = command & 0x1F;
+                const size_t data_length = length - 1 < 5 ? length - 1 : 5;
+                if (command < 0x20) {
+                    if (rx != nullptr) {
+                        std::memcpy(rx + 1, registers_[address], data_length);
+                    }
+                } else if (command < 0x40) {
+                    std::memcpy(registers_[address], tx + 1, data_length);
+                } else if (command == 0x60 && rx != nullptr && length > 1) {
+                    rx[1] = 32;     // R_RX_PL_WID
+                }
+            }
+            void on_gpio_write(int, int) override {}
+            int on_gpio_read(int) override { return -1; }
+            void on_time_advanced(int64_t) override {}
+
+        private:
+            uint8_t registers_[32][5] = {};
+    };
+}
+
+
+/**
+ * The register and packet paths must not touch the heap: register reads and writes, the shadow cache, mode
+ * switches, a transmit and an empty receive, counted with malloc/new replaced for the whole process.
+ */
+int main(){
+    register_file_backend backend;
+    esp_host::install_backend(&backend);
+
+    spi_object spi;
+    NRF24 radio(spi, nrf_test::dut_pins(), 32);
+    u8 payload[32] = {1, 2, 3};
+    u8 buffer[32] = {};
+    link_quality_T quality = {};
+
+    // everything a lazily built static could allocate happens once before counting
+    radio.transmit_data(payload, 3);
+    radio.rx_process(buffer);
+
+    counting = true;
+    for (int i = 0; i < 100; ++i) {
+        NRF_CHECK(radio.set_channel(static_cast<u8>(i % 100)));
+        NRF_CHECK(radio.set_pa_level(i & 1 ? PA_Level::Max_0dBm : PA_Level::Low_12dBm));
+        NRF_CHECK(radio.read_link_quality(quality));
+        NRF_CHECK(radio.switch_to_recieve());
+        NRF_CHECK(radio.power_down());
+        radio.transmit_data(payload, 3);
+        radio.rx_process(buffer);
+        NRF_CHECK(radio.resync());
+    }
+    counting = false;
+
+    std::printf("heap allocations on the register paths: %u\n", allocations.load());
+    NRF_CHECK(allocations.load() == 0);
+
+    esp_host::remove_backend(&backend);
+    std::puts("test_no_allocation passed");
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    constexpr u8 EN_AA = 0x01;
+    constexpr u8 DYNPD = 0x1C;
+    constexpr u8 FEATURE = 0x1D;
+    constexpr u8 RF_SETUP = 0x06;
+
+    uint32_t rx_pauses(const NRF24& radio){
+        return radio.state_stats().transitions[static_cast<size_t>(Radio_State::RxActive)][static_cast<size_t>(Radio_State::StandbyI)];
+    }
+}
+
+/**
+ * Pipe and payload feature registers stay in combinations the radio accepts: DPL only on pipes with auto-ack,
+ * EN_ACK_PAY only with EN_DPL, and the writes happen in standby while the radio is listening.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+    NRF_CHECK(dut.reg(EN_AA) == 0x00);
+
+    // no pipe has auto-ack after setup, so there is nothing DPL could run on
+    NRF_CHECK(!radio.set_dynamic_payloads(true));
+    NRF_CHECK(dut.reg(DYNPD) == 0x00);
+    NRF_CHECK(!radio.dynamic_payloads());
+
+    pipe_config_T pipe;
+    pipe.address = { 0x03, 0x03, 0x03 };
+    pipe.auto_ack = true;
+    NRF_CHECK(radio.configure_pipe(0, pipe));
+    NRF_CHECK(dut.reg(EN_AA) == 0x01);
+
+    // DYNPD follows EN_AA, and the radio leaves RX for the writes and comes back
+    radio.reset_state_stats();
+    NRF_CHECK(radio.set_dynamic_payloads(true));
+    NRF_CHECK(dut.reg(DYNPD) == 0x01);
+    NRF_CHECK(dut.reg(FEATURE) & 0x04);
+    NRF_CHECK(radio.dynamic_payloads());
+    NRF_CHECK(rx_pauses(radio) == 1);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+    NRF_CHECK(dut.state() == nrf_emu::radio_state::RxSettling || dut.state() == nrf_emu::radio_state::Rx);
+
+    NRF_CHECK(radio.set_dynamic_payloads(false));
+    NRF_CHECK(dut.reg(DYNPD) == 0x00);
+    NRF_CHECK(!(dut.reg(FEATURE) & 0x04));
+
+    // DPL without auto-ack is refused and leaves the pipe as it was
+    pipe_config_T no_ack_dynamic = pipe;
+    no_ack_dynamic.auto_ack = false;
+    no_ack_dynamic.dynamic_payload = true;
+    NRF_CHECK(!radio.configure_pipe(0, no_ack_dynamic));
+    NRF_CHECK(dut.reg(EN_AA) == 0x01);
+    NRF_CHECK(dut.reg(DYNPD) == 0x00);
+
+    // with ACK payloads on, the last dynamic pipe cannot go static, EN_ACK_PAY would be left without EN_DPL
+    NRF_CHECK(radio.set_ack_payloads(true));
+    NRF_CHECK(dut.reg(FEATURE) & 0x02);
+    pipe_config_T unused;
+    unused.enabled = false;
+    unused.address = { 0xC2, 0xC2, 0xC2 };
+    NRF_CHECK(radio.configure_pipe(1, unused));
+    NRF_CHECK(dut.reg(DYNPD) == 0x01);
+    NRF_CHECK(!radio.configure_pipe(0, pipe));
+    NRF_CHECK(dut.reg(FEATURE) & 0x04);
+    NRF_CHECK(radio.set_ack_payloads(false));
+    NRF_CHECK(radio.configure_pipe(0, pipe));
+    NRF_CHECK(dut.reg(FEATURE) == 0x00);
+    NRF_CHECK(dut.reg(DYNPD) == 0x00);
+
+    // RF settings and ACK payloads change in standby too, an unchanged setting does not leave RX
+    radio.reset_state_stats();
+    NRF_CHECK(radio.set_data_rate(Data_Rate::Rate_2Mbps));
+    NRF_CHECK(rx_pauses(radio) == 1);
+    NRF_CHECK(radio.set_data_rate(Data_Rate::Rate_2Mbps));
+    NRF_CHECK(rx_pauses(radio) == 1);
+    NRF_CHECK(radio.set_ack_payloads(true));
+    NRF_CHECK(rx_pauses(radio) == 2);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+    NRF_CHECK((dut.reg(RF_SETUP) & 0x28) == 0x08);
+
+    NRF_CHECK(radio.verify());
+    std::puts("test_pipe_config passed");
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "test_support.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace nrf_test;
+
+namespace {
+    /**
+     * @brief first byte of every packet a callback saw, filled on the radio task
+     */
+    struct sink{
+        std::mutex lock;
+        std::vector<u8> tags;
+
+        size_t size(){
+            std::lock_guard<std::mutex> guard(lock);
+            return tags.size();
+        }
+        std::vector<u8> snapshot(){
+            std::lock_guard<std::mutex> guard(lock);
+            return tags;
+        }
+    };
+
+    void record(const u8* data, u8 length, void* context){
+        if (length == 32) {
+            sink& target = *static_cast<sink*>(context);
+            std::lock_guard<std::mutex> guard(target.lock);
+            target.tags.push_back(data[0]);
+        }
+    }
+
+    void aim_peer(nrf_emu::radio& peer, const std::vector<u8>& address){
+        configure_peer(peer, false);
+        std::vector<u8> tx_addr = { 0x30 };
+        tx_addr.insert(tx_addr.end(), address.begin(), address.end());
+        command(peer, tx_addr);
+    }
+
+    // the radio task runs on a real thread, give it wall time to drain
+    template <typename Done>
+    bool wait_for(Done done){
+        for (int i = 0; i < 500 && !done(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return done();
+    }
+}
+
+/**
+ * Three peers addressing pipe 0, pipe 1 and pipe 3, the last sharing pipe 1's upper address bytes. Pipe 1 has a
+ * handler, pipe 3 a ring and pipe 0 falls through to the start_irq_rx callback, each sees only its own packets.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer_p0(medium, 99, 17, 18);
+    nrf_emu::radio peer_p1(medium, -1, -1);
+    nrf_emu::radio peer_p3(medium, -1, -1);
+    aim_peer(peer_p0, { 0x03, 0x03, 0x03 });
+    aim_peer(peer_p1, { 0xC1, 0xC2, 0xC3 });
+    aim_peer(peer_p3, { 0xC4, 0xC2, 0xC3 });
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    pipe_config_T pipe;
+    pipe.address = { 0xC1, 0xC2, 0xC3 };
+    NRF_CHECK(radio.configure_pipe(1, pipe));
+    pipe.address = { 0xC4 };
+    NRF_CHECK(radio.configure_pipe(3, pipe));
+    NRF_CHECK(dut.reg(0x02) & 0x08);
+    NRF_CHECK(dut.reg(0x0D) == 0xC4);
+
+    sink fallback;
+    sink pipe_1;
+    packet_ring<8> pipe_3;
+    radio.set_pipe_handler(1, record, &pipe_1);
+    radio.attach_pipe_ring(3, pipe_3);
+    NRF_CHECK(radio.start_irq_rx(record, &fallback));
+
+    // interleaved so consecutive packets come from different pipes, each round is drained before the FIFO fills
+    for (u8 i = 0; i < 4; ++i) {
+        peer_send(peer_p1, {static_cast<u8>(0x10 + i)});
+        peer_send(peer_p3, {static_cast<u8>(0x30 + i)});
+        peer_send(peer_p0, {static_cast<u8>(0x00 + i)});
+        NRF_CHECK(wait_for([&]{ return fallback.size() == i + 1u && pipe_1.size() == i + 1u && pipe_3.size() == i + 1u; }));
+    }
+    radio.stop_irq_rx();
+
+    NRF_CHECK((fallback.snapshot() == std::vector<u8>{ 0x00, 0x01, 0x02, 0x03 }));
+    NRF_CHECK((pipe_1.snapshot() == std::vector<u8>{ 0x10, 0x11, 0x12, 0x13 }));
+    rx_packet_T packets[8] = {};
+    NRF_CHECK(pipe_3.pop_batch(packets, 8) == 4);
+    for (u8 i = 0; i < 4; ++i) {
+        NRF_CHECK(packets[i].pipe == 3 && packets[i].length == 32 && packets[i].data[0] == 0x30 + i);
+    }
+
+    // dropping a route sends the pipe back to the catch-all callback
+    radio.set_pipe_handler(1, nullptr, nullptr);
+    radio.detach_pipe_ring(3);
+    NRF_CHECK(radio.start_irq_rx(record, &fallback));
+    peer_send(peer_p3, {0x35});
+    peer_send(peer_p1, {0x15});
+    NRF_CHECK(wait_for([&]{ return fallback.size() == 6; }));
+    radio.stop_irq_rx();
+    NRF_CHECK((fallback.snapshot() == std::vector<u8>{ 0x00, 0x01, 0x02, 0x03, 0x35, 0x15 }));
+    NRF_CHECK(pipe_1.size() == 4 && pipe_3.empty());
+
+    NRF_CHECK(radio.verify());
+    std::puts("test_pipe_routing passed");
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    using namespace nrf_map;
+
+    constexpr std::array<u8, max_address_bytes> wide_address = { 0xB1, 0xB2, 0xB3, 0xB4, 0xB5 };
+
+    constexpr radio_profile_T wide("wide", register_image{}
+        .set<setup_aw::aw>(Address_Width::Bytes_5)
+        .set_address<rx_addr_p0>(wide_address)
+        .set_address<tx_addr>(wide_address)
+        .set<rf_ch::channel>(40)
+        .set<rf_setup::rf_dr>(Data_Rate::Rate_1Mbps)
+        .set<rf_setup::rf_pwr>(PA_Level::High_6dBm)
+        .set<setup_retr::ard>(setup_retr::ard_for_us(1000))
+        .set<setup_retr::arc>(5));
+
+    // wide on the next channel, one register apart
+    constexpr radio_profile_T wide_next_channel("wide 41", register_image(wide.image).set<rf_ch::channel>(41));
+
+    size_t registers_in(const radio_profile_T& profile){
+        size_t count = 0;
+        for (u8 address = 0; address < register_count; ++address) {
+            count += profile.image.defines(address);
+        }
+        return count;
+    }
+
+    /**
+     * @brief profiles built at run time, where the compiler does not reject them, each missing a register it depends on
+     */
+    void test_dependency_rules(){
+        NRF_CHECK(wide.problem() == nullptr);
+        NRF_CHECK(NRF24::setup_profile().problem() == nullptr);
+
+        const radio_profile_T no_width("no width", register_image{}.set_address<rx_addr_p0>(wide_address));
+        NRF_CHECK(problem_is(no_width, "an address register needs SETUP_AW"));
+
+        const radio_profile_T config_set("config", register_image{}.set<config::pwr_up>(true));
+        NRF_CHECK(problem_is(config_set, "CONFIG belongs to the driver's state machine"));
+
+        const radio_profile_T rate_only("rate only", register_image{}.set<rf_setup::rf_dr>(Data_Rate::Rate_2Mbps));
+        NRF_CHECK(problem_is(rate_only, "ARD is checked against the data rate, set SETUP_RETR and RF_SETUP together"));
+
+        const radio_profile_T dpl_without_pipes("dpl", register_image{}.set<feature::en_dpl>(true));
+        NRF_CHECK(problem_is(dpl_without_pipes, "EN_DPL needs DYNPD in the profile"));
+
+        const radio_profile_T dpl_without_ack("dpl", register_image{}.set<feature::en_dpl>(true).set_value<dynpd>(0x01));
+        NRF_CHECK(problem_is(dpl_without_ack, "DYNPD needs EN_AA in the profile"));
+
+        const radio_profile_T pipe_without_width("pipes", register_image{}.set<en_rxaddr::pipes>(0b00000101).set<rx_pw<0>::width>(8));
+        NRF_CHECK(problem_is(pipe_without_width, "an enabled static pipe needs its RX_PW in the profile"));
+
+        const radio_profile_T long_replies("replies", register_image{}.set<rf_ch::channel>(3), 33);
+        NRF_CHECK(problem_is(long_replies, "ACK payloads are 32 bytes at most"));
+    }
+
+    /**
+     * @brief a profile setting addresses carries its own width, so the width an earlier profile left behind does not
+     * decide how many address bytes go out, and a run time profile without one is refused before any write
+     */
+    void test_address_width_travels_with_profile(){
+        nrf_emu::air medium;
+        nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+        spi_object spi;
+        NRF24 radio(spi, dut_pins(), 32);
+        NRF_CHECK(dut.reg(setup_aw::address) == 0x01); // setup profile, 3 byte addresses
+
+        NRF_CHECK(radio.apply_profile(wide));
+        NRF_CHECK(dut.reg(setup_aw::address) == 0x03);
+        const std::vector<u8> address = command(dut, {tx_addr::address, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+        NRF_CHECK(std::equal(wide_address.begin(), wide_address.end(), address.begin() + 1));
+        NRF_CHECK(dut.reg(rf_ch::address) == 40);
+        NRF_CHECK(radio.verify());
+
+        const radio_profile_T no_width("no width", register_image{}.set_address<tx_addr>({ 0x11, 0x22, 0x33 }));
+        spi.reset_stats();
+        NRF_CHECK(!radio.apply_profile(no_width));
+        NRF_CHECK(spi.stats().transactions == 0);
+        NRF_CHECK(radio.profile() == &wide);
+
+        NRF_CHECK(radio.apply_profile(NRF24::setup_profile()));
+        NRF_CHECK(dut.reg(setup_aw::address) == 0x01);
+        NRF_CHECK(dut.reg(rf_ch::address) == 2);
+        NRF_CHECK(radio.state() == Radio_State::RxActive);
+        NRF_CHECK(radio.verify());
+    }
+
+    /**
+     * @brief switching between profiles that differ in one register puts that register on the wire and counts
+     * every other one the profile sets as skipped
+     */
+    void test_minimal_switch(){
+        nrf_emu::air medium;
+        nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+        spi_object spi;
+        NRF24 radio(spi, dut_pins(), 32);
+        NRF_CHECK(radio.apply_profile(wide));
+
+        const profile_stats_T before = radio.profile_stats();
+        NRF_CHECK(radio.apply_profile(wide_next_channel));
+        const profile_stats_T& after = radio.profile_stats();
+        NRF_CHECK(after.switches == before.switches + 1);
+        NRF_CHECK(after.registers_written - before.registers_written == 1);
+        NRF_CHECK(after.registers_skipped - before.registers_skipped == registers_in(wide_next_channel) - 1);
+        NRF_CHECK(dut.reg(rf_ch::address) == 41);
+        NRF_CHECK(radio.profile() == &wide_next_channel);
+
+        // and back, again only RF_CH goes out
+        const profile_stats_T back = radio.profile_stats();
+        NRF_CHECK(radio.apply_profile(wide));
+        NRF_CHECK(radio.profile_stats().registers_written - back.registers_written == 1);
+        NRF_CHECK(dut.reg(rf_ch::address) == 40);
+        NRF_CHECK(radio.state() == Radio_State::RxActive);
+        NRF_CHECK(radio.verify());
+    }
+}
+
+/**
+ * radio_profile_T dependency rules and what they keep apply_profile from inheriting from an earlier profile.
+ */
+int main(){
+    test_dependency_rules();
+    test_address_width_travels_with_profile();
+    test_minimal_switch();
+    std::puts("test_profiles passed");
+    return 0;
+}
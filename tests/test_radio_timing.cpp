@@ -0,0 +1,199 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    /**
+     * @brief clock that only moves when the driver waits, or by step_us on every read once stepping is on. Every
+     * requested delay is recorded, and the emulated radios see the same waits.
+     */
+    struct mock_clock{
+        int64_t now_us = 0;
+        int64_t step_us = 0;
+        uint32_t reads = 0;
+        std::vector<uint32_t> delays;
+
+        radio_clock_T clock(){
+            return {
+                [](void* context) -> int64_t {
+                    mock_clock& self = *static_cast<mock_clock*>(context);
+                    self.reads++;
+                    self.now_us += self.step_us;
+                    return self.now_us;
+                },
+                [](uint32_t us, void* context) {
+                    mock_clock& self = *static_cast<mock_clock*>(context);
+                    self.delays.push_back(us);
+                    self.now_us += us;
+                    esp_host::advance_us(us);
+                },
+                this
+            };
+        }
+    };
+
+    /**
+     * @brief vTaskDelay wakes on a tick interrupt and counts the tick already under way, the system clock must
+     * still not return before the requested interval
+     */
+    void test_system_clock_never_early(){
+        const radio_clock_T clock = radio_clock_T::system();
+        const uint32_t intervals[] = { 1, 999, 1000, 1500, 2500, 10000 };
+        const int64_t phases[] = { 0, 1, 700, 999 };
+        for (int64_t phase : phases) {
+            for (uint32_t us : intervals) {
+                esp_host::advance_us(1000 - esp_host::now_us() % 1000 + phase);
+                const int64_t started_us = clock.now_us(clock.context);
+                clock.delay_us(us, clock.context);
+                NRF_CHECK(clock.now_us(clock.context) - started_us == us);
+            }
+        }
+    }
+
+    /**
+     * @brief radio_timing only waits for what is left of each datasheet interval
+     */
+    void test_datasheet_waits(){
+        mock_clock mock;
+        mock.now_us = 1000;
+        radio_timing timing(mock.clock());
+
+        timing.powered_up();
+        mock.now_us += 300;
+        timing.wait_standby();
+        NRF_CHECK(mock.delays.size() == 1 && mock.delays[0] == nrf_timing::power_down_to_standby_us - 300);
+        timing.wait_standby();
+        NRF_CHECK(mock.delays.size() == 1 && timing.stats().skipped == 1);
+
+        timing.ce_raised();
+        mock.now_us += 4;
+        timing.wait_ce_pulse();
+        NRF_CHECK(mock.delays.size() == 2 && mock.delays[1] == nrf_timing::ce_high_min_us - 4);
+        timing.ce_raised(); // CE already high, the earlier edge counts
+        timing.wait_active();
+        NRF_CHECK(mock.delays.size() == 3 && mock.delays[2] == nrf_timing::standby_to_active_us - nrf_timing::ce_high_min_us);
+        NRF_CHECK(timing.stats().waits == 3);
+        NRF_CHECK(timing.stats().waited_us == nrf_timing::power_down_to_standby_us - 300 + nrf_timing::standby_to_active_us - 4);
+    }
+
+    /**
+     * @brief transmit_data waits Thce, the rest of Tstby2a and the packet's airtime through the driver's clock,
+     * after which a single STATUS poll finds TX_DS
+     */
+    void test_transmit_waits(){
+        nrf_emu::air medium;
+        nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+        nrf_emu::radio peer(medium, 99, 17, 18);
+        configure_peer(peer, true);
+        mock_clock mock;
+        spi_object spi;
+        NRF24 radio(spi, dut_pins(), 32, mock.clock());
+        mock.now_us += 10000;
+
+        u8 message[32] = { 1, 2, 3 };
+        mock.delays.clear();
+        dut.reset_counters();
+        NRF_CHECK(radio.transmit_data(message, 3));
+        NRF_CHECK(peer.rx_fifo_count() == 1);
+        NRF_CHECK(mock.delays.size() == 3);
+        NRF_CHECK(mock.delays[0] == nrf_timing::ce_high_min_us);
+        NRF_CHECK(mock.delays[1] == nrf_timing::standby_to_active_us - nrf_timing::ce_high_min_us);
+        // preamble, 3 address bytes, packet control field and a static 32 byte payload without CRC at 4 us per bit
+        NRF_CHECK(mock.delays[2] == (8 * (1 + 3 + 32) + 9) * 4);
+        NRF_CHECK(dut.spi_counters().transactions_by_command[static_cast<size_t>(nrf_emu::command_kind::NOP)] == 1);
+    }
+
+    /**
+     * @brief while transmit_request waits out retransmits that never get an ACK, STATUS polls come after the
+     * airtime with a pause that doubles up to its cap, instead of back to back
+     */
+    void test_request_poll_backoff(){
+        nrf_emu::air medium({ 1.0, 0, 3 });
+        nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+        mock_clock mock;
+        spi_object spi;
+        NRF24 radio(spi, dut_pins(), 32, mock.clock());
+        pipe_config_T pipe;
+        pipe.address = { 0x03, 0x03, 0x03 };
+        pipe.auto_ack = true;
+        NRF_CHECK(radio.configure_pipe(0, pipe));
+        NRF_CHECK(radio.set_retransmit(1000, 3));
+        mock.now_us += 10000;
+
+        u8 message[32] = { 1, 2, 3 };
+        u8 reply[32] = {};
+        u8 reply_length = 0;
+        mock.delays.clear();
+        dut.reset_counters();
+        const int64_t started_us = mock.now_us;
+        NRF_CHECK(!radio.transmit_request(message, 3, reply, reply_length));
+        NRF_CHECK(dut.counters().max_rt_events == 1);
+
+        // Thce, the rest of Tstby2a, the airtime with the 1 byte CRC auto-ack forces, then the growing pauses
+        NRF_CHECK(mock.delays.size() > 8);
+        NRF_CHECK(mock.delays[1] == nrf_timing::standby_to_active_us - nrf_timing::ce_high_min_us);
+        NRF_CHECK(mock.delays[2] == (8 * (1 + 3 + 32 + 1) + 9) * 4);
+        const uint32_t expected[] = { 20, 40, 80, 160, 160 };
+        for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+            NRF_CHECK(mock.delays[3 + i] == expected[i]);
+        }
+        // four attempts with 1 ms ARD take about 9 ms, a busy poll would have kept the bus occupied throughout
+        const uint32_t polls = dut.spi_counters().transactions_by_command[static_cast<size_t>(nrf_emu::command_kind::NOP)];
+        NRF_CHECK(polls == mock.delays.size() - 2); // one after the airtime and one after every pause
+        NRF_CHECK(polls < (mock.now_us - started_us) / 100);
+        NRF_CHECK(radio.verify());
+    }
+
+    /**
+     * @brief the ACK wait of transmit_request and the stall timer of transmit_stream run on the driver's clock:
+     * a clock racing ahead ends them long before the radio gives up on its own
+     */
+    void test_transmit_timeouts(){
+        nrf_emu::air medium({ 1.0, 0, 3 });
+        nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+        mock_clock mock;
+        spi_object spi;
+        NRF24 radio(spi, dut_pins(), 32, mock.clock());
+        pipe_config_T pipe;
+        pipe.address = { 0x03, 0x03, 0x03 };
+        pipe.auto_ack = true;
+        NRF_CHECK(radio.configure_pipe(0, pipe));
+        mock.now_us += 10000;
+
+        u8 message[32] = { 1, 2, 3 };
+        u8 reply[32] = {};
+        u8 reply_length = 0;
+        mock.step_us = 5000;
+        dut.reset_counters();
+        NRF_CHECK(!radio.transmit_request(message, 3, reply, reply_length));
+        NRF_CHECK(dut.counters().max_rt_events == 0);
+        NRF_CHECK(dut.tx_fifo_count() == 0);
+
+        const tx_packet_T packets[] = { { message, 3, false }, { message, 3, false } };
+        mock.reads = 0;
+        dut.reset_counters();
+        NRF_CHECK(radio.transmit_stream(packets, 2) == 0);
+        NRF_CHECK(radio.last_stream_stats().failed == 2);
+        NRF_CHECK(dut.counters().max_rt_events == 0);
+        NRF_CHECK(dut.tx_fifo_count() == 0);
+        // started, CE raised, one stall check per poll and the end all read the same clock
+        NRF_CHECK(radio.last_stream_stats().elapsed_us % mock.step_us == 0);
+        NRF_CHECK(radio.last_stream_stats().elapsed_us > 50 * 1000);
+        mock.step_us = 0;
+        NRF_CHECK(radio.verify());
+    }
+}
+
+/**
+ * radio_clock_T::system against the host's tick model, and the driver's waits and transmit timeouts against a
+ * recording clock.
+ */
+int main(){
+    test_system_clock_never_early();
+    test_datasheet_waits();
+    test_transmit_waits();
+    test_request_poll_backoff();
+    test_transmit_timeouts();
+    std::puts("test_radio_timing passed");
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "test_support.hpp"
+#include "rate_controller.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    constexpr u8 RF_SETUP = 0x06;
+
+    u8 rf_setup_for(Data_Rate rate){
+        switch (rate) {
+            case Data_Rate::Rate_250kbps: return 0x26;
+            case Data_Rate::Rate_1Mbps: return 0x06;
+            default: return 0x0E;
+        }
+    }
+
+    // the receiving end follows the data rate the controller picks
+    bool switch_peer(const rf_settings_T& settings, void* context){
+        command(*static_cast<nrf_emu::radio*>(context), {0x26, rf_setup_for(settings.data_rate)});
+        return true;
+    }
+
+    struct link_T{
+        nrf_emu::air& medium;
+        nrf_emu::radio& dut;
+        nrf_emu::radio& peer;
+        NRF24& radio;
+    };
+
+    /**
+     * @brief sends packets through transmit_data and feeds every outcome to the controller, checking after each
+     * decision that it reached the radio and the peer while the driver kept listening between packets
+     */
+    void run(link_T& link, rate_controller& controller, size_t packets){
+        u8 payload[32] = {};
+        for (size_t i = 0; i < packets; ++i) {
+            const bool delivered = link.radio.transmit_data(payload, sizeof(payload));
+            if (controller.on_transmit(link.radio, delivered, switch_peer, &link.peer)) {
+                NRF_CHECK(link.radio.state() == Radio_State::RxActive);
+                NRF_CHECK(link.radio.verify());
+                NRF_CHECK((link.peer.reg(RF_SETUP) & 0x28) == (rf_setup_for(link.radio.rf_settings().data_rate) & 0x28));
+            }
+            command(link.peer, {0xE2});
+            command(link.peer, {0x27, 0x40});
+        }
+    }
+}
+
+/**
+ * rate_controller::on_transmit against an emulated link: loss pushes PA up and then the data rate down, a clean
+ * link gets probed back up, and ACKs above the RPD threshold bring PA level down again.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer(medium, -1, -1);
+    configure_peer(peer, true);
+    command(peer, {0x21, 0x01});
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    pipe_config_T pipe;
+    pipe.address = { 0x03, 0x03, 0x03 };
+    pipe.auto_ack = true;
+    NRF_CHECK(radio.configure_pipe(0, pipe));
+    NRF_CHECK(radio.set_data_rate(Data_Rate::Rate_2Mbps));
+    NRF_CHECK(radio.set_pa_level(PA_Level::High_6dBm));
+    command(peer, {0x26, rf_setup_for(Data_Rate::Rate_2Mbps)});
+    link_T link{ medium, dut, peer, radio };
+
+    rate_controller_config_T config;
+    config.window_packets = 8;
+    config.hold_windows = 1;
+    config.probe_interval_windows = 2;
+
+    // a weak link where about a third of the packets hit MAX_RT: PA goes to max first, then the rate steps down
+    medium.set_config({ 0.5, 0, 3, false });
+    rate_controller lossy(config);
+    run(link, lossy, 8 * 12);
+    NRF_CHECK(lossy.stats().pa_ups == 1);
+    NRF_CHECK(lossy.stats().rate_downs >= 2);
+    NRF_CHECK(lossy.stats().pa_downs == 0);
+    NRF_CHECK(radio.rf_settings().pa_level == PA_Level::Max_0dBm);
+    NRF_CHECK(radio.rf_settings().data_rate == Data_Rate::Rate_250kbps);
+
+    // a clean link with weak ACKs: faster rates are probed and kept, the power stays where it is
+    medium.set_config({ 0.0, 0, 3, false });
+    rate_controller clean(config);
+    run(link, clean, 8 * 16);
+    NRF_CHECK(clean.stats().rate_ups >= 2);
+    NRF_CHECK(clean.stats().failed_probes == 0);
+    NRF_CHECK(clean.stats().pa_downs == 0);
+    NRF_CHECK(radio.rf_settings().data_rate == Data_Rate::Rate_2Mbps);
+    NRF_CHECK(radio.rf_settings().pa_level == PA_Level::Max_0dBm);
+
+    // the same link with ACKs above -64 dBm: RPD lets the controller save power
+    medium.set_config({ 0.0, 0, 3, true });
+    rate_controller strong(config);
+    run(link, strong, 8 * 12);
+    NRF_CHECK(strong.stats().pa_downs >= 2);
+    NRF_CHECK(static_cast<u8>(radio.rf_settings().pa_level) < static_cast<u8>(PA_Level::Max_0dBm));
+    NRF_CHECK(radio.rf_settings().data_rate == Data_Rate::Rate_2Mbps);
+
+    NRF_CHECK(radio.verify());
+    std::puts("test_rate_controller passed");
+    return 0;
+}
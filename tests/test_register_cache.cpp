@@ -0,0 +1,86 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    /**
+     * @brief SPI transactions and cache counters a call cost
+     */
+    struct cost_T{
+        uint32_t transactions;
+        uint32_t writes;
+        uint32_t writes_skipped;
+        uint32_t reads;
+        uint32_t reads_served;
+    };
+
+    template <typename Call>
+    cost_T cost_of(NRF24& radio, spi_object& spi, Call call){
+        const register_cache_stats_T before = radio.cache_stats();
+        spi.reset_stats();
+        NRF_CHECK(call());
+        const register_cache_stats_T& after = radio.cache_stats();
+        return {
+            spi.stats().transactions,
+            after.writes - before.writes,
+            after.writes_skipped - before.writes_skipped,
+            after.reads - before.reads,
+            after.reads_served - before.reads_served,
+        };
+    }
+}
+
+/**
+ * The shadow register cache on the wire: a mode switch is at most one CONFIG write and free when the mode does not
+ * change, and reconfiguring a pipe to what it already is skips every register write and reads nothing from the chip.
+ * switch_to_transmit is private, transmit_data stands in for the TX direction.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+
+    // already receiving, nothing to do
+    cost_T cost = cost_of(radio, spi, [&]{ return radio.switch_to_recieve(); });
+    NRF_CHECK(cost.transactions == 0 && cost.writes == 0 && cost.reads == 0);
+
+    // a transmit switches to TX and back, one CONFIG write each way and nothing else through the cache
+    u8 message[32] = { 1 };
+    cost = cost_of(radio, spi, [&]{ return radio.transmit_data(message, 1); });
+    NRF_CHECK(cost.writes == 2 && cost.writes_skipped == 0 && cost.reads == 0);
+    NRF_CHECK((dut.reg(0x00) & 0x03) == 0x03);
+    for (int i = 0; i < 3; ++i) {
+        const cost_T again = cost_of(radio, spi, [&]{ return radio.transmit_data(message, 1); });
+        NRF_CHECK(again.transactions == cost.transactions && again.writes == 2);
+    }
+
+    // PWR_UP and PRIM_RX come back in one CONFIG write, the RX step finds CONFIG already right
+    cost = cost_of(radio, spi, [&]{ return radio.power_down(); });
+    NRF_CHECK(cost.transactions == 1 && cost.writes == 1);
+    NRF_CHECK((dut.reg(0x00) & 0x03) == 0x01);
+    cost = cost_of(radio, spi, [&]{ return radio.switch_to_recieve(); });
+    NRF_CHECK(cost.transactions == 1 && cost.writes == 1 && cost.writes_skipped == 1);
+    NRF_CHECK((dut.reg(0x00) & 0x03) == 0x03);
+    cost = cost_of(radio, spi, [&]{ return radio.switch_to_recieve(); });
+    NRF_CHECK(cost.transactions == 0 && cost.writes == 0);
+
+    // the first configure_pipe writes what differs, the same configuration again is all skipped writes
+    pipe_config_T pipe;
+    pipe.address = { 0xC1, 0xC2, 0xC3 };
+    pipe.payload_width = 16;
+    const cost_T first = cost_of(radio, spi, [&]{ return radio.configure_pipe(1, pipe); });
+    NRF_CHECK(first.writes > 0);
+    NRF_CHECK(dut.reg(0x12) == 16);
+
+    cost = cost_of(radio, spi, [&]{ return radio.configure_pipe(1, pipe); });
+    NRF_CHECK(cost.writes == 0 && cost.writes_skipped == first.writes + first.writes_skipped);
+    NRF_CHECK(cost.reads == 0);
+    NRF_CHECK(cost.transactions == 0);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+
+    NRF_CHECK(radio.verify());
+    std::puts("test_register_cache passed");
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "test_support.hpp"
+
+#include <cstring>
+
+using namespace nrf_test;
+
+namespace {
+    using namespace nrf_map;
+
+    constexpr std::array<u8, max_address_bytes> pipe_address = { 0xC1, 0xC2, 0xC3, 0xC4, 0xC5 };
+
+    constexpr register_image addressed_image(){
+        register_image image;
+        image.set<setup_aw::aw>(Address_Width::Bytes_4)
+             .set_address<rx_addr_p0>(pipe_address)
+             .set_address<tx_addr>(pipe_address);
+        return image;
+    }
+
+    constexpr register_image address_without_width(){
+        register_image image;
+        image.set_address<rx_addr_p1>(pipe_address);
+        return image;
+    }
+
+    constexpr register_image auto_ack_without_crc(){
+        register_image image;
+        image.set_value<en_aa>(0x01)
+             .set<config::pwr_up>(true);
+        return image;
+    }
+
+    // the rules are usable at compile time, where a profile checks them
+    static_assert(addressed_image().valid());
+    static_assert(addressed_image().length(rx_addr_p0::address) == 4);
+    static_assert(addressed_image().length(setup_aw::address) == 1);
+    static_assert(!address_without_width().valid());
+    static_assert(!auto_ack_without_crc().valid());
+    static_assert(register_image{}.set_value<en_aa>(0x01).valid()); // without CONFIG the driver's CONFIG stands
+}
+
+/**
+ * register_image datasheet rules: an address register only has a length with SETUP_AW in the same image, and the
+ * auto-ack CRC rule applies to images that set CONFIG.
+ */
+int main(){
+    NRF_CHECK(addressed_image().problem() == nullptr);
+    NRF_CHECK(problem_is(address_without_width(), "an address register needs SETUP_AW"));
+    NRF_CHECK(problem_is(register_image{}.set_address<tx_addr>(pipe_address), "an address register needs SETUP_AW"));
+    NRF_CHECK(problem_is(register_image{}.set_value<setup_aw>(0x00), "SETUP_AW 00 is illegal"));
+    NRF_CHECK(problem_is(auto_ack_without_crc(), "auto-ack forces EN_CRC, set it"));
+
+    const register_image image = addressed_image();
+    NRF_CHECK(image.address_width() == 4);
+    NRF_CHECK(std::memcmp(image.data(tx_addr::address), pipe_address.data(), image.length(tx_addr::address)) == 0);
+
+    std::puts("test_register_image passed");
+    return 0;
+}
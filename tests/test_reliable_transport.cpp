@@ -0,0 +1,281 @@
+#include "test_support.hpp"
+#include "virtual_scheduler.hpp"
+#include "reliable_transport.hpp"
+
+#include <atomic>
+
+using namespace nrf_test;
+
+namespace {
+    constexpr int rx_csn = 15;
+    constexpr int rx_ce = 25;
+    constexpr int rx_irq = 17;
+
+    /**
+     * @brief a transport data frame as transport_sender builds it
+     */
+    std::vector<u8> data_frame(u8 transfer_id, size_t sequence, const std::vector<u8>& payload, u8 flags){
+        std::vector<u8> frame(transport_frame::header_size + payload.size());
+        frame[0] = static_cast<u8>(transport_frame::type_data | flags);
+        frame[1] = transfer_id;
+        frame[2] = static_cast<u8>(sequence);
+        frame[3] = static_cast<u8>(sequence >> 8);
+        frame[4] = static_cast<u8>(payload.size());
+        std::copy(payload.begin(), payload.end(), frame.begin() + transport_frame::header_size);
+        return frame;
+    }
+
+    std::vector<u8> fragment(size_t sequence){
+        return std::vector<u8>(transport_frame::data_payload_size, static_cast<u8>(0xA0 + sequence));
+    }
+
+    bool feed(transport_receiver& receiver, const std::vector<u8>& frame){
+        return receiver.on_frame(frame.data(), static_cast<u8>(frame.size()));
+    }
+
+    size_t ack_cumulative(const std::vector<u8>& ack){ return ack[2] | (ack[3] << 8); }
+    uint32_t ack_selective(const std::vector<u8>& ack){
+        return ack[4] | (ack[5] << 8) | (ack[6] << 16) | (static_cast<uint32_t>(ack[7]) << 24);
+    }
+
+    std::vector<u8> ack_frame(u8 transfer_id, size_t cumulative, uint32_t selective, bool complete){
+        return { static_cast<u8>(transport_frame::type_ack | (complete ? transport_frame::flag_complete : 0)), transfer_id,
+            static_cast<u8>(cumulative), static_cast<u8>(cumulative >> 8), static_cast<u8>(selective),
+            static_cast<u8>(selective >> 8), static_cast<u8>(selective >> 16), static_cast<u8>(selective >> 24) };
+    }
+
+    /**
+     * @brief pops every frame a listening peer caught
+     */
+    std::vector<std::vector<u8>> drain(nrf_emu::radio& peer){
+        std::vector<std::vector<u8>> frames;
+        while (peer.rx_fifo_count() > 0) {
+            frames.push_back(peer_receive(peer));
+        }
+        return frames;
+    }
+
+    /**
+     * @brief fragments arriving out of order, duplicated and past a hole: the ACK carries the hole as the cumulative
+     * ACK and what arrived beyond it in the bitmap, and the buffer ends up in order
+     */
+    void test_receiver_reassembly(){
+        nrf_emu::air medium;
+        nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+        nrf_emu::radio listener(medium, -1, -1);
+        configure_peer(listener, true);
+        spi_object spi;
+        NRF24 radio(spi, dut_pins(), 32);
+
+        u8 buffer[5 * transport_frame::data_payload_size] = {};
+        transport_receiver receiver(radio, buffer, sizeof(buffer));
+        constexpr u8 id = 7;
+
+        NRF_CHECK(feed(receiver, data_frame(id, 2, fragment(2), 0)));
+        NRF_CHECK(feed(receiver, data_frame(id, 0, fragment(0), 0)));
+        NRF_CHECK(feed(receiver, data_frame(id, 2, fragment(2), 0)));
+        NRF_CHECK(feed(receiver, data_frame(id, 4, fragment(4), transport_frame::flag_last | transport_frame::flag_ack_request)));
+        NRF_CHECK(receiver.stats().duplicates == 1);
+        NRF_CHECK(!receiver.complete());
+
+        receiver.poll();
+        std::vector<std::vector<u8>> acks = drain(listener);
+        NRF_CHECK(acks.size() == 1);
+        NRF_CHECK((acks[0][0] & transport_frame::type_mask) == transport_frame::type_ack && acks[0][1] == id);
+        NRF_CHECK(!(acks[0][0] & transport_frame::flag_complete));
+        NRF_CHECK(ack_cumulative(acks[0]) == 1);
+        NRF_CHECK(ack_selective(acks[0]) == 0x0A); // fragments 2 and 4
+
+        // the holes fill in reverse order
+        NRF_CHECK(feed(receiver, data_frame(id, 3, fragment(3), 0)));
+        NRF_CHECK(!receiver.complete());
+        NRF_CHECK(feed(receiver, data_frame(id, 1, fragment(1), transport_frame::flag_ack_request)));
+        NRF_CHECK(receiver.complete());
+        NRF_CHECK(receiver.length() == sizeof(buffer));
+        for (size_t i = 0; i < sizeof(buffer); ++i) {
+            NRF_CHECK(buffer[i] == 0xA0 + i / transport_frame::data_payload_size);
+        }
+        receiver.poll();
+        acks = drain(listener);
+        NRF_CHECK(acks.size() == 1);
+        NRF_CHECK((acks[0][0] & transport_frame::flag_complete) && ack_cumulative(acks[0]) == 5);
+
+        // a late copy of the released transfer is a duplicate and is acknowledged again
+        receiver.release();
+        NRF_CHECK(feed(receiver, data_frame(id, 4, fragment(4), transport_frame::flag_last)));
+        NRF_CHECK(!receiver.complete());
+        NRF_CHECK(receiver.stats().duplicates == 2);
+        receiver.poll();
+        acks = drain(listener);
+        NRF_CHECK(acks.size() == 1 && (acks[0][0] & transport_frame::flag_complete));
+
+        // a sender that restarted with the same id sends a transfer the fragment count does not fit, it starts over
+        const std::vector<u8> short_payload = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+        NRF_CHECK(feed(receiver, data_frame(id, 0, short_payload, transport_frame::flag_last | transport_frame::flag_ack_request)));
+        NRF_CHECK(receiver.complete());
+        NRF_CHECK(receiver.length() == short_payload.size());
+        NRF_CHECK(buffer[0] == 1 && buffer[9] == 10);
+        NRF_CHECK(receiver.stats().transfers == 2);
+    }
+
+    /**
+     * @brief the selective ACK keeps fragments that arrived past a hole from going out again
+     */
+    void test_sender_selective_ack(){
+        nrf_emu::air medium;
+        nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+        nrf_emu::radio listener(medium, -1, -1);
+        nrf_emu::radio acker(medium, -1, -1);
+        configure_peer(listener, true);
+        configure_peer(acker, false);
+        spi_object spi;
+        NRF24 radio(spi, dut_pins(), 32);
+
+        transport_config_T config;
+        config.window = 3; // the listener's RX FIFO holds a whole burst
+        transport_sender sender(radio, config);
+        std::vector<u8> data(5 * transport_frame::data_payload_size);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<u8>(i);
+        }
+
+        NRF_CHECK(sender.begin(data.data(), data.size()));
+        NRF_CHECK(sender.pump() == Transfer_State::Waiting);
+        std::vector<std::vector<u8>> frames = drain(listener);
+        NRF_CHECK(frames.size() == 3);
+        const u8 id = frames[0][1];
+        for (size_t i = 0; i < frames.size(); ++i) {
+            NRF_CHECK(frames[i][1] == id && frames[i][2] == i);
+        }
+        NRF_CHECK(frames[2][0] & transport_frame::flag_ack_request);
+
+        // fragment 0 was lost, 1 and 2 arrived: only 0 goes out again
+        peer_send(acker, ack_frame(id, 0, 0x06, false));
+        drain(listener);
+        NRF_CHECK(sender.pump() == Transfer_State::Sending);
+        NRF_CHECK(sender.acknowledged_bytes() == 0);
+        NRF_CHECK(sender.pump() == Transfer_State::Waiting);
+        frames = drain(listener);
+        NRF_CHECK(frames.size() == 1 && frames[0][2] == 0);
+        NRF_CHECK(sender.stats().retransmitted_frames == 1);
+
+        // an ACK of another transfer is ignored
+        peer_send(acker, ack_frame(static_cast<u8>(id + 1), 5, 0, true));
+        drain(listener);
+        NRF_CHECK(sender.pump() == Transfer_State::Waiting);
+
+        // the cumulative ACK slides the window past 0 - 2, the remaining two go out once each
+        peer_send(acker, ack_frame(id, 3, 0, false));
+        drain(listener);
+        NRF_CHECK(sender.pump() == Transfer_State::Sending);
+        NRF_CHECK(sender.acknowledged_bytes() == 3 * transport_frame::data_payload_size);
+        NRF_CHECK(sender.pump() == Transfer_State::Waiting);
+        frames = drain(listener);
+        NRF_CHECK(frames.size() == 2 && frames[0][2] == 3 && frames[1][2] == 4);
+        NRF_CHECK(frames[1][0] & transport_frame::flag_last);
+        NRF_CHECK(sender.stats().retransmitted_frames == 1);
+
+        peer_send(acker, ack_frame(id, 5, 0, true));
+        drain(listener);
+        NRF_CHECK(sender.pump() == Transfer_State::Complete);
+        NRF_CHECK(sender.acknowledged_bytes() == data.size());
+
+        // the next transfer takes a new id, and a sender built after a restart does not start from a fixed one
+        NRF_CHECK(sender.begin(data.data(), transport_frame::data_payload_size));
+        NRF_CHECK(sender.pump() == Transfer_State::Waiting);
+        frames = drain(listener);
+        NRF_CHECK(frames.size() == 1 && frames[0][1] != id);
+        sender.cancel();
+        esp_host::seed_random(0x1234);
+        transport_sender first(radio, config);
+        esp_host::seed_random(0x5678);
+        transport_sender second(radio, config);
+        NRF_CHECK(first.begin(data.data(), 1) && first.pump() == Transfer_State::Waiting);
+        NRF_CHECK(second.begin(data.data(), 1) && second.pump() == Transfer_State::Waiting);
+        frames = drain(listener);
+        NRF_CHECK(frames.size() == 2 && frames[0][1] != frames[1][1]);
+    }
+
+    /**
+     * @brief a whole transfer between two drivers on a lossy air, frames and ACKs both get lost
+     */
+    void test_lossy_transfer(double loss, uint32_t seed){
+        nrf_emu::air medium({ loss, 0, seed });
+        nrf_emu::radio tx_radio(medium, dut_csn, dut_ce, dut_irq);
+        nrf_emu::radio rx_radio(medium, rx_csn, rx_ce, rx_irq);
+
+        virtual_scheduler scheduler;
+        spi_bus bus;
+        spi_config_T tx_device;
+        spi_config_T rx_device;
+        rx_device.csn_pin = rx_csn;
+        spi_object tx_spi(bus, tx_device);
+        spi_object rx_spi(bus, rx_device);
+        NRF24 transmitter(tx_spi, dut_pins(), 32, scheduler.clock());
+        NRF24 receiver_radio(rx_spi, { static_cast<gpio_num_t>(rx_ce), static_cast<gpio_num_t>(rx_csn), GPIO_NUM_14, GPIO_NUM_12,
+            GPIO_NUM_13, static_cast<gpio_num_t>(rx_irq) }, 32, scheduler.clock());
+
+        std::vector<u8> data(1500);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<u8>(i * 7 + 3);
+        }
+        std::vector<u8> buffer(2048, 0);
+        const size_t fragments = (data.size() + transport_frame::data_payload_size - 1) / transport_frame::data_payload_size;
+
+        transport_config_T config;
+        config.window = 3; // a burst fits the receiver's RX FIFO while its task waits for the sender
+        config.max_timeouts = 20;
+        transport_sender sender(transmitter, config);
+        transport_receiver receiver(receiver_radio, buffer.data(), buffer.size());
+
+        bool sent = false;
+        std::atomic<bool> finished{false};
+        auto send_task = [&]{
+            sent = sender.send(data.data(), data.size());
+            finished = true;
+        };
+        auto receive_task = [&]{
+            const radio_clock_T clock = receiver_radio.timing().clock();
+            u8 frame[32] = {};
+            while (!finished) {
+                // one frame at a time, rx_process would flush the rest of a burst
+                while (const u8 length = receiver_radio.read_ack_payload(frame)) {
+                    receiver.on_frame(frame, length);
+                }
+                receiver.poll();
+                clock.delay_us(50, clock.context);
+            }
+        };
+        scheduler.run({ send_task, receive_task });
+
+        const transport_stats_T& stats = sender.stats();
+        std::printf("loss %.2f: %u frames for %zu fragments, %u retransmitted, %u timeouts, %u duplicates, %lld us\n",
+            loss, stats.frames_sent, fragments, stats.retransmitted_frames, stats.timeouts, receiver.stats().duplicates,
+            static_cast<long long>(stats.elapsed_us));
+        NRF_CHECK(sent);
+        NRF_CHECK(receiver.complete() && receiver.length() == data.size());
+        NRF_CHECK(std::equal(data.begin(), data.end(), buffer.begin()));
+        NRF_CHECK(stats.bytes_delivered == data.size());
+        if (loss == 0.0) {
+            NRF_CHECK(stats.frames_sent == fragments && stats.retransmitted_frames == 0);
+        } else {
+            NRF_CHECK(stats.retransmitted_frames > 0);
+            NRF_CHECK(stats.frames_sent == fragments + stats.retransmitted_frames);
+        }
+        NRF_CHECK(transmitter.verify() && receiver_radio.verify());
+    }
+}
+
+/**
+ * transport_receiver reassembly and ACKs from hand-built frames in any order, transport_sender's window against
+ * hand-built selective ACKs, and whole transfers between two drivers over a clean and a lossy air.
+ */
+int main(){
+    test_receiver_reassembly();
+    test_sender_selective_ack();
+    test_lossy_transfer(0.0, 1);
+    test_lossy_transfer(0.2, 5);
+    test_lossy_transfer(0.4, 9);
+    std::puts("test_reliable_transport passed");
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "test_support.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace nrf_test;
+
+namespace {
+    constexpr size_t capacity = 4;
+
+    // the radio task runs on a real thread, give it wall time to drain
+    bool wait_for_pushes(const packet_ring<capacity>& ring, size_t count){
+        for (int i = 0; i < 500 && ring.size() + ring.overflows() < count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        return ring.size() + ring.overflows() == count;
+    }
+}
+
+/**
+ * start_irq_rx feeding an attached packet_ring and no callback, with a burst larger than the ring and nobody
+ * popping: the oldest packets stay in arrival order with their pipe and read time, the rest are counted as
+ * overflows, and a drained ring takes packets again.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer_p0(medium, 99, 17, 18);
+    nrf_emu::radio peer_p1(medium, -1, -1);
+    configure_peer(peer_p0, false);
+    configure_peer(peer_p1, false);
+    command(peer_p1, {0x30, 0xC1, 0xC2, 0xC3});
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    pipe_config_T pipe;
+    pipe.address = { 0xC1, 0xC2, 0xC3 };
+    NRF_CHECK(radio.configure_pipe(1, pipe));
+
+    packet_ring<capacity> ring;
+    radio.attach_rx_ring(ring);
+    NRF_CHECK(radio.start_irq_rx(nullptr, nullptr));
+
+    // odd packets go to pipe 1, one at a time so the radio FIFO never fills and only the ring overflows
+    constexpr size_t burst = capacity + 2;
+    int64_t sent_us[burst] = {};
+    for (size_t i = 0; i < burst; ++i) {
+        sent_us[i] = esp_host::now_us();
+        peer_send(i % 2 ? peer_p1 : peer_p0, {static_cast<u8>(i)});
+        NRF_CHECK(wait_for_pushes(ring, i + 1));
+    }
+    NRF_CHECK(ring.size() == capacity);
+    NRF_CHECK(ring.overflows() == burst - capacity);
+    NRF_CHECK(ring.high_water() == capacity);
+
+    rx_packet_T packets[burst] = {};
+    NRF_CHECK(ring.pop_batch(packets, burst) == capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        NRF_CHECK(packets[i].data[0] == i && packets[i].length == 32);
+        NRF_CHECK(packets[i].pipe == i % 2);
+        // read after the frame was sent and no later than the next send
+        NRF_CHECK(packets[i].timestamp_us > sent_us[i]);
+        NRF_CHECK(i + 1 == capacity || packets[i].timestamp_us <= sent_us[i + 1]);
+        NRF_CHECK(i == 0 || packets[i].timestamp_us > packets[i - 1].timestamp_us);
+    }
+    NRF_CHECK(ring.empty());
+
+    // room again, the counters keep the history until reset
+    peer_send(peer_p0, {0x40});
+    NRF_CHECK(wait_for_pushes(ring, 1 + burst - capacity));
+    radio.stop_irq_rx();
+    NRF_CHECK(ring.pop(packets[0]) && packets[0].data[0] == 0x40 && packets[0].pipe == 0);
+    NRF_CHECK(ring.overflows() == burst - capacity && ring.high_water() == capacity);
+    ring.reset_counters();
+    NRF_CHECK(ring.overflows() == 0 && ring.high_water() == 0);
+    radio.detach_rx_ring();
+
+    NRF_CHECK(radio.verify());
+    std::puts("test_rx_ring passed");
+    return 0;
+}
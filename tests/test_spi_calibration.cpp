@@ -0,0 +1,61 @@
+#include "test_support.hpp"
+
+using namespace nrf_test;
+
+namespace {
+    std::vector<u8> tx_address(nrf_emu::radio& dut){
+        const std::vector<u8> response = command(dut, {0x10, 0xFF, 0xFF, 0xFF});
+        return std::vector<u8>(response.begin() + 1, response.end());
+    }
+}
+
+/**
+ * calibrate_spi_clock against wiring that only carries 5 MHz: opted in through spi_config_T it runs inside the
+ * constructor and settles on the fastest passing step, called by hand it gives the same answer, and either way
+ * TX_ADDR holds the driver's address again, the cache matches the chip and the radio still talks to a peer.
+ */
+int main(){
+    constexpr int wiring_limit_hz = 5 * 1000 * 1000;
+    esp_host::set_spi_clock_limit(dut_csn, wiring_limit_hz);
+
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer(medium, 99, 17, 18);
+    configure_peer(peer, true);
+    u8 message[32] = { 0x42 };
+
+    {
+        spi_config_T settings;
+        settings.calibrate_clock = true;
+        spi_object spi(settings);
+        NRF24 radio(spi, dut_pins(), 32);
+        NRF_CHECK(spi.clock_speed_hz() == wiring_limit_hz);
+        NRF_CHECK((tx_address(dut) == std::vector<u8>{ 0x03, 0x03, 0x03 }));
+        NRF_CHECK(radio.state() == Radio_State::RxActive);
+        NRF_CHECK(radio.verify());
+        NRF_CHECK(radio.transmit_data(message, 1));
+        NRF_CHECK(peer.rx_fifo_count() == 1 && peer_receive(peer)[0] == 0x42);
+    }
+
+    // without the flag the configured rate stands until calibrate_spi_clock is called
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    NRF_CHECK(spi.clock_speed_hz() == 1 * 1000 * 1000);
+    NRF_CHECK(radio.calibrate_spi_clock() == wiring_limit_hz);
+    NRF_CHECK(spi.clock_speed_hz() == wiring_limit_hz);
+    NRF_CHECK((tx_address(dut) == std::vector<u8>{ 0x03, 0x03, 0x03 }));
+    NRF_CHECK(radio.verify());
+
+    // no step passes, the previous rate comes back
+    const int too_fast[] = { 10 * 1000 * 1000, 8 * 1000 * 1000 };
+    NRF_CHECK(radio.calibrate_spi_clock(too_fast, 2) == 0);
+    NRF_CHECK(spi.clock_speed_hz() == wiring_limit_hz);
+    NRF_CHECK((tx_address(dut) == std::vector<u8>{ 0x03, 0x03, 0x03 }));
+    NRF_CHECK(radio.verify());
+    message[0] = 0x43;
+    NRF_CHECK(radio.transmit_data(message, 1));
+    NRF_CHECK(peer.rx_fifo_count() == 1 && peer_receive(peer)[0] == 0x43);
+
+    std::puts("test_spi_calibration passed");
+    return 0;
+}
@@ -0,0 +1,133 @@
+
+#pragma once
+
+#include "nRF24L01P.hpp"
+#include "nrf24_emulator.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+
+/**
+ * @brief stops the test with the failed expression and its line, the exit code fails the ctest entry
+ */
+#define NRF_CHECK(condition)                                                                \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1);                                                                   \
+        }                                                                                   \
+    } while (0)
+
+
+namespace nrf_test {
+
+    using nrf_emu::u8;
+
+    /**
+     * @brief true if a register_image or radio_profile_T reports exactly the expected problem, prints what it
+     * reported otherwise
+     */
+    template <typename Checked>
+    bool problem_is(const Checked& checked, const char* expected){
+        const char* problem = checked.problem();
+        if (problem == nullptr || std::strcmp(problem, expected) != 0) {
+            std::fprintf(stderr, "expected \"%s\", got \"%s\"\n", expected, problem != nullptr ? problem : "none");
+            return false;
+        }
+        return true;
+    }
+
+    // the driver under test uses the spi_config_T default CSN, its emulated radio takes these CE and IRQ pins
+    inline constexpr int dut_csn = 5;
+    inline constexpr int dut_ce = 4;
+    inline constexpr int dut_irq = 16;
+
+    inline Pins_T dut_pins(){
+        return { GPIO_NUM_4, GPIO_NUM_5, GPIO_NUM_14, GPIO_NUM_12, GPIO_NUM_13, GPIO_NUM_16 };
+    }
+
+    /**
+     * @brief one SPI transaction straight into an emulated radio, for peers the test drives without a driver
+     */
+    inline std::vector<u8> command(nrf_emu::radio& radio, std::vector<u8> tx){
+        std::lock_guard<std::recursive_mutex> lock(esp_host::backend_lock());
+        std::vector<u8> rx(tx.size());
+        radio.spi_transfer(tx.data(), rx.data(), tx.size());
+        return rx;
+    }
+
+    inline void set_ce(nrf_emu::radio& radio, bool level){
+        std::lock_guard<std::recursive_mutex> lock(esp_host::backend_lock());
+        radio.set_ce(level);
+    }
+
+    /**
+     * @brief sets a raw peer up like NRF24::setup_config: 3 byte address 03 03 03, 250 kbps, channel 2, no CRC,
+     * no auto-ack, 32 byte static payloads on pipe 0. A receiving peer is left listening.
+     */
+    inline void configure_peer(nrf_emu::radio& peer, bool receive){
+        command(peer, {0x20, static_cast<u8>(receive ? 0x03 : 0x02)});
+        command(peer, {0x23, 0x01});
+        command(peer, {0x24, 0x53});
+        command(peer, {0x2A, 0x03, 0x03, 0x03});
+        command(peer, {0x30, 0x03, 0x03, 0x03});
+        command(peer, {0x26, 0x24});
+        command(peer, {0x25, 0x02});
+        command(peer, {0x31, 32});
+        command(peer, {0x21, 0x00});
+        command(peer, {0x22, 0x03});
+        esp_host::advance_us(2000);
+        if (receive) {
+            set_ce(peer, true);
+            esp_host::advance_us(200);
+        }
+    }
+
+    /**
+     * @brief loads a 32 byte payload into a transmitting peer and pulses CE, returns once the frame is on air
+     */
+    inline void peer_send(nrf_emu::radio& peer, const std::vector<u8>& payload){
+        std::vector<u8> tx(33, 0);
+        tx[0] = 0xA0;
+        for (size_t i = 0; i < payload.size() && i < 32; ++i) {
+            tx[i + 1] = payload[i];
+        }
+        command(peer, tx);
+        set_ce(peer, true);
+        esp_host::advance_us(20);
+        set_ce(peer, false);
+        esp_host::advance_us(2000);
+    }
+
+    /**
+     * @brief a raw radio resending one 32 byte no-ack payload back to back on channel, about 90% airtime at 250 kbps,
+     * until its CE drops
+     */
+    inline void start_jammer(nrf_emu::radio& jammer, u8 channel){
+        command(jammer, {0x20, 0x02});
+        command(jammer, {0x21, 0x00});
+        command(jammer, {0x26, 0x26});
+        command(jammer, {0x25, channel});
+        esp_host::advance_us(2000);
+        std::vector<u8> payload(33, 0x55);
+        payload[0] = 0xA0;
+        command(jammer, payload);
+        command(jammer, {0xE3});
+        set_ce(jammer, true);
+    }
+
+    /**
+     * @brief pops the oldest 32 byte payload from a peer's RX FIFO
+     */
+    inline std::vector<u8> peer_receive(nrf_emu::radio& peer){
+        std::vector<u8> tx(33, 0xFF);
+        tx[0] = 0x61;
+        std::vector<u8> rx = command(peer, tx);
+        command(peer, {0x27, 0x40});
+        return std::vector<u8>(rx.begin() + 1, rx.end());
+    }
+}
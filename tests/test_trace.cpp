@@ -0,0 +1,129 @@
+#include "test_support.hpp"
+
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+using namespace nrf_test;
+
+static_assert(NRF_TRACE_ENABLED, "test_trace links nrf24_host_trace, the driver built with its trace points");
+
+namespace {
+    /**
+     * @brief runs trace_ring::dump with stdout redirected into path, as a console capture would see it
+     */
+    bool capture_dump(const trace_ring& trace, const char* path){
+        std::fflush(stdout);
+        const int saved = dup(STDOUT_FILENO);
+        if (saved < 0 || std::freopen(path, "w", stdout) == nullptr) {
+            return false;
+        }
+        trace.dump();
+        std::fflush(stdout);
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+        return true;
+    }
+
+    std::vector<std::string> run_decoder(const std::string& command){
+        std::vector<std::string> lines;
+        FILE* pipe = popen(command.c_str(), "r");
+        if (pipe == nullptr) {
+            return lines;
+        }
+        char line[256];
+        while (std::fgets(line, sizeof(line), pipe) != nullptr) {
+            lines.emplace_back(line);
+        }
+        NRF_CHECK(pclose(pipe) == 0);
+        return lines;
+    }
+
+    // decoded lines start with the timestamp and the event name, the columns print_record writes
+    bool line_matches(const std::string& line, const trace_record_T& record){
+        unsigned timestamp_us = 0;
+        char event[16] = {};
+        if (std::sscanf(line.c_str(), "%u us +%*u %15s", &timestamp_us, event) != 2) {
+            return false;
+        }
+        return timestamp_us == record.timestamp_us && std::strcmp(event, trace_event_name(record.event)) == 0;
+    }
+
+    size_t count_events(const trace_record_T* records, size_t count, Trace_Event event, u8 reg = 0){
+        size_t found = 0;
+        for (size_t i = 0; i < count; ++i) {
+            found += records[i].event == static_cast<u8>(event) && (reg == 0 || records[i].reg == reg);
+        }
+        return found;
+    }
+}
+
+/**
+ * A transmit and a receive recorded into a trace_ring, exported with dump() the way a console would capture it and
+ * turned back into text by nrf_trace_decode, both from the console capture and from a raw binary snapshot.
+ * argv[1] is the decoder executable.
+ */
+int main(int argc, char** argv){
+    NRF_CHECK(argc == 2);
+    const std::string decoder = argv[1];
+
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer(medium, 99, 17, 18);
+    configure_peer(peer, true);
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    static trace_ring trace;
+    radio.attach_trace(trace);
+
+    u8 message[32] = { 0x5A };
+    NRF_CHECK(radio.transmit_data(message, 1));
+    NRF_CHECK(peer.rx_fifo_count() == 1 && peer_receive(peer)[0] == 0x5A);
+
+    configure_peer(peer, false);
+    packet_ring<4> ring;
+    radio.attach_rx_ring(ring);
+    peer_send(peer, {0xA5});
+    NRF_CHECK(radio.service_irq() == 1);
+    rx_packet_T packet = {};
+    NRF_CHECK(ring.pop(packet) && packet.data[0] == 0xA5);
+    radio.detach_rx_ring();
+    radio.detach_trace();
+
+    trace_record_T records[trace_ring::capacity] = {};
+    const size_t count = trace.snapshot(records, trace_ring::capacity);
+    NRF_CHECK(count > 0 && count == trace.recorded());
+    NRF_CHECK(count_events(records, count, Trace_Event::Mode_Tx) == 1);
+    NRF_CHECK(count_events(records, count, Trace_Event::Command, 0xA0) == 1);
+    NRF_CHECK(count_events(records, count, Trace_Event::Tx_Sent) == 1);
+    NRF_CHECK(count_events(records, count, Trace_Event::Mode_Rx) >= 1);
+    NRF_CHECK(count_events(records, count, Trace_Event::Command, 0x61) == 1);
+    NRF_CHECK(count_events(records, count, Trace_Event::Rx_Drain) == 1);
+
+    const std::string text_path = "test_trace_console.log";
+    const std::string binary_path = "test_trace.bin";
+    NRF_CHECK(capture_dump(trace, text_path.c_str()));
+    FILE* binary = std::fopen(binary_path.c_str(), "wb");
+    NRF_CHECK(binary != nullptr && std::fwrite(records, sizeof(trace_record_T), count, binary) == count);
+    std::fclose(binary);
+
+    // every record survives the console round trip, in order, and the binary path decodes to the same text
+    const std::vector<std::string> from_console = run_decoder(decoder + " < " + text_path);
+    const std::vector<std::string> from_binary = run_decoder(decoder + " -b " + binary_path);
+    NRF_CHECK(from_console.size() == count);
+    for (size_t i = 0; i < count; ++i) {
+        NRF_CHECK(line_matches(from_console[i], records[i]));
+    }
+    NRF_CHECK(from_console == from_binary);
+    bool saw_payload = false;
+    for (const std::string& line : from_console) {
+        saw_payload |= line.find("W_TX_PAYLOAD, 33 bytes") != std::string::npos;
+    }
+    NRF_CHECK(saw_payload);
+
+    std::remove(text_path.c_str());
+    std::remove(binary_path.c_str());
+    std::puts("test_trace passed");
+    return 0;
+}
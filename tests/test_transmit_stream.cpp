@@ -0,0 +1,107 @@
+#include "test_support.hpp"
+
+#include <set>
+
+using namespace nrf_test;
+
+namespace {
+    constexpr size_t packet_count = 40;
+
+    struct stream_log_T{
+        nrf_emu::radio* peer;
+        int64_t consumer_us;                // time on_complete takes, long enough for more packets to finish
+        std::vector<size_t> reported;       // indices in the order on_complete saw them
+        std::set<size_t> delivered;
+        std::set<size_t> received;          // first payload byte of every frame the peer took in
+        size_t frames = 0;                  // frames the peer took in, more than received.size() if one was sent twice
+    };
+
+    void drain_peer(stream_log_T& log){
+        while (log.peer->rx_fifo_count() != 0) {
+            log.received.insert(peer_receive(*log.peer)[0]);
+            log.frames++;
+        }
+    }
+
+    void on_complete(size_t index, bool delivered, void* context){
+        stream_log_T& log = *static_cast<stream_log_T*>(context);
+        log.reported.push_back(index);
+        if (delivered) {
+            log.delivered.insert(index);
+        }
+        drain_peer(log);
+        esp_host::advance_us(log.consumer_us);
+    }
+
+    stream_log_T stream(NRF24& radio, nrf_emu::radio& peer, bool no_ack, int64_t consumer_us = 0){
+        std::vector<std::array<u8, 32>> payloads(packet_count);
+        std::vector<tx_packet_T> packets(packet_count);
+        for (size_t i = 0; i < packet_count; ++i) {
+            payloads[i].fill(0);
+            payloads[i][0] = static_cast<u8>(i);
+            packets[i] = { payloads[i].data(), 32, no_ack };
+        }
+        stream_log_T log{ &peer, consumer_us, {}, {}, {}, 0 };
+        const size_t delivered = radio.transmit_stream(packets.data(), packets.size(), on_complete, &log);
+        esp_host::advance_us(5000);
+        drain_peer(log);
+
+        // every packet reported exactly once and in order, and the return value matches the reports
+        NRF_CHECK(log.reported.size() == packet_count);
+        for (size_t i = 0; i < packet_count; ++i) {
+            NRF_CHECK(log.reported[i] == i);
+        }
+        NRF_CHECK(delivered == log.delivered.size());
+        NRF_CHECK(radio.last_stream_stats().delivered + radio.last_stream_stats().failed == packet_count);
+        // a packet is only reloaded when it never reached the radio, so none goes out twice
+        NRF_CHECK(log.frames == log.received.size());
+        return log;
+    }
+}
+
+/**
+ * transmit_stream reports one completion per packet, in order, whatever the poll timing: TX_DS is sticky and can
+ * stand for more than one packet, so deliveries are checked against what the peer really received, on a clean
+ * and on a lossy link where MAX_RT must be pinned on the packet that failed.
+ */
+int main(){
+    nrf_emu::air medium;
+    nrf_emu::radio dut(medium, dut_csn, dut_ce, dut_irq);
+    nrf_emu::radio peer(medium, -1, -1);
+    configure_peer(peer, true);
+    command(peer, {0x21, 0x01});
+
+    spi_object spi;
+    NRF24 radio(spi, dut_pins(), 32);
+    pipe_config_T pipe;
+    pipe.address = { 0x03, 0x03, 0x03 };
+    pipe.auto_ack = true;
+    NRF_CHECK(radio.configure_pipe(0, pipe));
+
+    // clean link, acknowledged: everything arrives and is reported delivered
+    stream_log_T clean = stream(radio, peer, false);
+    NRF_CHECK(clean.delivered.size() == packet_count);
+    NRF_CHECK(clean.received.size() == packet_count);
+    NRF_CHECK(radio.state() == Radio_State::RxActive);
+
+    // a slow consumer lets several packets finish between two polls, each still counts once
+    stream_log_T unacknowledged = stream(radio, peer, true, 4000);
+    NRF_CHECK(unacknowledged.delivered.size() == packet_count);
+    NRF_CHECK(unacknowledged.received.size() == packet_count);
+
+    // lossy link: a packet reported delivered was received, and a failed one is not counted as delivered
+    medium.set_config({ 0.4, 0, 1 });
+    dut.reset_counters();
+    stream_log_T lossy = stream(radio, peer, false, 2500);
+    NRF_CHECK(dut.counters().max_rt_events > 0);
+    NRF_CHECK(lossy.delivered.size() < packet_count);
+    for (size_t index : lossy.delivered) {
+        NRF_CHECK(lossy.received.count(index) == 1);
+    }
+    NRF_CHECK(radio.last_stream_stats().failed == dut.counters().max_rt_events);
+    medium.set_config({});
+
+    NRF_CHECK(radio.verify());
+    std::puts("test_transmit_stream passed");
+    return 0;
+}
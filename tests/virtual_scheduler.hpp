@@ -0,0 +1,136 @@
+
+#pragma once
+
+#include "radio_timing.hpp"
+#include "esp_host.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace nrf_test {
+
+    /**
+     * @brief Runs several drivers against one emulated air, each on its own thread but one at a time in virtual
+     * time. A driver waiting through the radio_clock_T from clock() hands over to whichever node wakes first and
+     * the clock jumps to that wake-up, so listens, backoffs and dwell times of different nodes interleave. Reading
+     * the clock also hands over to nodes whose wake-up has passed, so a driver busy polling STATUS does not hold
+     * the others back longer than one SPI transfer.
+     */
+    class virtual_scheduler{
+        public:
+            /**
+             * @brief clock for each NRF24 taking part, outside run() its waits simply advance virtual time
+             */
+            radio_clock_T clock(){
+                return {
+                    [](void* context) -> int64_t { return static_cast<virtual_scheduler*>(context)->now(); },
+                    [](uint32_t us, void* context) { static_cast<virtual_scheduler*>(context)->sleep(us); },
+                    this
+                };
+            }
+
+            /**
+             * @brief runs every task on its own thread until all have returned, the first one starts first
+             */
+            void run(const std::vector<std::function<void()>>& tasks){
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_us_.assign(tasks.size(), esp_host::now_us());
+                done_.assign(tasks.size(), false);
+                running_ = -1;
+
+                std::vector<std::thread> threads;
+                for (size_t i = 0; i < tasks.size(); ++i) {
+                    threads.emplace_back([this, i, &tasks]{
+                        self_ = static_cast<int>(i);
+                        {
+                            std::unique_lock<std::mutex> wait_lock(mutex_);
+                            changed_.wait(wait_lock, [this, i]{ return running_ == static_cast<int>(i); });
+                        }
+                        tasks[i]();
+                        std::unique_lock<std::mutex> finish_lock(mutex_);
+                        done_[i] = true;
+                        hand_over();
+                    });
+                }
+
+                hand_over();
+                changed_.wait(lock, [this]{ return running_ == -1 && all_done(); });
+                lock.unlock();
+                for (std::thread& thread : threads) {
+                    thread.join();
+                }
+                wake_us_.clear();
+                done_.clear();
+            }
+
+        private:
+            std::mutex mutex_;
+            std::condition_variable changed_;
+            std::vector<int64_t> wake_us_;
+            std::vector<bool> done_;
+            int running_ = -1;
+            static inline thread_local int self_ = -1;
+
+            bool all_done() const{
+                for (bool done : done_) {
+                    if (!done) return false;
+                }
+                return true;
+            }
+
+            /**
+             * @brief with mutex_ held, wakes the node due first and moves the clock to its wake-up
+             */
+            void hand_over(){
+                int next = -1;
+                for (size_t i = 0; i < wake_us_.size(); ++i) {
+                    if (!done_[i] && (next < 0 || wake_us_[i] < wake_us_[next])) {
+                        next = static_cast<int>(i);
+                    }
+                }
+                if (next >= 0) {
+                    esp_host::advance_us(wake_us_[next] - esp_host::now_us());
+                }
+                running_ = next;
+                changed_.notify_all();
+            }
+
+            /**
+             * @brief a driver reading the clock is polling, nodes whose wake-up has passed meanwhile run first
+             */
+            int64_t now(){
+                const int64_t now_us = esp_host::now_us();
+                if (self_ < 0) {
+                    return now_us;
+                }
+                std::unique_lock<std::mutex> lock(mutex_);
+                const int self = self_;
+                bool overdue = false;
+                for (size_t i = 0; i < wake_us_.size(); ++i) {
+                    overdue = overdue || (static_cast<int>(i) != self && !done_[i] && wake_us_[i] < now_us);
+                }
+                if (overdue) {
+                    wake_us_[self] = now_us;
+                    hand_over();
+                    changed_.wait(lock, [this, self]{ return running_ == self; });
+                }
+                return esp_host::now_us();
+            }
+
+            void sleep(uint32_t us){
+                if (self_ < 0) {
+                    esp_host::advance_us(us);
+                    return;
+                }
+                std::unique_lock<std::mutex> lock(mutex_);
+                const int self = self_;
+                wake_us_[self] = esp_host::now_us() + us;
+                hand_over();
+                changed_.wait(lock, [this, self]{ return running_ == self; });
+            }
+    };
+}